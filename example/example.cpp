@@ -48,27 +48,19 @@ int main(int argc, char** argv)
 
     bool ret = true;
 
-    float temp  = 0.0;
-    float Acc_X = 0.0;
-    float Acc_Y = 0.0;
-    float Acc_Z = 0.0;
+    sca3300Sample sample;
 
     /* Call temperature and acceleration */
     for (int i = 0; i < 10; ++i)
     {
-        /* Ask for acceleration */
-        ret &= sca3300Chip.GetAccel( ACCEL_X, Acc_X );
-        ret &= sca3300Chip.GetAccel( ACCEL_Y, Acc_Y );
-        ret &= sca3300Chip.GetAccel( ACCEL_Z, Acc_Z );
-
-        /* Ask for temperature */
-        ret &= sca3300Chip.GetTemperature( temp );
+        /* Ask for a complete X, Y, Z, temperature and status cycle */
+        ret &= sca3300Chip.ReadSample( sample );
 
         /* Print accelerations */
-        printf (" Temperature: %f\n",temp);
-        printf (" Accel_X: %f\n",Acc_X);
-        printf (" Accel_Y: %f\n",Acc_Y);
-        printf (" Accel_Z: %f\n",Acc_Z);
+        printf (" Temperature: %f\n",sample.st_Temp);
+        printf (" Accel_X: %f\n",sample.st_Accel[ACCEL_X]);
+        printf (" Accel_Y: %f\n",sample.st_Accel[ACCEL_Y]);
+        printf (" Accel_Z: %f\n",sample.st_Accel[ACCEL_Z]);
 
         sleep(1);
     }
@@ -0,0 +1,421 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-array.cpp
+ * @brief Several SCA3300 on several SPI buses, one pinned worker per bus
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // strerror...
+#include <cstdio> // sscanf
+#include <pthread.h>
+#include <sched.h>
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-array.h"
+#include "sca3300-tools.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      SPI bus number of a spidev device path.
+ *
+ * @param[in]  aDevice  e.g. "/dev/spidev1.0"
+ *
+ * @return     1 for "/dev/spidev1.0", -1 if aDevice is not a spidev path
+ */
+int sca3300d01::SpiBusFromDevice( const std::string &aDevice )
+{
+    unsigned int bus, chipSelect;
+    char end;
+
+    if ( 2 != sscanf( aDevice.c_str(), "/dev/spidev%u.%u%c", &bus, &chipSelect, &end ) )
+        return -1;
+
+    return (int)bus;
+}
+
+
+/**
+ * @brief      a is before b, tick numbers wrap
+ */
+static inline bool IsBefore( const uint32_t a, const uint32_t b )
+{
+    return (int32_t)( a - b ) < 0;
+}
+
+
+sca3300Array::sca3300Array()
+    : running( false ), periodUs( 0 ), startNs( 0 )
+{
+}
+
+
+sca3300Array::~sca3300Array()
+{
+    this->Stop();
+}
+
+
+/**
+ * @brief      Add a sensor, it takes the next index of sca3300ArraySample::st_Sensors.
+ *
+ * @param[in]  aSensor  Initialized sensor, not streaming
+ * @param[in]  aBus     SPI bus it is wired to (see SpiBusFromDevice), sensors
+ *                      of the same bus are read by the same worker
+ *
+ * @return     false while streaming, with ARRAY_MAX_SENSORS sensors or an invalid sensor
+ */
+bool sca3300Array::AddSensor( std::unique_ptr<sca3300> aSensor, const int aBus )
+{
+    if ( this->running || !aSensor || aBus < 0 || this->sensors.size() >= ARRAY_MAX_SENSORS )
+    {
+        LOG_ERROR("could not add a sensor on bus %d", aBus);
+        return false;
+    }
+
+    this->sensors.push_back( std::move( aSensor ) );
+    this->sensorBus.push_back( aBus );
+
+    return true;
+}
+
+
+/**
+ * @brief      Sensor for settings (ChangeMode...) while the array is stopped.
+ *
+ * @return     nullptr if aIndex is out of the array
+ */
+sca3300 *sca3300Array::GetSensor( const size_t aIndex ) const
+{
+    return aIndex < this->sensors.size() ? this->sensors[aIndex].get() : nullptr;
+}
+
+
+/**
+ * @brief      CPU the worker of a bus runs on.
+ *
+ * @param[in]  aBus  SPI bus
+ * @param[in]  aCpu  CPU number, ARRAY_CPU_NONE or ARRAY_CPU_AUTO (default)
+ *
+ * @return     false while streaming
+ */
+bool sca3300Array::SetBusCpu( const int aBus, const int aCpu )
+{
+    if ( this->running || aBus < 0 || aCpu < ARRAY_CPU_AUTO )
+        return false;
+
+    this->busCpu[aBus] = aCpu;
+
+    return true;
+}
+
+
+/**
+ * @brief      Start one worker per bus.
+ *
+ * @param[in]  aPeriodUs  Sampling period, 0 to acquire as fast as possible
+ *                        (the buses are then not aligned in time)
+ *
+ * @return     false if already streaming, without sensor, or if a sensor streams on its own
+ */
+bool sca3300Array::Start( const uint32_t aPeriodUs )
+{
+    if ( this->running || this->sensors.empty() )
+        return false;
+
+    for (const auto &sensor : this->sensors)
+    {
+        if ( sensor->IsStreaming() )
+        {
+            LOG_ERROR("a sensor of the array is already streaming");
+            return false;
+        }
+    }
+
+    // Workers of the last run (ended, not joined if Stop() was not called)
+    this->Stop();
+    this->workers.clear();
+
+    // One worker per bus, in order of first appearance
+    for (size_t i = 0; i < this->sensors.size(); ++i)
+    {
+        busWorker *worker = nullptr;
+
+        for (const auto &w : this->workers)
+        {
+            if ( w->bus == this->sensorBus[i] )
+                worker = w.get();
+        }
+
+        if ( nullptr == worker )
+        {
+            this->workers.emplace_back( new busWorker( this->sensorBus[i] ) );
+            worker = this->workers.back().get();
+        }
+
+        worker->sensors.push_back( i );
+    }
+
+    for (const auto &worker : this->workers)
+    {
+        const auto cpu = this->busCpu.find( worker->bus );
+
+        worker->cpu = ( this->busCpu.end() != cpu ) ? cpu->second : ARRAY_CPU_AUTO;
+    }
+
+    // Automatic pinning: the CPUs this process may run on and no worker
+    // is pinned to, one per worker in order, shared only if they run out
+    std::vector<int> allowed, free;
+    cpu_set_t set;
+
+    if ( 0 == sched_getaffinity( 0, sizeof(set), &set ) )
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if ( CPU_ISSET( cpu, &set ) )
+                allowed.push_back( cpu );
+        }
+    }
+
+    for (const int cpu : allowed)
+    {
+        bool taken = false;
+
+        for (const auto &worker : this->workers)
+            taken |= ( worker->cpu == cpu );
+
+        if ( !taken )
+            free.push_back( cpu );
+    }
+
+    if ( free.empty() )
+        free = allowed;
+
+    size_t next = 0;
+
+    for (const auto &worker : this->workers)
+    {
+        if ( ARRAY_CPU_AUTO == worker->cpu )
+            worker->cpu = free.empty() ? ARRAY_CPU_NONE : free[next++ % free.size()];
+    }
+
+    this->periodUs = aPeriodUs;
+    this->startNs  = GetMonotonicNs();
+    this->running  = true;
+
+    for (const auto &worker : this->workers)
+        worker->thread = std::thread( &sca3300Array::WorkerLoop, this, worker.get() );
+
+    return true;
+}
+
+
+/**
+ * @brief      Stop the workers and wait for them.
+ *
+ * @note       Ticks already acquired can still be popped.
+ */
+void sca3300Array::Stop( void )
+{
+    this->running = false;
+
+    for (const auto &worker : this->workers)
+    {
+        if ( worker->thread.joinable() )
+            worker->thread.join();
+    }
+}
+
+
+/**
+ * @brief      Are the workers running?
+ */
+bool sca3300Array::IsStreaming( void ) const
+{
+    return this->running;
+}
+
+
+/**
+ * @brief      Get the oldest complete ticks, never blocks.
+ *
+ * @note       A tick is complete once every bus has acquired it or a later
+ *             one, so the slowest bus sets the pace. After Stop(), the
+ *             ticks past the last one of a bus are dropped. Only one
+ *             thread may consume.
+ *
+ * @param[out] aSamples  Destination
+ * @param[in]  aMax      Size of aSamples
+ *
+ * @return     Number of ticks copied
+ */
+size_t sca3300Array::PopSamples( sca3300ArraySample *aSamples, const size_t aMax )
+{
+    size_t count = 0;
+
+    while ( count < aMax && !this->workers.empty() )
+    {
+        bool complete = true;
+        bool any      = false;
+        uint32_t tick = 0;
+
+        for (const auto &worker : this->workers)
+        {
+            if ( !worker->hasPending )
+                worker->hasPending = ( 1 == worker->ring.Pop( &worker->pending, 1 ) );
+
+            // Bus not there yet, or stopped before this tick
+            if ( !worker->hasPending )
+                complete = false;
+
+            if ( worker->hasPending && ( !any || IsBefore( worker->pending.sequence, tick ) ) )
+            {
+                tick = worker->pending.sequence;
+                any  = true;
+            }
+        }
+
+        if ( !complete || !any )
+            break;
+
+        sca3300ArraySample &sample = aSamples[count++];
+
+        sample = sca3300ArraySample();
+        sample.st_Sequence  = tick;
+        sample.st_NbSensors = this->sensors.size();
+
+        for (size_t i = 0; i < this->sensors.size(); ++i)
+            sample.st_Sensors[i].st_Sequence = tick;
+
+        bool first = true;
+
+        for (const auto &worker : this->workers)
+        {
+            if ( !worker->hasPending || worker->pending.sequence != tick )
+                continue; // Missed by this bus: its sensors stay invalid
+
+            if ( first || worker->pending.timestamp < sample.st_Timestamp )
+                sample.st_Timestamp = worker->pending.timestamp;
+            first = false;
+
+            for (size_t k = 0; k < worker->sensors.size(); ++k)
+                sample.st_Sensors[worker->sensors[k]] = worker->pending.samples[k];
+
+            worker->hasPending = false;
+        }
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief      Ticks dropped because a bus ring was full (consumer too slow).
+ */
+uint64_t sca3300Array::GetOverruns( void ) const
+{
+    uint64_t overruns = 0;
+
+    for (const auto &worker : this->workers)
+        overruns += worker->ring.GetOverruns();
+
+    return overruns;
+}
+
+
+/**
+ * @brief      Ticks skipped by the workers because a bus cycle took longer than the period.
+ */
+uint64_t sca3300Array::GetMissedDeadlines( void ) const
+{
+    uint64_t missed = 0;
+
+    for (const auto &worker : this->workers)
+        missed += worker->missedDeadlines.load( std::memory_order_relaxed );
+
+    return missed;
+}
+
+
+/**
+ * @brief      Worker of a bus: read its sensors on every tick.
+ *
+ * @details    Deadlines are absolute and common to the workers:
+ *             deadline(n) = start + n * period, n is the tick sequence.
+ */
+void sca3300Array::WorkerLoop( busWorker *aWorker )
+{
+    if ( aWorker->cpu >= 0 )
+    {
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        CPU_SET( aWorker->cpu, &set );
+
+        const int err = pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+
+        if ( 0 != err )
+        {
+            LOG_ERROR("bus %d: could not pin the worker on CPU %d: %s", aWorker->bus, aWorker->cpu, strerror( err ));
+        }
+    }
+
+    const int64_t period = (int64_t)this->periodUs * 1000;
+
+    int64_t  deadline = this->startNs;
+    uint32_t sequence = 0;
+
+    while ( this->running )
+    {
+        busTick tick;
+
+        tick.timestamp = ( 0 == period ) ? GetMonotonicNs() : deadline;
+        tick.sequence  = sequence;
+
+        for (size_t k = 0; k < aWorker->sensors.size(); ++k)
+        {
+            sca3300RawSample &sample = tick.samples[k];
+
+            sample = sca3300RawSample();
+            sample.st_Timestamp = GetMonotonicNs();
+            this->sensors[aWorker->sensors[k]]->ReadRawSample( sample );
+            sample.st_Sequence  = sequence;
+        }
+
+        aWorker->ring.Push( tick );
+        sequence++;
+
+        if ( 0 == period )
+            continue;
+
+        deadline += period;
+
+        const int64_t now = GetMonotonicNs();
+        if ( now >= deadline )
+        {
+            const int64_t late = ( now - deadline ) / period + 1;
+
+            aWorker->missedDeadlines += late;
+            deadline += late * period;
+            sequence += late;
+        }
+
+        SleepUntilNs( deadline );
+    }
+}
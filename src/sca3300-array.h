@@ -0,0 +1,129 @@
+/**
+ * \class sca3300Array
+ *
+ * \brief Several SCA3300 sampled together, one acquisition thread per SPI bus.
+ *
+ * Sensors sharing a bus (/dev/spidev1.0, /dev/spidev1.1...) are read one
+ * after the other by the worker of that bus, buses are independent
+ * hardware and their workers run in parallel, each pinned to a CPU. Every
+ * worker follows the same absolute deadlines start + n * period, so tick
+ * n is the same instant on every bus; a worker late on a deadline skips
+ * the tick (counted) instead of shifting its numbering.
+ *
+ * PopSamples() merges the buses tick by tick: one sca3300ArraySample per
+ * tick with the common timestamp and sequence, the sensors in AddSensor()
+ * order. A sensor whose bus missed the tick is left invalid.
+ *
+ * \note The sensors belong to the array: while it streams they must not
+ *       be used directly nor streamed on their own.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_ARRAY_H_
+#define SCA3300_ARRAY_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300.h"
+#include "sca3300-ring.h"
+
+namespace sca3300d01
+{
+  constexpr size_t ARRAY_MAX_SENSORS = 8;
+  constexpr size_t ARRAY_RING_CAPACITY = 1024; // ticks per bus
+  constexpr int ARRAY_CPU_AUTO = -2;           // next allowed CPU (sched_getaffinity), shared only when there are more workers
+  constexpr int ARRAY_CPU_NONE = -1;           // not pinned
+
+  /**
+   * @brief      One tick of every sensor of the array
+   */
+  struct sca3300ArraySample
+  {
+    int64_t st_Timestamp = 0;                       /**< Tick time, common to the sensors (ns, CLOCK_MONOTONIC) */
+    uint32_t st_Sequence = 0;                       /**< Tick number since Start() */
+    uint32_t st_NbSensors = 0;                      /**< Sensors in st_Sensors */
+    sca3300RawSample st_Sensors[ARRAY_MAX_SENSORS]; /**< AddSensor() order, st_Timestamp is the actual read time */
+  };
+
+  int SpiBusFromDevice( const std::string &aDevice );
+
+  class sca3300Array
+  {
+      public:
+          sca3300Array();
+          ~sca3300Array();
+
+          sca3300Array( const sca3300Array & ) = delete;
+          sca3300Array &operator=( const sca3300Array & ) = delete;
+
+          bool AddSensor( std::unique_ptr<sca3300> aSensor, const int aBus );
+          size_t GetSensorCount( void ) const { return this->sensors.size(); }
+          sca3300 *GetSensor( const size_t aIndex ) const;
+
+          bool SetBusCpu( const int aBus, const int aCpu );
+
+          bool Start( const uint32_t aPeriodUs );
+          void Stop( void );
+          bool IsStreaming( void ) const;
+
+          // Single consumer side
+          size_t PopSamples( sca3300ArraySample *aSamples, const size_t aMax );
+          uint64_t GetOverruns( void ) const;
+          uint64_t GetMissedDeadlines( void ) const;
+
+      private:
+          /**
+           * @brief      One tick of the sensors of a bus
+           */
+          struct busTick
+          {
+            int64_t timestamp;
+            uint32_t sequence;
+            sca3300RawSample samples[ARRAY_MAX_SENSORS];  /**< busWorker::sensors order */
+          };
+
+          /**
+           * @brief      Acquisition thread of a bus and its merge state
+           */
+          struct busWorker
+          {
+            int bus;
+            int cpu;
+            std::vector<size_t> sensors;                  /**< Indexes in sca3300Array::sensors */
+            std::thread thread;
+            sca3300Ring<busTick> ring;
+            std::atomic<uint64_t> missedDeadlines;
+
+            // Consumer side
+            busTick pending;
+            bool hasPending;
+
+            explicit busWorker( const int aBus )
+                : bus( aBus ), cpu( ARRAY_CPU_NONE ), ring( ARRAY_RING_CAPACITY ),
+                  missedDeadlines( 0 ), hasPending( false ) {}
+          };
+
+          std::vector< std::unique_ptr<sca3300> > sensors;
+          std::vector<int> sensorBus;
+          std::map<int, int> busCpu;
+
+          std::vector< std::unique_ptr<busWorker> > workers;
+          std::atomic<bool> running;
+          uint32_t periodUs;
+          int64_t startNs;
+
+          void WorkerLoop( busWorker *aWorker );
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_ARRAY_H_
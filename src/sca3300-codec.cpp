@@ -0,0 +1,644 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-codec.cpp
+ * @brief Delta, zig-zag and frame of reference bit packing of raw samples
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // memcpy...
+#include <algorithm> // min, max...
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-codec.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Consts ********************************************** */
+#define CODEC_LANES          8                               /* 16 bit lanes per vector */
+#define CODEC_ROWS           ( (int)( sca3300d01::CODEC_BLOCK_VALUES / CODEC_LANES ) )
+#define CODEC_VALIDITY_BYTES ( sca3300d01::CODEC_BLOCK_VALUES / 8 )
+#define CODEC_BLOCK_MAGIC    0x4B4C4243 /* "CBLK" */
+#define CODEC_MIN_BLOCK      ( sizeof(sca3300CodecBlockHeader) + CODEC_VALIDITY_BYTES + \
+                               sca3300Codec::NB_CHANNELS * sizeof(sca3300CodecHeader) )
+
+static_assert( sca3300d01::CODEC_BLOCK_VALUES % CODEC_LANES == 0 && CODEC_ROWS == 16, "Codec packs 16 rows of 8 lanes" );
+
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/*============================================================================*/
+/*                                BIT PACKING                                 */
+/*============================================================================*/
+/*
+ * Vertical layout: value k * 8 + j goes to lane j. The 16 values of a lane
+ * are packed LSB first in the 16 bit words of that lane, so aBits words
+ * per lane, aBits vectors of 16 bytes for the block. The scalar code
+ * produces the same bytes.
+ */
+
+/**
+ * @brief      Pack CODEC_BLOCK_VALUES values below 2^aBits
+ */
+static void Pack( const uint16_t *aIn, const int aBits, uint8_t *aOut )
+{
+    if ( 0 == aBits )
+        return;
+
+    int offset = 0;
+
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+
+    for (int k = 0; k < CODEC_ROWS; ++k)
+    {
+        const __m128i v = _mm_loadu_si128( (const __m128i *)( aIn + k * CODEC_LANES ) );
+
+        acc = _mm_or_si128( acc, _mm_sll_epi16( v, _mm_cvtsi32_si128( offset ) ) );
+        offset += aBits;
+
+        if ( offset >= 16 )
+        {
+            _mm_storeu_si128( (__m128i *)aOut, acc );
+            aOut += 16;
+            offset -= 16;
+
+            // High bits of v that did not fit
+            acc = ( 0 == offset ) ? _mm_setzero_si128() : _mm_srl_epi16( v, _mm_cvtsi32_si128( aBits - offset ) );
+        }
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    uint16x8_t acc = vdupq_n_u16( 0 );
+
+    for (int k = 0; k < CODEC_ROWS; ++k)
+    {
+        const uint16x8_t v = vld1q_u16( aIn + k * CODEC_LANES );
+
+        acc = vorrq_u16( acc, vshlq_u16( v, vdupq_n_s16( offset ) ) );
+        offset += aBits;
+
+        if ( offset >= 16 )
+        {
+            vst1q_u8( aOut, vreinterpretq_u8_u16( acc ) );
+            aOut += 16;
+            offset -= 16;
+
+            acc = ( 0 == offset ) ? vdupq_n_u16( 0 ) : vshlq_u16( v, vdupq_n_s16( offset - aBits ) );
+        }
+    }
+#else
+    uint16_t acc[CODEC_LANES] = { 0 };
+
+    for (int k = 0; k < CODEC_ROWS; ++k)
+    {
+        const uint16_t *v = aIn + k * CODEC_LANES;
+
+        for (int j = 0; j < CODEC_LANES; ++j)
+            acc[j] |= (uint16_t)( v[j] << offset );
+        offset += aBits;
+
+        if ( offset >= 16 )
+        {
+            for (int j = 0; j < CODEC_LANES; ++j)
+            {
+                aOut[2 * j]     = (uint8_t)acc[j];
+                aOut[2 * j + 1] = (uint8_t)( acc[j] >> 8 );
+            }
+            aOut += 16;
+            offset -= 16;
+
+            for (int j = 0; j < CODEC_LANES; ++j)
+                acc[j] = ( 0 == offset ) ? 0 : (uint16_t)( v[j] >> ( aBits - offset ) );
+        }
+    }
+#endif
+}
+
+
+/**
+ * @brief      Unpack CODEC_BLOCK_VALUES values of aBits bits
+ */
+static void Unpack( const uint8_t *aIn, const int aBits, uint16_t *aOut )
+{
+    if ( 0 == aBits )
+    {
+        std::fill( aOut, aOut + CODEC_BLOCK_VALUES, 0 );
+        return;
+    }
+
+    const uint16_t mask = (uint16_t)( ( 1u << aBits ) - 1 );
+    int offset = 0;
+
+#if defined(__SSE2__)
+    const __m128i vmask = _mm_set1_epi16( (short)mask );
+    __m128i current = _mm_loadu_si128( (const __m128i *)aIn );
+
+    for (int k = 0; k < CODEC_ROWS; ++k)
+    {
+        __m128i v = _mm_srl_epi16( current, _mm_cvtsi32_si128( offset ) );
+        offset += aBits;
+
+        if ( offset >= 16 && k + 1 < CODEC_ROWS )
+        {
+            aIn += 16;
+            current = _mm_loadu_si128( (const __m128i *)aIn );
+            offset -= 16;
+
+            // Low bits of the next word
+            if ( offset > 0 )
+                v = _mm_or_si128( v, _mm_sll_epi16( current, _mm_cvtsi32_si128( aBits - offset ) ) );
+        }
+
+        _mm_storeu_si128( (__m128i *)( aOut + k * CODEC_LANES ), _mm_and_si128( v, vmask ) );
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint16x8_t vmask = vdupq_n_u16( mask );
+    uint16x8_t current = vreinterpretq_u16_u8( vld1q_u8( aIn ) );
+
+    for (int k = 0; k < CODEC_ROWS; ++k)
+    {
+        uint16x8_t v = vshlq_u16( current, vdupq_n_s16( -offset ) );
+        offset += aBits;
+
+        if ( offset >= 16 && k + 1 < CODEC_ROWS )
+        {
+            aIn += 16;
+            current = vreinterpretq_u16_u8( vld1q_u8( aIn ) );
+            offset -= 16;
+
+            if ( offset > 0 )
+                v = vorrq_u16( v, vshlq_u16( current, vdupq_n_s16( aBits - offset ) ) );
+        }
+
+        vst1q_u16( aOut + k * CODEC_LANES, vandq_u16( v, vmask ) );
+    }
+#else
+    uint16_t current[CODEC_LANES];
+
+    for (int j = 0; j < CODEC_LANES; ++j)
+        current[j] = (uint16_t)( aIn[2 * j] | aIn[2 * j + 1] << 8 );
+
+    for (int k = 0; k < CODEC_ROWS; ++k)
+    {
+        uint16_t *v = aOut + k * CODEC_LANES;
+
+        for (int j = 0; j < CODEC_LANES; ++j)
+            v[j] = ( offset < 16 ) ? (uint16_t)( current[j] >> offset ) : 0;
+        offset += aBits;
+
+        if ( offset >= 16 && k + 1 < CODEC_ROWS )
+        {
+            aIn += 16;
+            offset -= 16;
+
+            for (int j = 0; j < CODEC_LANES; ++j)
+            {
+                current[j] = (uint16_t)( aIn[2 * j] | aIn[2 * j + 1] << 8 );
+
+                if ( offset > 0 )
+                    v[j] |= (uint16_t)( current[j] << ( aBits - offset ) );
+            }
+        }
+
+        for (int j = 0; j < CODEC_LANES; ++j)
+            v[j] &= mask;
+    }
+#endif
+}
+
+
+/*============================================================================*/
+/*                                  VALUES                                    */
+/*============================================================================*/
+
+static inline uint16_t ZigZag( const uint16_t aValue )
+{
+    return (uint16_t)( ( aValue << 1 ) ^ ( ( aValue & 0x8000 ) ? 0xFFFF : 0 ) );
+}
+
+static inline uint16_t UnZigZag( const uint16_t aValue )
+{
+    return (uint16_t)( ( aValue >> 1 ) ^ ( ( aValue & 1 ) ? 0xFFFF : 0 ) );
+}
+
+
+/**
+ * @brief      Encode a channel block
+ *
+ * @param[in]  aValues     The values
+ * @param[in]  aCount      Number of values, 1 to CODEC_BLOCK_VALUES
+ * @param[in]  aPredictor  Delta or second order delta
+ * @param[out] aOut        Room for CODEC_MAX_ENCODED bytes
+ *
+ * @return     Bytes written, 0 if aCount is out of range
+ */
+size_t sca3300d01::EncodeValues( const int16_t *aValues, const size_t aCount, const codecPredictor aPredictor, uint8_t *aOut )
+{
+    if ( 0 == aCount || aCount > CODEC_BLOCK_VALUES )
+        return 0;
+
+    // Modulo 2^16 arithmetic: any residual is exact
+    uint16_t residuals[CODEC_BLOCK_VALUES];
+    uint16_t previous = (uint16_t)aValues[0];
+    uint16_t delta    = 0;
+
+    for (size_t i = 1; i < aCount; ++i)
+    {
+        const uint16_t value = (uint16_t)aValues[i];
+        const uint16_t d     = (uint16_t)( value - previous );
+
+        residuals[i] = ZigZag( ( CODEC_DELTA2 == aPredictor ) ? (uint16_t)( d - delta ) : d );
+
+        delta    = d;
+        previous = value;
+    }
+
+    uint16_t low = 0xFFFF, high = 0;
+    for (size_t i = 1; i < aCount; ++i)
+    {
+        low  = std::min( low, residuals[i] );
+        high = std::max( high, residuals[i] );
+    }
+    if ( 1 == aCount )
+        low = high = 0;
+
+    // Unused slots pack as 0
+    residuals[0] = low;
+    std::fill( residuals + aCount, residuals + CODEC_BLOCK_VALUES, low );
+
+    for (size_t i = 0; i < CODEC_BLOCK_VALUES; ++i)
+        residuals[i] = (uint16_t)( residuals[i] - low );
+
+    int bits = 0;
+    while ( bits < 16 && ( high - low ) >> bits )
+        ++bits;
+
+    sca3300CodecHeader header;
+
+    header.st_Predictor = (uint8_t)aPredictor;
+    header.st_Bits      = (uint8_t)bits;
+    header.st_Count     = (uint16_t)aCount;
+    header.st_First     = (uint16_t)aValues[0];
+    header.st_Reference = low;
+
+    memcpy( aOut, &header, sizeof(header) );
+    Pack( residuals, bits, aOut + sizeof(header) );
+
+    return sizeof(header) + 16 * bits;
+}
+
+
+/**
+ * @brief      Decode a channel block
+ *
+ * @param[in]  aIn     Encoded block
+ * @param[in]  aSize   Bytes available in aIn
+ * @param[out] aValues Room for CODEC_BLOCK_VALUES values
+ * @param[out] aCount  Number of values decoded
+ *
+ * @return     Bytes consumed, 0 if the block is invalid or truncated
+ */
+size_t sca3300d01::DecodeValues( const uint8_t *aIn, const size_t aSize, int16_t *aValues, size_t &aCount )
+{
+    sca3300CodecHeader header;
+
+    if ( aSize < sizeof(header) )
+        return 0;
+
+    memcpy( &header, aIn, sizeof(header) );
+
+    const size_t size = sizeof(header) + 16 * header.st_Bits;
+
+    if ( header.st_Bits > 16 || 0 == header.st_Count || header.st_Count > CODEC_BLOCK_VALUES || size > aSize ||
+         ( CODEC_DELTA != header.st_Predictor && CODEC_DELTA2 != header.st_Predictor ) )
+    {
+        LOG_ERROR("invalid codec block");
+        return 0;
+    }
+
+    uint16_t residuals[CODEC_BLOCK_VALUES];
+    Unpack( aIn + sizeof(header), header.st_Bits, residuals );
+
+    uint16_t value = header.st_First;
+    uint16_t delta = 0;
+
+    aValues[0] = (int16_t)value;
+
+    for (size_t i = 1; i < header.st_Count; ++i)
+    {
+        const uint16_t r = UnZigZag( (uint16_t)( residuals[i] + header.st_Reference ) );
+
+        delta = ( CODEC_DELTA2 == header.st_Predictor ) ? (uint16_t)( delta + r ) : r;
+        value = (uint16_t)( value + delta );
+
+        aValues[i] = (int16_t)value;
+    }
+
+    aCount = header.st_Count;
+
+    return size;
+}
+
+
+/**
+ * @brief      Decode a sample block from its bytes (GetData() of a sca3300Codec)
+ *
+ * @param[in]  aIn       Encoded block, starting with its sca3300CodecBlockHeader
+ * @param[in]  aSize     Bytes available in aIn
+ * @param[out] aSamples  Room for CODEC_BLOCK_VALUES samples
+ * @param[out] aCount    Number of samples decoded
+ *
+ * @return     Bytes consumed (the next block follows), 0 if the block is invalid or truncated
+ */
+size_t sca3300d01::DecodeSampleBlock( const uint8_t *aIn, const size_t aSize, sca3300RawSample *aSamples, size_t &aCount )
+{
+    sca3300CodecBlockHeader header;
+
+    if ( aSize < sizeof(header) )
+        return 0;
+
+    memcpy( &header, aIn, sizeof(header) );
+
+    if ( CODEC_BLOCK_MAGIC != header.st_Magic || header.st_Size < CODEC_MIN_BLOCK || header.st_Size > aSize ||
+         0 == header.st_Count || header.st_Count > CODEC_BLOCK_VALUES )
+    {
+        LOG_ERROR("invalid codec sample block");
+        return 0;
+    }
+
+    const uint8_t *validity = aIn + sizeof(header);
+    size_t position = sizeof(header) + CODEC_VALIDITY_BYTES;
+
+    int16_t values[CODEC_BLOCK_VALUES];
+    uint32_t steps[CODEC_BLOCK_VALUES];
+
+    for (int channel = 0; channel < sca3300Codec::NB_CHANNELS; ++channel)
+    {
+        size_t count = 0;
+        const size_t used = DecodeValues( aIn + position, header.st_Size - position, values, count );
+
+        if ( 0 == used || count != header.st_Count )
+            return 0;
+
+        position += used;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if ( channel < 3 )
+                aSamples[i].st_Accel[channel] = values[i];
+            else if ( 3 == channel )
+                aSamples[i].st_Temp = (uint16_t)values[i];
+            else if ( 4 == channel )
+                aSamples[i].st_Status = (uint16_t)values[i];
+            else if ( 5 == channel )
+                steps[i] = (uint16_t)values[i];
+            else
+                steps[i] |= (uint32_t)(uint16_t)values[i] << 16;
+        }
+    }
+
+    int64_t timestamp = header.st_FirstTimestamp;
+
+    for (size_t i = 0; i < header.st_Count; ++i)
+    {
+        if ( i > 0 )
+            timestamp += steps[i];
+
+        aSamples[i].st_Sequence  = header.st_FirstSequence + i;
+        aSamples[i].st_Timestamp = timestamp;
+        aSamples[i].st_Mode      = header.st_Mode;
+        aSamples[i].st_IsValid   = 0 != ( validity[i / 8] & ( 1 << ( i % 8 ) ) );
+    }
+
+    if ( timestamp != header.st_LastTimestamp )
+    {
+        LOG_ERROR("codec sample block with inconsistent timestamps");
+        return 0;
+    }
+
+    aCount = header.st_Count;
+
+    return header.st_Size;
+}
+
+
+/*============================================================================*/
+/*                                   CODEC                                    */
+/*============================================================================*/
+
+/**
+ * @brief   Constructor.
+ *
+ * @param[in]   aPredictor  { Predictor of every channel }
+ */
+sca3300Codec::sca3300Codec( const codecPredictor aPredictor )
+{
+    this->predictor = aPredictor;
+    this->nbSamples = 0;
+    this->pending.reserve( CODEC_BLOCK_VALUES );
+}
+
+
+/**
+ * @brief      Forget every block.
+ */
+void sca3300Codec::Clear( void )
+{
+    this->data.clear();
+    this->index.clear();
+    this->pending.clear();
+    this->nbSamples = 0;
+}
+
+
+/**
+ * @brief      Replace the blocks by encoded bytes (GetData() of a codec).
+ *
+ * @note       Only the block headers are checked, DecodeBlock() checks the
+ *             channels.
+ *
+ * @param[in]  aData  Sample blocks, one after the other
+ * @param[in]  aSize  Bytes
+ *
+ * @return     false (and nothing loaded) if a block header is invalid or truncated
+ */
+bool sca3300Codec::Load( const uint8_t *aData, const size_t aSize )
+{
+    this->Clear();
+
+    size_t offset = 0;
+
+    while ( offset < aSize )
+    {
+        sca3300CodecBlockHeader header;
+
+        if ( aSize - offset < sizeof(header) )
+            break;
+
+        memcpy( &header, aData + offset, sizeof(header) );
+
+        if ( CODEC_BLOCK_MAGIC != header.st_Magic || header.st_Size < CODEC_MIN_BLOCK || header.st_Size > aSize - offset ||
+             0 == header.st_Count || header.st_Count > CODEC_BLOCK_VALUES )
+            break;
+
+        this->index.push_back( offset );
+        this->nbSamples += header.st_Count;
+        offset += header.st_Size;
+    }
+
+    if ( offset != aSize )
+    {
+        LOG_ERROR("invalid codec sample block at byte %zu", offset);
+        this->Clear();
+        return false;
+    }
+
+    this->data.assign( aData, aData + aSize );
+
+    return true;
+}
+
+
+/**
+ * @brief      Compress samples, full blocks are encoded right away.
+ *
+ * @param[in]  aSamples  The samples, in acquisition order
+ * @param[in]  aCount    Number of samples
+ */
+void sca3300Codec::Append( const sca3300RawSample *aSamples, const size_t aCount )
+{
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        const sca3300RawSample &sample = aSamples[i];
+
+        if ( !this->pending.empty() )
+        {
+            const sca3300RawSample &last = this->pending.back();
+
+            const int64_t step = sample.st_Timestamp - last.st_Timestamp;
+
+            if ( sample.st_Sequence != last.st_Sequence + 1 || sample.st_Mode != last.st_Mode ||
+                 step < 0 || step > UINT32_MAX )
+                this->Flush();
+        }
+
+        this->pending.push_back( sample );
+        this->nbSamples++;
+
+        if ( CODEC_BLOCK_VALUES == this->pending.size() )
+            this->Flush();
+    }
+}
+
+
+/**
+ * @brief      Encode the pending samples as a (short) block.
+ */
+void sca3300Codec::Flush( void )
+{
+    const size_t count = this->pending.size();
+
+    if ( 0 == count )
+        return;
+
+    const uint64_t offset = this->data.size();
+
+    this->data.resize( offset + sizeof(sca3300CodecBlockHeader) + CODEC_VALIDITY_BYTES + NB_CHANNELS * CODEC_MAX_ENCODED );
+    uint8_t *out = &this->data[offset];
+
+    // Validity bitmap
+    uint8_t *validity = out + sizeof(sca3300CodecBlockHeader);
+
+    std::fill( validity, validity + CODEC_VALIDITY_BYTES, 0 );
+    for (size_t i = 0; i < count; ++i)
+        if ( this->pending[i].st_IsValid )
+            validity[i / 8] |= (uint8_t)( 1 << ( i % 8 ) );
+
+    // Time steps, the first one repeats the second: nothing to pack when periodic
+    uint32_t steps[CODEC_BLOCK_VALUES];
+
+    for (size_t i = 1; i < count; ++i)
+        steps[i] = (uint32_t)( this->pending[i].st_Timestamp - this->pending[i - 1].st_Timestamp );
+    steps[0] = ( count > 1 ) ? steps[1] : 0;
+
+    size_t size = sizeof(sca3300CodecBlockHeader) + CODEC_VALIDITY_BYTES;
+    int16_t values[CODEC_BLOCK_VALUES];
+
+    for (int channel = 0; channel < NB_CHANNELS; ++channel)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const sca3300RawSample &sample = this->pending[i];
+
+            if ( channel < 3 )
+                values[i] = sample.st_Accel[channel];
+            else if ( 3 == channel )
+                values[i] = (int16_t)sample.st_Temp;
+            else if ( 4 == channel )
+                values[i] = (int16_t)sample.st_Status;
+            else
+                values[i] = (int16_t)( ( 5 == channel ) ? steps[i] : steps[i] >> 16 );
+        }
+
+        size += EncodeValues( values, count, this->predictor, out + size );
+    }
+
+    sca3300CodecBlockHeader header;
+    memset( &header, 0, sizeof(header) );
+
+    header.st_Magic          = CODEC_BLOCK_MAGIC;
+    header.st_Size           = (uint32_t)size;
+    header.st_FirstTimestamp = this->pending.front().st_Timestamp;
+    header.st_LastTimestamp  = this->pending.back().st_Timestamp;
+    header.st_FirstSequence  = this->pending.front().st_Sequence;
+    header.st_Count          = (uint16_t)count;
+    header.st_Mode           = this->pending.front().st_Mode;
+
+    memcpy( out, &header, sizeof(header) );
+
+    this->data.resize( offset + size );
+    this->index.push_back( offset );
+    this->pending.clear();
+}
+
+
+/**
+ * @brief      Decode one block, independently of the others.
+ *
+ * @param[in]  aBlock    Block number, below GetBlockCount()
+ * @param[out] aSamples  Room for CODEC_BLOCK_VALUES samples
+ *
+ * @return     Number of samples, 0 if aBlock is out of range or corrupted
+ */
+size_t sca3300Codec::DecodeBlock( const size_t aBlock, sca3300RawSample *aSamples ) const
+{
+    if ( aBlock >= this->index.size() )
+        return 0;
+
+    const uint64_t offset = this->index[aBlock];
+    size_t count = 0;
+
+    if ( 0 == DecodeSampleBlock( &this->data[offset], this->data.size() - offset, aSamples, count ) )
+        return 0;
+
+    return count;
+}
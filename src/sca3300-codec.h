@@ -0,0 +1,114 @@
+/**
+ * \class sca3300Codec
+ *
+ * \brief Lossless compression of raw sample streams, block by block.
+ *
+ * Each channel (X, Y, Z, temperature, status) of a block of up to
+ * CODEC_BLOCK_VALUES samples is encoded on its own:
+ *  - prediction: delta or second order delta (modulo 2^16, lossless)
+ *  - zig-zag: small signed residuals become small unsigned ones
+ *  - frame of reference: minus the block minimum, packed on the bit
+ *    width of the block range, 8 lanes of 16 bits at a time (SSE2, NEON)
+ *
+ * At rest the residuals are a few LSB, 3 to 5 bits instead of 16. Every
+ * block starts with a sca3300CodecBlockHeader (size, count, first
+ * sequence, first and last timestamps, mode), so any block can be decoded
+ * without the others and GetData() is self-contained: Load() indexes it
+ * back, DecodeSampleBlock() decodes a block from its bytes. Timestamps
+ * are exact: the steps between samples (ns, 32 bits) are two more
+ * channels, nothing at all for a periodic acquisition. A sequence gap, a
+ * mode change or a step beyond 4.29 s closes the block.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_CODEC_H_
+#define SCA3300_CODEC_H_
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  static_assert( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Codec format is little endian" );
+
+  constexpr size_t CODEC_BLOCK_VALUES = 128;
+
+  enum codecPredictor
+  {
+    CODEC_DELTA  = 1,   /**< r[i] = v[i] - v[i-1] */
+    CODEC_DELTA2 = 2,   /**< r[i] = v[i] - 2 v[i-1] + v[i-2] */
+  };
+
+  /**
+   * @brief      Header of an encoded channel block, followed by 16 * st_Bits bytes
+   */
+  struct sca3300CodecHeader
+  {
+    uint8_t st_Predictor;
+    uint8_t st_Bits;        /**< Packed width, 0 to 16 */
+    uint16_t st_Count;      /**< Values in the block */
+    uint16_t st_First;      /**< First value, not predicted */
+    uint16_t st_Reference;  /**< Frame of reference: minimum zig-zag residual */
+  };
+
+  static_assert( sizeof(sca3300CodecHeader) == 8, "Codec header layout" );
+
+  constexpr size_t CODEC_MAX_ENCODED = sizeof(sca3300CodecHeader) + CODEC_BLOCK_VALUES * sizeof(uint16_t);
+
+  /**
+   * @brief      Header of a sample block, followed by the validity bitmap
+   *             and the encoded channels
+   */
+  struct sca3300CodecBlockHeader
+  {
+    uint32_t st_Magic;          /**< CODEC_BLOCK_MAGIC */
+    uint32_t st_Size;           /**< Bytes of the block, this header included */
+    int64_t st_FirstTimestamp;  /**< ns */
+    int64_t st_LastTimestamp;   /**< ns, check of the decoded steps */
+    uint32_t st_FirstSequence;
+    uint16_t st_Count;          /**< Samples in the block */
+    uint8_t st_Mode;
+    uint8_t st_Reserved;
+  };
+
+  static_assert( sizeof(sca3300CodecBlockHeader) == 32, "Codec block header layout" );
+
+  size_t EncodeValues( const int16_t *aValues, const size_t aCount, const codecPredictor aPredictor, uint8_t *aOut );
+  size_t DecodeValues( const uint8_t *aIn, const size_t aSize, int16_t *aValues, size_t &aCount );
+  size_t DecodeSampleBlock( const uint8_t *aIn, const size_t aSize, sca3300RawSample *aSamples, size_t &aCount );
+
+  class sca3300Codec
+  {
+      public:
+          static const int NB_CHANNELS = 7; // X, Y, Z, temperature, status, time step low and high words
+
+          explicit sca3300Codec( const codecPredictor aPredictor = CODEC_DELTA );
+
+          void Append( const sca3300RawSample *aSamples, const size_t aCount );
+          void Flush( void );
+          void Clear( void );
+          bool Load( const uint8_t *aData, const size_t aSize );
+
+          size_t GetBlockCount( void ) const { return this->index.size(); }
+          uint64_t GetSampleCount( void ) const { return this->nbSamples; }
+          const std::vector<uint8_t> &GetData( void ) const { return this->data; }
+
+          size_t DecodeBlock( const size_t aBlock, sca3300RawSample *aSamples ) const;
+
+      private:
+          codecPredictor predictor;
+
+          std::vector<uint8_t> data;
+          std::vector<uint64_t> index;           /**< Offset of every block in data */
+          std::vector<sca3300RawSample> pending; /**< Block being filled */
+          uint64_t nbSamples;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_CODEC_H_
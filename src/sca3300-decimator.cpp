@@ -0,0 +1,217 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-decimator.cpp
+ * @brief Integer decimation of the raw sample stream
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // memset...
+#include <algorithm> // min, max...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-decimator.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      Divide, rounding half away from zero
+ */
+static inline int64_t RoundedDivide( const int64_t aValue, const int64_t aDivisor )
+{
+    return ( aValue >= 0 ? aValue + aDivisor / 2 : aValue - aDivisor / 2 ) / aDivisor;
+}
+
+
+/**
+ * @brief   Default constructor, no decimation.
+ */
+sca3300Decimator::sca3300Decimator()
+{
+    this->Configure( 1 );
+}
+
+
+/**
+ * @brief      Set the decimation.
+ *
+ * @note       The compensation FIR is [-a, 1 + 2a, -a] with a = aStages / 24,
+ *             the inverse of the sinc^N droop up to the second order term.
+ *
+ * @param[in]  aFactor        Input samples per output sample
+ * @param[in]  aStages        1 for a boxcar average, up to MAX_STAGES for a CIC
+ * @param[in]  aCompensation  Add the droop compensation FIR
+ *
+ * @return     false if the CIC gain does not fit the accumulators (nothing changed)
+ */
+bool sca3300Decimator::Configure( const uint32_t aFactor, const int aStages, const bool aCompensation )
+{
+    if ( 0 == aFactor || aStages < 1 || aStages > MAX_STAGES )
+    {
+        LOG_ERROR("invalid decimation: factor %u, %d stages", aFactor, aStages);
+        return false;
+    }
+
+    // Output before normalization: gain * 2^16 must fit in an int64_t
+    int64_t gain = 1;
+    for (int i = 0; i < aStages; ++i)
+    {
+        if ( gain > ( INT64_MAX >> 17 ) / aFactor )
+        {
+            LOG_ERROR("decimation gain overflow: factor %u, %d stages", aFactor, aStages);
+            return false;
+        }
+        gain *= aFactor;
+    }
+
+    this->factor       = aFactor;
+    this->stages       = aStages;
+    this->compensation = aCompensation;
+    this->gain         = gain;
+    this->compSide     = ( aStages * ( 1 << COMP_SHIFT ) + 12 ) / 24;
+    this->compCenter   = ( 1 << COMP_SHIFT ) + 2 * this->compSide;
+
+    this->Reset();
+
+    return true;
+}
+
+
+/**
+ * @brief      Forget the filter state.
+ */
+void sca3300Decimator::Reset( void )
+{
+    memset( this->integrators, 0, sizeof(this->integrators) );
+    memset( this->combs, 0, sizeof(this->combs) );
+    memset( this->history, 0, sizeof(this->history) );
+
+    this->primed   = false;
+    this->phase    = 0;
+    this->status   = 0;
+    this->isValid  = true;
+    this->sequence = 0;
+}
+
+
+uint32_t sca3300Decimator::GetFactor( void ) const
+{
+    return this->factor;
+}
+
+
+/**
+ * @brief      Decimate a block of raw samples.
+ *
+ * @note       Blocks may have any size, the state is kept between calls.
+ *             An output sample takes the timestamp of the last input sample
+ *             of its period, the OR of the statuses and the AND of the
+ *             validities. Acceleration counts keep the input mode.
+ *
+ * @param[in]  aIn     Raw samples at the input rate
+ * @param[in]  aCount  Number of input samples
+ * @param[out] aOut    Decimated samples, room for aCount / factor + 1 samples
+ *
+ * @return     Number of decimated samples written
+ */
+size_t sca3300Decimator::Process( const sca3300RawSample *aIn, const size_t aCount, sca3300RawSample *aOut )
+{
+    size_t nbOut = 0;
+
+    for (size_t n = 0; n < aCount; ++n)
+    {
+        const sca3300RawSample &in = aIn[n];
+        const int32_t values[NB_CHANNELS] = { in.st_Accel[0], in.st_Accel[1], in.st_Accel[2], in.st_Temp };
+
+        // Integrators, input rate (modular arithmetic)
+        for (int c = 0; c < NB_CHANNELS; ++c)
+        {
+            uint64_t acc = (uint64_t)(int64_t)values[c];
+
+            for (int s = 0; s < this->stages; ++s)
+            {
+                this->integrators[s][c] += acc;
+                acc = this->integrators[s][c];
+            }
+        }
+
+        this->status  |= in.st_Status;
+        this->isValid &= in.st_IsValid;
+
+        if ( ++this->phase < this->factor )
+            continue;
+
+        // Combs, output rate
+        int32_t decimated[NB_CHANNELS];
+
+        for (int c = 0; c < NB_CHANNELS; ++c)
+        {
+            uint64_t acc = this->integrators[this->stages - 1][c];
+
+            for (int s = 0; s < this->stages; ++s)
+            {
+                const uint64_t delayed = this->combs[s][c];
+                this->combs[s][c] = acc;
+                acc -= delayed;
+            }
+
+            decimated[c] = (int32_t)RoundedDivide( (int64_t)acc, this->gain );
+        }
+
+        if ( this->compensation )
+        {
+            if ( !this->primed )
+            {/* Start from a steady state instead of zeros */
+                for (int c = 0; c < NB_CHANNELS; ++c)
+                    this->history[0][c] = this->history[1][c] = decimated[c];
+                this->primed = true;
+            }
+
+            for (int c = 0; c < NB_CHANNELS; ++c)
+            {
+                const int64_t acc = (int64_t)this->compCenter * this->history[0][c] -
+                                    (int64_t)this->compSide * ( decimated[c] + this->history[1][c] );
+
+                this->history[1][c] = this->history[0][c];
+                this->history[0][c] = decimated[c];
+
+                decimated[c] = (int32_t)RoundedDivide( acc, 1 << COMP_SHIFT );
+            }
+        }
+
+        sca3300RawSample &out = aOut[nbOut++];
+
+        out.st_Timestamp = in.st_Timestamp;
+        out.st_Sequence  = this->sequence++;
+
+        for (int axe = 0; axe < 3; ++axe)
+            out.st_Accel[axe] = (int16_t)std::min( std::max( decimated[axe], (int32_t)INT16_MIN ), (int32_t)INT16_MAX );
+
+        out.st_Temp    = (uint16_t)std::min( std::max( decimated[3], (int32_t)0 ), (int32_t)UINT16_MAX );
+        out.st_Status  = this->status;
+        out.st_Mode    = in.st_Mode;
+        out.st_IsValid = this->isValid;
+
+        this->phase   = 0;
+        this->status  = 0;
+        this->isValid = true;
+    }
+
+    return nbOut;
+}
@@ -0,0 +1,67 @@
+/**
+ * \class sca3300Decimator
+ *
+ * \brief Integer decimation of the raw sample stream (boxcar or CIC).
+ *
+ * Every channel (X, Y, Z, temperature) goes through N integrator stages
+ * at the input rate and N comb stages at the output rate, one output for
+ * aFactor input samples. With one stage it is a boxcar average. The
+ * accumulators are modular 64 bit integers, as CIC filters need, and
+ * the output is normalized by aFactor^N, so decimated samples keep the
+ * counts of the measurement mode. An optional 3-tap FIR compensates the
+ * CIC passband droop (one output sample of delay). The first aStages
+ * outputs are the filter transient.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_DECIMATOR_H_
+#define SCA3300_DECIMATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  class sca3300Decimator
+  {
+      public:
+          static const int MAX_STAGES = 5;
+
+          sca3300Decimator();
+
+          bool Configure( const uint32_t aFactor, const int aStages = 1, const bool aCompensation = false );
+          size_t Process( const sca3300RawSample *aIn, const size_t aCount, sca3300RawSample *aOut );
+          void Reset( void );
+
+          uint32_t GetFactor( void ) const;
+
+      private:
+          static const int NB_CHANNELS = 4;   // X, Y, Z, temperature
+          static const int COMP_SHIFT  = 14;  // Q14 compensation taps
+
+          uint32_t factor;
+          int      stages;
+          bool     compensation;
+          int64_t  gain;                      /**< factor^stages */
+          int32_t  compSide;                  /**< Q14 outer taps (negated) */
+          int32_t  compCenter;                /**< Q14 center tap */
+
+          uint64_t integrators[MAX_STAGES][NB_CHANNELS];
+          uint64_t combs[MAX_STAGES][NB_CHANNELS];
+          int32_t  history[2][NB_CHANNELS];   /**< Compensation FIR: x[n-1], x[n-2] */
+          bool     primed;                    /**< history holds real outputs? */
+
+          // Current output period
+          uint32_t phase;
+          uint16_t status;
+          bool     isValid;
+          uint32_t sequence;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_DECIMATOR_H_
@@ -0,0 +1,380 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-decode.cpp
+ * @brief Batch decoding of received SPI frames
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // memcpy...
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCA3300_DECODE_X86
+#include <immintrin.h>
+#endif
+
+#if ( defined(__ARM_NEON) || defined(__ARM_NEON__) ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SCA3300_DECODE_NEON
+#include <arm_neon.h>
+#endif
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300def.h"
+#include "sca3300-tools.h"
+#include "sca3300-decode.h"
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace sca3300d01;
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/**
+ * @brief      CRC of the 24 MSB's of a frame, computed at compile time
+ */
+static constexpr uint8_t ConstCRC( const sca3300CrcTable &aTable, const uint32_t aFrame )
+{
+    uint8_t crc = 0xFF;
+
+    crc = aTable.st_Table[crc ^ (uint8_t)( aFrame >> 24 )];
+    crc = aTable.st_Table[crc ^ (uint8_t)( aFrame >> 16 )];
+    crc = aTable.st_Table[crc ^ (uint8_t)( aFrame >>  8 )];
+
+    return (uint8_t)~crc;
+}
+
+/**
+ * @brief      Nibble tables of the frame CRC
+ *
+ * @note       The CRC is affine in the message bits:
+ *             CRC(m) = st_Zero ^ st_Table[0][n0] ^ ... ^ st_Table[5][n5]
+ *             where n0 is the high nibble of the first byte and n5 the low
+ *             nibble of the third one. 16-entry tables fit a byte shuffle.
+ */
+struct crcNibbleTables
+{
+    uint8_t st_Table[6][16];
+    uint8_t st_Zero;
+
+    constexpr crcNibbleTables() : st_Table(), st_Zero( 0 )
+    {
+        const sca3300CrcTable table;
+
+        st_Zero = ConstCRC( table, 0 );
+
+        for (int k = 0; k < 6; ++k)
+            for (uint32_t n = 0; n < 16; ++n)
+                st_Table[k][n] = ConstCRC( table, n << ( 28 - 4 * k ) ) ^ st_Zero;
+    }
+};
+
+static constexpr crcNibbleTables CRC_NIBBLES;
+
+static_assert( ( CRC_NIBBLES.st_Zero ^ CRC_NIBBLES.st_Table[0][0x0] ^ CRC_NIBBLES.st_Table[1][0x4] ) == 0xF7,
+               "Nibble CRC does not match the datasheet (read ACC_X)" );
+static_assert( ( CRC_NIBBLES.st_Zero ^ CRC_NIBBLES.st_Table[0][0xB] ^ CRC_NIBBLES.st_Table[1][0x4] ^
+                 CRC_NIBBLES.st_Table[4][0x0] ^ CRC_NIBBLES.st_Table[5][0x2] ) == 0x25,
+               "Nibble CRC does not match the datasheet (change to mode 3)" );
+
+
+/**
+ * @brief      Reference implementation, one frame at a time
+ */
+static size_t DecodeScalar( const uint8_t *aRx, const size_t aFirst, const size_t aCount, const sca3300FrameBlock &aOut )
+{
+    size_t nbValid = 0;
+
+    for (size_t i = aFirst; i < aCount; ++i)
+    {
+        const uint8_t *frame = aRx + i * SCA3300_FRAME_SIZE_BYTES;
+        const uint32_t msb   = ( (uint32_t)frame[0] << 24 ) | ( frame[1] << 16 ) | ( frame[2] << 8 );
+        const bool     valid = CalculateCRC( msb ) == frame[3];
+
+        aOut.st_OpCode[i]       = frame[0] >> 2;
+        aOut.st_ReturnStatus[i] = frame[0] & 0x03;
+        aOut.st_Data[i]         = (uint16_t)( ( frame[1] << 8 ) | frame[2] );
+        aOut.st_CrcValid[i]     = valid ? 1 : 0;
+
+        nbValid += valid;
+    }
+
+    return nbValid;
+}
+
+
+#ifdef SCA3300_DECODE_X86
+/**
+ * @brief      SSSE3: 4 frames per 128 bit vector
+ *
+ * @note       Byte j of every frame sits in byte j of a 32 bit lane. Each
+ *             byte position is looked up with its own pair of nibble tables,
+ *             then bytes 0..2 are folded into byte 3 and compared with the
+ *             received CRC.
+ */
+__attribute__(( target( "ssse3" ) ))
+static size_t DecodeSsse3( const uint8_t *aRx, const size_t aCount, const sca3300FrameBlock &aOut )
+{
+    const __m128i nibble     = _mm_set1_epi8( 0x0F );
+    const __m128i gatherOp   = _mm_setr_epi8( 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 );
+    const __m128i gatherData = _mm_setr_epi8( 2, 1, 6, 5, 10, 9, 14, 13, -1, -1, -1, -1, -1, -1, -1, -1 );
+    const __m128i crcZero    = _mm_set1_epi32( (int)( (uint32_t)CRC_NIBBLES.st_Zero << 24 ) );
+
+    __m128i tableHi[3], tableLo[3], position[3];
+    for (int j = 0; j < 3; ++j)
+    {
+        tableHi[j]  = _mm_loadu_si128( (const __m128i *)CRC_NIBBLES.st_Table[2 * j] );
+        tableLo[j]  = _mm_loadu_si128( (const __m128i *)CRC_NIBBLES.st_Table[2 * j + 1] );
+        position[j] = _mm_set1_epi32( 0xFF << ( 8 * j ) );
+    }
+
+    size_t nbValid = 0;
+    size_t i = 0;
+
+    for ( ; i + 4 <= aCount; i += 4)
+    {
+        const __m128i frames = _mm_loadu_si128( (const __m128i *)( aRx + i * SCA3300_FRAME_SIZE_BYTES ) );
+        const __m128i hi = _mm_and_si128( _mm_srli_epi16( frames, 4 ), nibble );
+        const __m128i lo = _mm_and_si128( frames, nibble );
+
+        __m128i crc = _mm_setzero_si128();
+        for (int j = 0; j < 3; ++j)
+        {
+            const __m128i lookup = _mm_xor_si128( _mm_shuffle_epi8( tableHi[j], hi ), _mm_shuffle_epi8( tableLo[j], lo ) );
+            crc = _mm_xor_si128( crc, _mm_and_si128( lookup, position[j] ) );
+        }
+
+        // Fold bytes 0..2 into byte 3, then compare with the received CRC
+        crc = _mm_xor_si128( crc, _mm_slli_epi32( crc, 8 ) );
+        crc = _mm_xor_si128( crc, _mm_slli_epi32( crc, 16 ) );
+
+        const __m128i equal = _mm_cmpeq_epi8( _mm_xor_si128( _mm_xor_si128( crc, crcZero ), frames ), _mm_setzero_si128() );
+        const __m128i valid = _mm_srli_epi32( equal, 31 );
+        const __m128i op    = _mm_shuffle_epi8( frames, gatherOp );
+
+        const uint32_t opcodes  = _mm_cvtsi128_si32( _mm_and_si128( _mm_srli_epi16( op, 2 ), _mm_set1_epi8( 0x3F ) ) );
+        const uint32_t statuses = _mm_cvtsi128_si32( _mm_and_si128( op, _mm_set1_epi8( 0x03 ) ) );
+        const uint32_t flags    = _mm_cvtsi128_si32( _mm_shuffle_epi8( valid, gatherOp ) );
+
+        memcpy( aOut.st_OpCode + i, &opcodes, 4 );
+        memcpy( aOut.st_ReturnStatus + i, &statuses, 4 );
+        memcpy( aOut.st_CrcValid + i, &flags, 4 );
+        _mm_storel_epi64( (__m128i *)( aOut.st_Data + i ), _mm_shuffle_epi8( frames, gatherData ) );
+
+        nbValid += __builtin_popcount( _mm_movemask_epi8( equal ) & 0x8888 );
+    }
+
+    return nbValid + DecodeScalar( aRx, i, aCount, aOut );
+}
+
+
+/**
+ * @brief      AVX2: 8 frames per 256 bit vector, same algorithm as DecodeSsse3
+ *
+ * @note       vpshufb works inside each 128 bit half, which holds 4 whole
+ *             frames, the two halves are merged with a dword permutation.
+ */
+__attribute__(( target( "avx2" ) ))
+static size_t DecodeAvx2( const uint8_t *aRx, const size_t aCount, const sca3300FrameBlock &aOut )
+{
+    const __m256i nibble     = _mm256_set1_epi8( 0x0F );
+    const __m256i gatherOp   = _mm256_setr_epi8( 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 );
+    const __m256i gatherData = _mm256_setr_epi8( 2, 1, 6, 5, 10, 9, 14, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 2, 1, 6, 5, 10, 9, 14, 13, -1, -1, -1, -1, -1, -1, -1, -1 );
+    const __m256i mergeOp    = _mm256_setr_epi32( 0, 4, 0, 0, 0, 0, 0, 0 );
+    const __m256i mergeData  = _mm256_setr_epi32( 0, 1, 4, 5, 0, 0, 0, 0 );
+    const __m256i crcZero    = _mm256_set1_epi32( (int)( (uint32_t)CRC_NIBBLES.st_Zero << 24 ) );
+
+    __m256i tableHi[3], tableLo[3], position[3];
+    for (int j = 0; j < 3; ++j)
+    {
+        tableHi[j]  = _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)CRC_NIBBLES.st_Table[2 * j] ) );
+        tableLo[j]  = _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)CRC_NIBBLES.st_Table[2 * j + 1] ) );
+        position[j] = _mm256_set1_epi32( 0xFF << ( 8 * j ) );
+    }
+
+    size_t nbValid = 0;
+    size_t i = 0;
+
+    for ( ; i + 8 <= aCount; i += 8)
+    {
+        const __m256i frames = _mm256_loadu_si256( (const __m256i *)( aRx + i * SCA3300_FRAME_SIZE_BYTES ) );
+        const __m256i hi = _mm256_and_si256( _mm256_srli_epi16( frames, 4 ), nibble );
+        const __m256i lo = _mm256_and_si256( frames, nibble );
+
+        __m256i crc = _mm256_setzero_si256();
+        for (int j = 0; j < 3; ++j)
+        {
+            const __m256i lookup = _mm256_xor_si256( _mm256_shuffle_epi8( tableHi[j], hi ), _mm256_shuffle_epi8( tableLo[j], lo ) );
+            crc = _mm256_xor_si256( crc, _mm256_and_si256( lookup, position[j] ) );
+        }
+
+        crc = _mm256_xor_si256( crc, _mm256_slli_epi32( crc, 8 ) );
+        crc = _mm256_xor_si256( crc, _mm256_slli_epi32( crc, 16 ) );
+
+        const __m256i equal = _mm256_cmpeq_epi8( _mm256_xor_si256( _mm256_xor_si256( crc, crcZero ), frames ), _mm256_setzero_si256() );
+        const __m256i valid = _mm256_srli_epi32( equal, 31 );
+        const __m256i op    = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( frames, gatherOp ), mergeOp );
+
+        const __m256i opcodes  = _mm256_and_si256( _mm256_srli_epi16( op, 2 ), _mm256_set1_epi8( 0x3F ) );
+        const __m256i statuses = _mm256_and_si256( op, _mm256_set1_epi8( 0x03 ) );
+        const __m256i flags    = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( valid, gatherOp ), mergeOp );
+        const __m256i data     = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( frames, gatherData ), mergeData );
+
+        _mm_storel_epi64( (__m128i *)( aOut.st_OpCode + i ), _mm256_castsi256_si128( opcodes ) );
+        _mm_storel_epi64( (__m128i *)( aOut.st_ReturnStatus + i ), _mm256_castsi256_si128( statuses ) );
+        _mm_storel_epi64( (__m128i *)( aOut.st_CrcValid + i ), _mm256_castsi256_si128( flags ) );
+        _mm_storeu_si128( (__m128i *)( aOut.st_Data + i ), _mm256_castsi256_si128( data ) );
+
+        nbValid += __builtin_popcount( (uint32_t)_mm256_movemask_epi8( equal ) & 0x88888888 );
+    }
+
+    return nbValid + DecodeScalar( aRx, i, aCount, aOut );
+}
+#endif //SCA3300_DECODE_X86
+
+
+#ifdef SCA3300_DECODE_NEON
+/**
+ * @brief      16 nibble lookups in a 16-entry table (vtbl2, ARMv7 and AArch64)
+ */
+static inline uint8x16_t LookupNibbles( const uint8x8x2_t &aTable, const uint8x16_t aIndex )
+{
+    return vcombine_u8( vtbl2_u8( aTable, vget_low_u8( aIndex ) ), vtbl2_u8( aTable, vget_high_u8( aIndex ) ) );
+}
+
+
+/**
+ * @brief      NEON: 16 frames per iteration
+ *
+ * @note       vld4q_u8 de-interleaves the frames, val[j] holds byte j of
+ *             the 16 frames, so every field is one vector operation.
+ */
+static size_t DecodeNeon( const uint8_t *aRx, const size_t aCount, const sca3300FrameBlock &aOut )
+{
+    const uint8x16_t nibble = vdupq_n_u8( 0x0F );
+    const uint8x16_t one    = vdupq_n_u8( 1 );
+
+    uint8x8x2_t tables[6];
+    for (int k = 0; k < 6; ++k)
+    {
+        tables[k].val[0] = vld1_u8( CRC_NIBBLES.st_Table[k] );
+        tables[k].val[1] = vld1_u8( CRC_NIBBLES.st_Table[k] + 8 );
+    }
+
+    size_t nbValid = 0;
+    size_t i = 0;
+
+    for ( ; i + 16 <= aCount; i += 16)
+    {
+        const uint8x16x4_t frames = vld4q_u8( aRx + i * SCA3300_FRAME_SIZE_BYTES );
+
+        uint8x16_t crc = vdupq_n_u8( CRC_NIBBLES.st_Zero );
+        for (int j = 0; j < 3; ++j)
+        {
+            crc = veorq_u8( crc, LookupNibbles( tables[2 * j], vshrq_n_u8( frames.val[j], 4 ) ) );
+            crc = veorq_u8( crc, LookupNibbles( tables[2 * j + 1], vandq_u8( frames.val[j], nibble ) ) );
+        }
+
+        const uint8x16_t valid = vandq_u8( vceqq_u8( crc, frames.val[3] ), one );
+
+        vst1q_u8( aOut.st_OpCode + i, vshrq_n_u8( frames.val[0], 2 ) );
+        vst1q_u8( aOut.st_ReturnStatus + i, vandq_u8( frames.val[0], vdupq_n_u8( 0x03 ) ) );
+        vst1q_u8( aOut.st_CrcValid + i, valid );
+
+        // Little-endian uint16: low byte is the third frame byte
+        uint8x16x2_t data;
+        data.val[0] = frames.val[2];
+        data.val[1] = frames.val[1];
+        vst2q_u8( (uint8_t *)( aOut.st_Data + i ), data );
+
+        const uint64x2_t count = vpaddlq_u32( vpaddlq_u16( vpaddlq_u8( valid ) ) );
+        nbValid += vgetq_lane_u64( count, 0 ) + vgetq_lane_u64( count, 1 );
+    }
+
+    return nbValid + DecodeScalar( aRx, i, aCount, aOut );
+}
+#endif //SCA3300_DECODE_NEON
+
+
+/**
+ * @brief      Can this CPU run a decode path?
+ *
+ * @param[in]  aPath  The path
+ *
+ * @return     true if DecodeFrames will use it
+ */
+bool sca3300d01::IsDecodePathSupported( const decodePath aPath )
+{
+    switch ( aPath )
+    {
+        case DECODE_AUTO:
+        case DECODE_SCALAR:
+            return true;
+#ifdef SCA3300_DECODE_X86
+        case DECODE_SSSE3:
+            return __builtin_cpu_supports( "ssse3" );
+        case DECODE_AVX2:
+            return __builtin_cpu_supports( "avx2" );
+#endif
+#ifdef SCA3300_DECODE_NEON
+        case DECODE_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @brief      Decode a block of received frames
+ *
+ * @note       An unsupported path falls back to the scalar one, all paths
+ *             give the same results.
+ *
+ * @param[in]  aRx     aCount frames of SCA3300_FRAME_SIZE_BYTES bytes (MSB first)
+ * @param[in]  aCount  Number of frames
+ * @param[out] aOut    Decoded fields, every array holds at least aCount entries
+ * @param[in]  aPath   Implementation, DECODE_AUTO picks the fastest one
+ *
+ * @return     Number of frames with a valid CRC
+ */
+size_t sca3300d01::DecodeFrames( const uint8_t *aRx, const size_t aCount, const sca3300FrameBlock &aOut, const decodePath aPath )
+{
+    decodePath path = aPath;
+
+    if ( DECODE_AUTO == path )
+    {
+        if ( IsDecodePathSupported( DECODE_AVX2 ) )
+            path = DECODE_AVX2;
+        else if ( IsDecodePathSupported( DECODE_NEON ) )
+            path = DECODE_NEON;
+        else if ( IsDecodePathSupported( DECODE_SSSE3 ) )
+            path = DECODE_SSSE3;
+    }
+
+    if ( !IsDecodePathSupported( path ) )
+        path = DECODE_SCALAR;
+
+    switch ( path )
+    {
+#ifdef SCA3300_DECODE_X86
+        case DECODE_SSSE3:
+            return DecodeSsse3( aRx, aCount, aOut );
+        case DECODE_AVX2:
+            return DecodeAvx2( aRx, aCount, aOut );
+#endif
+#ifdef SCA3300_DECODE_NEON
+        case DECODE_NEON:
+            return DecodeNeon( aRx, aCount, aOut );
+#endif
+        default:
+            return DecodeScalar( aRx, 0, aCount, aOut );
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * \file  sca3300-decode.h
+ *
+ * \brief Batch decoding of received SPI frames.
+ *
+ * A block of raw frames (SCA3300_FRAME_SIZE_BYTES bytes each, MSB first,
+ * as received from the bus) is split into one array per field, so that
+ * large captures are decoded with the vector unit instead of one
+ * sca3300Frame at a time. The CRC is computed with six 16-entry nibble
+ * tables (the CRC is linear in the message bits), which maps on byte
+ * shuffles: pshufb on x86 (SSSE3, AVX2), vtbl on ARM (NEON). The scalar
+ * path is the reference, every vector path gives bit-exact results.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_DECODE_H_
+#define SCA3300_DECODE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sca3300d01
+{
+    /**
+     * @brief      Decoded frames, structure of arrays (one entry per frame)
+     *
+     * @note       Arrays are owned by the caller.
+     */
+    struct sca3300FrameBlock
+    {
+        uint8_t  *st_OpCode;       /**< [31:26] */
+        uint8_t  *st_ReturnStatus; /**< [25:24] */
+        uint16_t *st_Data;         /**< [23:8] */
+        uint8_t  *st_CrcValid;     /**< 1 if the CRC [7:0] is valid, 0 otherwise */
+    };
+
+    /**
+     * @brief      Implementations of DecodeFrames
+     */
+    enum decodePath
+    {
+      DECODE_AUTO,   /**< Best path supported by the CPU */
+      DECODE_SCALAR,
+      DECODE_SSSE3,  /**< 4 frames per iteration */
+      DECODE_AVX2,   /**< 8 frames per iteration */
+      DECODE_NEON,   /**< 16 frames per iteration */
+    };
+
+    bool IsDecodePathSupported( const decodePath aPath );
+    size_t DecodeFrames( const uint8_t *aRx, const size_t aCount, const sca3300FrameBlock &aOut, \
+                         const decodePath aPath = DECODE_AUTO );
+}
+
+#endif //SCA3300_DECODE_H_
@@ -0,0 +1,343 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-filter.cpp
+ * @brief Biquad / FIR filter bank over four SIMD lanes
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <math.h>
+#include <algorithm> // min...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-filter.h"
+#include "sca3300-simd.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/*============================================================================*/
+/*                                   DESIGN                                   */
+/*============================================================================*/
+
+/**
+ * @brief      Design a biquad (Audio EQ Cookbook, R. Bristow-Johnson)
+ *
+ * @param[in]  aType        Low-pass, high-pass or notch
+ * @param[in]  aSampleRate  Sampling rate (Hz)
+ * @param[in]  aFrequency   Cut-off or notch frequency (Hz), below aSampleRate / 2
+ * @param[in]  aQ           Quality factor, 0.7071 for Butterworth
+ * @param[out] aBiquad      Normalized coefficients
+ *
+ * @return     false if a parameter is out of range (aBiquad unchanged)
+ */
+bool sca3300d01::DesignBiquad( const filterType aType, const float aSampleRate, const float aFrequency,
+                               const float aQ, sca3300Biquad &aBiquad )
+{
+    if ( !( aSampleRate > 0.0f ) || !( aFrequency > 0.0f ) || !( aFrequency < aSampleRate / 2 ) || !( aQ > 0.0f ) )
+    {
+        LOG_ERROR("invalid biquad: %.3f Hz at %.3f Hz, Q %.3f", aFrequency, aSampleRate, aQ);
+        return false;
+    }
+
+    const double w0    = 2.0 * M_PI * aFrequency / aSampleRate;
+    const double cosW0 = cos( w0 );
+    const double alpha = sin( w0 ) / ( 2.0 * aQ );
+
+    double b0, b1, b2;
+
+    switch ( aType )
+    {
+        case FILTER_LOWPASS:
+            b0 = ( 1.0 - cosW0 ) / 2;
+            b1 = 1.0 - cosW0;
+            b2 = b0;
+            break;
+        case FILTER_HIGHPASS:
+            b0 = ( 1.0 + cosW0 ) / 2;
+            b1 = -( 1.0 + cosW0 );
+            b2 = b0;
+            break;
+        case FILTER_NOTCH:
+            b0 = 1.0;
+            b1 = -2.0 * cosW0;
+            b2 = 1.0;
+            break;
+        default:
+            LOG_ERROR("unknown filter type %d", aType);
+            return false;
+    }
+
+    const double a0 = 1.0 + alpha;
+
+    aBiquad.st_B0 = b0 / a0;
+    aBiquad.st_B1 = b1 / a0;
+    aBiquad.st_B2 = b2 / a0;
+    aBiquad.st_A1 = -2.0 * cosW0 / a0;
+    aBiquad.st_A2 = ( 1.0 - alpha ) / a0;
+
+    return true;
+}
+
+
+/**
+ * @brief      Design a linear phase FIR (Hamming windowed sinc)
+ *
+ * @note       Unity gain in the passband. The high-pass is the spectral
+ *             inversion of the low-pass, hence the odd number of taps.
+ *
+ * @param[in]  aType          Low-pass or high-pass
+ * @param[in]  aSampleRate    Sampling rate (Hz)
+ * @param[in]  aFrequency     Cut-off frequency (Hz), below aSampleRate / 2
+ * @param[in]  aTaps          Number of taps, odd
+ * @param[out] aCoefficients  The taps
+ *
+ * @return     false if a parameter is out of range (aCoefficients unchanged)
+ */
+bool sca3300d01::DesignFir( const filterType aType, const float aSampleRate, const float aFrequency,
+                            const size_t aTaps, std::vector<float> &aCoefficients )
+{
+    if ( !( aSampleRate > 0.0f ) || !( aFrequency > 0.0f ) || !( aFrequency < aSampleRate / 2 ) || 0 == ( aTaps & 1 ) )
+    {
+        LOG_ERROR("invalid FIR: %.3f Hz at %.3f Hz, %zu taps", aFrequency, aSampleRate, aTaps);
+        return false;
+    }
+
+    if ( FILTER_LOWPASS != aType && FILTER_HIGHPASS != aType )
+    {
+        LOG_ERROR("FIR type %d not supported", aType);
+        return false;
+    }
+
+    const double fc     = aFrequency / aSampleRate; // cycles per sample
+    const double middle = ( aTaps - 1 ) / 2.0;
+
+    vector<double> taps( aTaps );
+    double sum = 0.0;
+
+    for (size_t n = 0; n < aTaps; ++n)
+    {
+        const double x      = n - middle;
+        const double sinc   = ( 0.0 == x ) ? 2.0 * fc : sin( 2.0 * M_PI * fc * x ) / ( M_PI * x );
+        const double window = ( 1 == aTaps ) ? 1.0 : 0.54 - 0.46 * cos( 2.0 * M_PI * n / ( aTaps - 1 ) );
+
+        taps[n] = sinc * window;
+        sum += taps[n];
+    }
+
+    aCoefficients.resize( aTaps );
+
+    for (size_t n = 0; n < aTaps; ++n)
+    {
+        taps[n] /= sum;
+
+        if ( FILTER_HIGHPASS == aType )
+            taps[n] = ( n == aTaps / 2 ? 1.0 : 0.0 ) - taps[n];
+
+        aCoefficients[n] = (float)taps[n];
+    }
+
+    return true;
+}
+
+
+/*============================================================================*/
+/*                                FILTER BANK                                 */
+/*============================================================================*/
+
+/**
+ * @brief   Constructor, pass-through until filters are added.
+ *
+ * @param[in]   aFilterTemp  { Filter the temperature of sca3300Sample blocks too }
+ */
+sca3300FilterBank::sca3300FilterBank( const bool aFilterTemp )
+{
+    this->filterTemp  = aFilterTemp;
+    this->firPosition = 0;
+}
+
+
+/**
+ * @brief      Append a biquad to the cascade (state cleared)
+ */
+void sca3300FilterBank::AddBiquad( const sca3300Biquad &aBiquad )
+{
+    section newSection;
+
+    newSection.coefficients = aBiquad;
+    std::fill( newSection.s1, newSection.s1 + NB_LANES, 0.0f );
+    std::fill( newSection.s2, newSection.s2 + NB_LANES, 0.0f );
+
+    this->sections.push_back( newSection );
+}
+
+
+/**
+ * @brief      Set the FIR run after the biquads (delay line cleared)
+ *
+ * @param[in]  aCoefficients  The taps, empty to remove the FIR
+ */
+void sca3300FilterBank::SetFir( const std::vector<float> &aCoefficients )
+{
+    this->fir.assign( aCoefficients.rbegin(), aCoefficients.rend() );
+    this->firHistory.assign( 2 * this->fir.size() * NB_LANES, 0.0f );
+    this->firPosition = 0;
+}
+
+
+/**
+ * @brief      Remove every filter.
+ */
+void sca3300FilterBank::Clear( void )
+{
+    this->sections.clear();
+    this->SetFir( std::vector<float>() );
+}
+
+
+/**
+ * @brief      Clear the filter states, keep the coefficients.
+ */
+void sca3300FilterBank::Reset( void )
+{
+    for (section &current : this->sections)
+    {
+        std::fill( current.s1, current.s1 + NB_LANES, 0.0f );
+        std::fill( current.s2, current.s2 + NB_LANES, 0.0f );
+    }
+
+    std::fill( this->firHistory.begin(), this->firHistory.end(), 0.0f );
+    this->firPosition = 0;
+}
+
+
+/**
+ * @brief      Filter a block of interleaved frames.
+ *
+ * @note       One section at a time over the whole block, its state stays
+ *             in registers. The state is kept between calls. In place
+ *             filtering (aIn == aOut) is allowed.
+ *
+ * @param[in]  aIn     Frames of NB_LANES floats (X, Y, Z, T)
+ * @param[out] aOut    Filtered frames
+ * @param[in]  aCount  Number of frames
+ */
+void sca3300FilterBank::Process( const float *aIn, float *aOut, const size_t aCount )
+{
+    const float *in = aIn;
+
+    for (section &current : this->sections)
+    {
+        const v4f b0 = v4f::Set1( current.coefficients.st_B0 );
+        const v4f b1 = v4f::Set1( current.coefficients.st_B1 );
+        const v4f b2 = v4f::Set1( current.coefficients.st_B2 );
+        const v4f a1 = v4f::Set1( current.coefficients.st_A1 );
+        const v4f a2 = v4f::Set1( current.coefficients.st_A2 );
+
+        v4f s1 = v4f::Load( current.s1 );
+        v4f s2 = v4f::Load( current.s2 );
+
+        for (size_t n = 0; n < aCount; ++n)
+        {
+            const v4f x = v4f::Load( in + n * NB_LANES );
+            const v4f y = b0 * x + s1;
+
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+
+            y.Store( aOut + n * NB_LANES );
+        }
+
+        s1.Store( current.s1 );
+        s2.Store( current.s2 );
+
+        in = aOut;
+    }
+
+    const size_t taps = this->fir.size();
+
+    if ( 0 == taps )
+    {
+        if ( in != aOut )
+            std::copy( in, in + aCount * NB_LANES, aOut );
+        return;
+    }
+
+    // Delay line written twice, so the last taps frames are always contiguous
+    float *history = this->firHistory.data();
+
+    for (size_t n = 0; n < aCount; ++n)
+    {
+        const v4f x = v4f::Load( in + n * NB_LANES );
+
+        x.Store( history + this->firPosition * NB_LANES );
+        x.Store( history + ( this->firPosition + taps ) * NB_LANES );
+
+        this->firPosition = ( this->firPosition + 1 ) % taps;
+
+        const float *window = history + this->firPosition * NB_LANES; // oldest first
+        v4f acc = v4f::Set1( 0.0f );
+
+        for (size_t k = 0; k < taps; ++k)
+            acc = acc + v4f::Set1( this->fir[k] ) * v4f::Load( window + k * NB_LANES );
+
+        acc.Store( aOut + n * NB_LANES );
+    }
+}
+
+
+/**
+ * @brief      Filter acceleration (and temperature) of samples in place.
+ *
+ * @note       Invalid samples are filtered as the others, their values are
+ *             what was read.
+ *
+ * @param      aSamples  The samples
+ * @param[in]  aCount    Number of samples
+ */
+void sca3300FilterBank::Process( sca3300Sample *aSamples, const size_t aCount )
+{
+    const size_t CHUNK = 64;
+    float frames[CHUNK * NB_LANES];
+
+    for (size_t done = 0; done < aCount; done += CHUNK)
+    {
+        const size_t count = std::min( CHUNK, aCount - done );
+        sca3300Sample *samples = aSamples + done;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            frames[i * NB_LANES + 0] = samples[i].st_Accel[0];
+            frames[i * NB_LANES + 1] = samples[i].st_Accel[1];
+            frames[i * NB_LANES + 2] = samples[i].st_Accel[2];
+            frames[i * NB_LANES + 3] = samples[i].st_Temp;
+        }
+
+        this->Process( frames, frames, count );
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            samples[i].st_Accel[0] = frames[i * NB_LANES + 0];
+            samples[i].st_Accel[1] = frames[i * NB_LANES + 1];
+            samples[i].st_Accel[2] = frames[i * NB_LANES + 2];
+
+            if ( this->filterTemp )
+                samples[i].st_Temp = frames[i * NB_LANES + 3];
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * \class sca3300FilterBank
+ *
+ * \brief Software filtering of the samples, four channels per SIMD lane set.
+ *
+ * A cascade of biquads (transposed direct form II) followed by an optional
+ * FIR. X, Y, Z and, optionally, the temperature are the four lanes of one
+ * vector, so every channel goes through the same coefficients for the
+ * cost of one. Blocks are interleaved frames of 4 floats (X, Y, Z, T).
+ * Coefficients are designed at setup time (RBJ biquads, windowed sinc
+ * FIR), filtering a block does no allocation.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_FILTER_H_
+#define SCA3300_FILTER_H_
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  enum filterType
+  {
+    FILTER_LOWPASS,
+    FILTER_HIGHPASS,
+    FILTER_NOTCH,
+  };
+
+  /**
+   * @brief      Normalized biquad coefficients (a0 = 1)
+   */
+  struct sca3300Biquad
+  {
+    float st_B0 = 1.0f;
+    float st_B1 = 0.0f;
+    float st_B2 = 0.0f;
+    float st_A1 = 0.0f;
+    float st_A2 = 0.0f;
+  };
+
+  bool DesignBiquad( const filterType aType, const float aSampleRate, const float aFrequency,
+                     const float aQ, sca3300Biquad &aBiquad );
+  bool DesignFir( const filterType aType, const float aSampleRate, const float aFrequency,
+                  const size_t aTaps, std::vector<float> &aCoefficients );
+
+  class sca3300FilterBank
+  {
+      public:
+          static const int NB_LANES = 4; // X, Y, Z, temperature
+
+          explicit sca3300FilterBank( const bool aFilterTemp = false );
+
+          void AddBiquad( const sca3300Biquad &aBiquad );
+          void SetFir( const std::vector<float> &aCoefficients );
+          void Clear( void );
+          void Reset( void );
+
+          void Process( const float *aIn, float *aOut, const size_t aCount );
+          void Process( sca3300Sample *aSamples, const size_t aCount );
+
+      private:
+          struct section
+          {
+            sca3300Biquad coefficients;
+            float s1[NB_LANES];
+            float s2[NB_LANES];
+          };
+
+          bool filterTemp;                  /**< Temperature lane written back? */
+
+          std::vector<section> sections;
+          std::vector<float> fir;           /**< Taps, reversed */
+          std::vector<float> firHistory;    /**< Two copies of the delay line (frames) */
+          size_t firPosition;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_FILTER_H_
@@ -0,0 +1,155 @@
+/**
+ * \class sca3300Fixed
+ *
+ * \brief SCA3300 driver with the measurement mode fixed at build time.
+ *
+ * The mode is a template parameter: the sensitivity reciprocal, the
+ * mode-write frame and the saturation threshold are constants, so a
+ * conversion is a single multiply by a literal and there is no mode
+ * switch left. ChangeMode() is not available. The mode is written
+ * during the power up sequence, before the status flags are cleared.
+ *
+ * \note ChangeMode(), ReadSample() and PopSamples() hide the sca3300
+ *       members, they do not override them (not virtual). Through a
+ *       sca3300 reference or pointer the base members are called:
+ *       samples are converted with the runtime sensitivity (same values,
+ *       slower path) and ChangeMode() is not blocked, calling it there
+ *       breaks the fixed mode. Keep the sca3300Fixed type where it matters.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_FIXED_H_
+#define SCA3300_FIXED_H_
+
+#include <memory>
+#include <algorithm> // min...
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300.h"
+
+namespace sca3300d01
+{
+  /**
+   * @brief      Constants of a measurement mode
+   */
+  template <operationMode MODE>
+  struct sca3300ModeTraits
+  {
+      static_assert( MODE >= OPMODE1 && MODE <= OPMODE4, "Unknown SCA3300 measurement mode" );
+
+      static constexpr int32_t  SENSITIVITY = GetModeScale( MODE ).st_Sensitivity; /**< LSB/g */
+      static constexpr float    G_PER_LSB   = 1.0f / SENSITIVITY;                 /**< g per count */
+      static constexpr uint32_t WRITE_MODE  = MakeRequest( true, REG_MODE, MODE - OPMODE1 );
+
+      static constexpr int32_t  FULL_SCALE_MG = ( OPMODE2 == MODE ) ? FULL_SCALE_MODE_2_MG :
+                                                ( OPMODE1 == MODE ) ? FULL_SCALE_MODE_1_MG :
+                                                FULL_SCALE_MODE_3_4_MG;
+      static constexpr int16_t  SATURATION  = FULL_SCALE_MG * SENSITIVITY / 1000; /**< Counts at full scale */
+  };
+
+  template <operationMode MODE>
+  class sca3300Fixed : public sca3300
+  {
+      public:
+          typedef sca3300ModeTraits<MODE> traits;
+
+          /**
+           * @brief      Constructor, sets the device in MODE
+           *
+           * @param[in]  aTransport  SPI frames transport, owned by the object
+           */
+          explicit sca3300Fixed( std::unique_ptr<sca3300Transport> aTransport )
+              : sca3300( std::move( aTransport ), MODE, traits::WRITE_MODE )
+          {
+          }
+
+          // The mode is part of the type
+          bool ChangeMode( const operationMode aMode ) = delete;
+
+          /**
+           * @brief      Acceleration counts to g, one multiply by a constant
+           */
+          static constexpr float ToG( const int16_t aRaw )
+          {
+              return aRaw * traits::G_PER_LSB;
+          }
+
+          /**
+           * @brief      Is an acceleration count at (or beyond) full scale?
+           */
+          static constexpr bool IsSaturated( const int16_t aRaw )
+          {
+              return aRaw >= traits::SATURATION || aRaw <= -traits::SATURATION;
+          }
+
+          /**
+           * @brief      Convert a raw sample (g, °C) with the mode constants
+           */
+          static void Convert( const sca3300RawSample &aRaw, sca3300Sample &aSample )
+          {
+              aSample.st_Timestamp = aRaw.st_Timestamp;
+              aSample.st_Sequence  = aRaw.st_Sequence;
+
+              for (int axe = ACCEL_X; axe <= ACCEL_Z; ++axe)
+                  aSample.st_Accel[axe] = ToG( aRaw.st_Accel[axe] );
+
+              aSample.st_Temp    = ConvertTemperature( aRaw.st_Temp );
+              aSample.st_Status  = aRaw.st_Status;
+              aSample.st_IsValid = aRaw.st_IsValid;
+          }
+
+          /**
+           * @brief      Reads one complete measurement cycle (g, °C).
+           */
+          bool ReadSample( sca3300Sample &aSample )
+          {
+              sca3300RawSample raw;
+
+              raw.st_Timestamp = aSample.st_Timestamp;
+              raw.st_Sequence  = aSample.st_Sequence;
+
+              this->ReadRawSample( raw );
+              Convert( raw, aSample );
+
+              return aSample.st_IsValid;
+          }
+
+          /**
+           * @brief      Get the oldest acquired samples, never blocks.
+           *
+           * @note       Only one thread may consume the ring.
+           */
+          size_t PopSamples( sca3300Sample *aSamples, const size_t aMax )
+          {
+              sca3300RawSample raw[64];
+              size_t count = 0;
+
+              while ( count < aMax )
+              {
+                  const size_t chunk = this->PopRawSamples( raw, std::min( aMax - count, sizeof(raw) / sizeof(raw[0]) ) );
+
+                  for (size_t i = 0; i < chunk; ++i)
+                      Convert( raw[i], aSamples[count + i] );
+
+                  count += chunk;
+
+                  if ( 0 == chunk )
+                      break;
+              }
+
+              return count;
+          }
+  };
+
+  template <operationMode MODE> constexpr int32_t  sca3300ModeTraits<MODE>::SENSITIVITY;
+  template <operationMode MODE> constexpr float    sca3300ModeTraits<MODE>::G_PER_LSB;
+  template <operationMode MODE> constexpr uint32_t sca3300ModeTraits<MODE>::WRITE_MODE;
+  template <operationMode MODE> constexpr int32_t  sca3300ModeTraits<MODE>::FULL_SCALE_MG;
+  template <operationMode MODE> constexpr int16_t  sca3300ModeTraits<MODE>::SATURATION;
+
+} //namespace sca3300d01
+
+#endif //SCA3300_FIXED_H_
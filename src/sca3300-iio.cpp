@@ -0,0 +1,376 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-iio.cpp
+ * @brief Linux IIO buffered capture for SCA3300 device
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // memmove...
+#include <cstdio>
+#include <cstdlib> // strtol
+#include <climits>
+#include <algorithm> // min...
+#include <fstream>
+#include <unistd.h>
+#include <fcntl.h> // O_RDONLY...
+#include <poll.h>
+#include <errno.h>
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300def.h"
+#include "sca3300-tools.h"
+#include "sca3300-iio.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Consts ********************************************** */
+/* Scan element names, in sca3300Iio::channel bit order */
+static const char *SCAN_ELEMENTS[] = { "in_accel_x", "in_accel_y", "in_accel_z", "in_temp", "in_timestamp" };
+
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      Write a value in a sysfs attribute
+ */
+static bool WriteSysfs( const std::string &aPath, const std::string &aValue )
+{
+    std::ofstream file( aPath.c_str() );
+
+    if ( !file )
+    {
+        LOG_ERROR("could not write %s", aPath.c_str());
+        return false;
+    }
+
+    file << aValue << std::endl;
+
+    return file.good();
+}
+
+
+/**
+ * @brief      Read the first line of a sysfs attribute
+ */
+static bool ReadSysfs( const std::string &aPath, std::string &aValue )
+{
+    std::ifstream file( aPath.c_str() );
+
+    if ( !file || !std::getline( file, aValue ) )
+    {
+        LOG_ERROR("could not read %s", aPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Constructor.
+ *
+ * @param[in]   aDevice     { IIO device number N (iio:deviceN) }
+ * @param[in]   aSysfsRoot  { IIO devices sysfs directory }
+ * @param[in]   aDevRoot    { Directory of the iio:deviceN character device }
+ */
+sca3300Iio::sca3300Iio( const int aDevice, const std::string aSysfsRoot, const std::string aDevRoot )
+{
+    const std::string name = "/iio:device" + std::to_string( aDevice );
+
+    this->sysfsDir     = aSysfsRoot + name;
+    this->devNode      = aDevRoot + name;
+    this->fd           = -1;
+    this->sensivity    = SENSITIVITY_MODE_1;
+    this->scanBytes    = 0;
+    this->pendingBytes = 0;
+    this->sequence     = 0;
+}
+
+
+/**
+ * @brief    Destructor, stops the capture.
+ */
+sca3300Iio::~sca3300Iio()
+{
+    if ( this->fd >= 0 )
+        this->Disable();
+}
+
+
+/**
+ * @brief      Parse a scan element type, e.g. "le:s16/16>>0"
+ *
+ * @param[in]  aType     The content of scan_elements/..._type
+ * @param      aElement  The element to fill
+ *
+ * @return     true if the type is supported
+ */
+bool sca3300Iio::ParseType( const std::string &aType, scanElement &aElement )
+{
+    char endian[3] = { 0 };
+    char sign = 0;
+    unsigned realBits = 0, storageBits = 0, shift = 0;
+
+    if ( 5 != sscanf( aType.c_str(), "%2c:%c%u/%u>>%u", endian, &sign, &realBits, &storageBits, &shift ) )
+        return false;
+
+    if ( 0 == realBits || 0 == storageBits || storageBits > 64 || storageBits % 8 || realBits > storageBits )
+        return false;
+
+    aElement.bigEndian    = ( 'b' == endian[0] );
+    aElement.isSigned     = ( 's' == sign );
+    aElement.realBits     = realBits;
+    aElement.storageBytes = storageBits / 8;
+    aElement.shift        = shift;
+
+    return true;
+}
+
+
+/**
+ * @brief      Extract a channel value from a packed scan
+ */
+int64_t sca3300Iio::Extract( const uint8_t *aScan, const scanElement &aElement ) const
+{
+    const uint8_t *p = aScan + aElement.offset;
+    uint64_t value = 0;
+
+    for (unsigned i = 0; i < aElement.storageBytes; ++i)
+    {
+        const unsigned b = aElement.bigEndian ? i : aElement.storageBytes - 1 - i;
+        value = ( value << 8 ) | p[b];
+    }
+
+    value >>= aElement.shift;
+
+    if ( aElement.realBits < 64 )
+    {
+        const uint64_t mask = ( 1ULL << aElement.realBits ) - 1;
+        value &= mask;
+
+        if ( aElement.isSigned && ( value >> ( aElement.realBits - 1 ) ) )
+            value |= ~mask;
+    }
+
+    return (int64_t)value;
+}
+
+
+/**
+ * @brief      Configure and start the buffered capture.
+ *
+ * @param[in]  aBufferLength  Kernel buffer length (scans)
+ * @param[in]  aWatermark     Scans needed to wake up poll()
+ * @param[in]  aChannels      Enabled channels (sca3300Iio::channel mask)
+ * @param[in]  aMode          Measurement mode the driver is set to
+ *
+ * @return     true if the buffer is enabled
+ */
+bool sca3300Iio::Configure( const unsigned int aBufferLength, const unsigned int aWatermark, const unsigned int aChannels, const operationMode aMode )
+{
+    const std::string scanDir = this->sysfsDir + "/scan_elements/";
+
+    // A buffer left enabled (crash, other process) makes the *_en writes fail with EBUSY
+    if ( !this->Disable() )
+        return false;
+
+    this->sensivity = sca3300::GetModeSensitivity( aMode );
+
+    // Enable requested scan elements and read their layout
+    for (int i = 0; i < NB_CHANNELS; ++i)
+    {
+        scanElement &element = this->elements[i];
+        std::string value;
+
+        element = scanElement();
+        element.enabled = ( 0 != ( aChannels & ( 1 << i ) ) );
+
+        if ( !WriteSysfs( scanDir + SCAN_ELEMENTS[i] + "_en", element.enabled ? "1" : "0" ) )
+            return false;
+
+        if ( !element.enabled )
+            continue;
+
+        if ( !ReadSysfs( scanDir + SCAN_ELEMENTS[i] + "_index", value ) )
+            return false;
+
+        char *end = nullptr;
+        const long index = strtol( value.c_str(), &end, 10 );
+
+        if ( end == value.c_str() || index < 0 || index > INT_MAX )
+        {
+            LOG_ERROR("invalid scan element index %s", value.c_str());
+            return false;
+        }
+
+        element.index = (int)index;
+
+        if ( !ReadSysfs( scanDir + SCAN_ELEMENTS[i] + "_type", value ) || !this->ParseType( value, element ) )
+        {
+            LOG_ERROR("unsupported scan element type %s", value.c_str());
+            return false;
+        }
+    }
+
+    // Scan layout: elements in index order, each aligned on its own size
+    scanElement *ordered[NB_CHANNELS];
+    int nbEnabled = 0;
+
+    for (int i = 0; i < NB_CHANNELS; ++i)
+    {/* insertion sort on scan index */
+        if ( !this->elements[i].enabled )
+            continue;
+
+        int pos = nbEnabled++;
+        for ( ; pos > 0 && ordered[pos - 1]->index > this->elements[i].index; --pos)
+            ordered[pos] = ordered[pos - 1];
+        ordered[pos] = &this->elements[i];
+    }
+
+    size_t largest = 1;
+    this->scanBytes = 0;
+
+    for (int i = 0; i < nbEnabled; ++i)
+    {
+        const size_t size = ordered[i]->storageBytes;
+
+        this->scanBytes = ( this->scanBytes + size - 1 ) / size * size;
+        ordered[i]->offset = this->scanBytes;
+        this->scanBytes += size;
+        largest = std::max( largest, size );
+    }
+
+    this->scanBytes = ( this->scanBytes + largest - 1 ) / largest * largest;
+
+    if ( 0 == this->scanBytes )
+    {
+        LOG_ERROR("no scan element enabled");
+        return false;
+    }
+
+    // in_timestamp on CLOCK_MONOTONIC like every other sample source (IIO default: CLOCK_REALTIME)
+    if ( !WriteSysfs( this->sysfsDir + "/current_timestamp_clock", "monotonic" ) )
+        return false;
+
+    // Buffer setup, then start
+    if ( !WriteSysfs( this->sysfsDir + "/buffer/length",    std::to_string( aBufferLength ) ) ||
+         !WriteSysfs( this->sysfsDir + "/buffer/watermark", std::to_string( aWatermark ) )    ||
+         !WriteSysfs( this->sysfsDir + "/buffer/enable",    "1" ) )
+        return false;
+
+    this->readBuffer.resize( (size_t)aBufferLength * this->scanBytes );
+    this->pendingBytes = 0;
+    this->sequence = 0;
+
+    this->fd = open( this->devNode.c_str(), O_RDONLY | O_NONBLOCK );
+    if ( this->fd < 0 )
+    {
+        LOG_ERROR("could not open %s", this->devNode.c_str());
+        this->Disable();
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief      Stop the buffered capture.
+ *
+ * @note       buffer/enable is written even if this object did not enable
+ *             it, so a buffer left by another process is released too.
+ *
+ * @return     true if the buffer is disabled
+ */
+bool sca3300Iio::Disable( void )
+{
+    if ( this->fd >= 0 )
+        close( this->fd );
+
+    this->fd = -1;
+
+    return WriteSysfs( this->sysfsDir + "/buffer/enable", "0" );
+}
+
+
+/**
+ * @brief      Wait for scans and convert them.
+ *
+ * @details    Blocks in poll() until the watermark is reached (or aTimeoutMs),
+ *             then reads every available scan with a single read().
+ *
+ * @param[out] aSamples    Converted samples
+ * @param[in]  aMax        Size of aSamples
+ * @param[in]  aTimeoutMs  poll() timeout, -1 to wait forever
+ *
+ * @return     Number of samples written in aSamples
+ */
+size_t sca3300Iio::ReadSamples( sca3300Sample *aSamples, const size_t aMax, const int aTimeoutMs )
+{
+    if ( this->fd < 0 || 0 == aMax )
+        return 0;
+
+    struct pollfd pfd;
+    pfd.fd     = this->fd;
+    pfd.events = POLLIN;
+
+    if ( poll( &pfd, 1, aTimeoutMs ) <= 0 || !( pfd.revents & POLLIN ) )
+        return 0;
+
+    const size_t wanted = std::min( aMax * this->scanBytes, this->readBuffer.size() );
+
+    if ( wanted <= this->pendingBytes )
+        return 0;
+
+    ssize_t nbRead = read( this->fd, &this->readBuffer[this->pendingBytes], wanted - this->pendingBytes );
+    if ( nbRead < 0 )
+    {
+        if ( EAGAIN != errno )
+        {
+            LOG_ERROR("could not read %s", this->devNode.c_str());
+        }
+        return 0;
+    }
+
+    const size_t available = this->pendingBytes + nbRead;
+    const size_t nbScans = available / this->scanBytes;
+
+    for (size_t n = 0; n < nbScans; ++n)
+    {
+        const uint8_t *scan = &this->readBuffer[n * this->scanBytes];
+        sca3300Sample &sample = aSamples[n];
+
+        for (int axe = ACCEL_X; axe <= ACCEL_Z; ++axe)
+            sample.st_Accel[axe] = this->elements[axe].enabled ?
+                ProcessAccel( (int16_t)this->Extract( scan, this->elements[axe] ), this->sensivity ) : 0.0;
+
+        sample.st_Temp = this->elements[3].enabled ?
+            ConvertTemperature( (uint16_t)this->Extract( scan, this->elements[3] ) ) : 0.0;
+
+        sample.st_Timestamp = this->elements[4].enabled ? this->Extract( scan, this->elements[4] ) : 0;
+        sample.st_Sequence  = this->sequence++;
+        sample.st_Status    = 0;
+        sample.st_IsValid   = true;
+    }
+
+    // Keep a partial scan for the next call
+    this->pendingBytes = available - nbScans * this->scanBytes;
+    if ( this->pendingBytes )
+        memmove( &this->readBuffer[0], &this->readBuffer[nbScans * this->scanBytes], this->pendingBytes );
+
+    return nbScans;
+}
@@ -0,0 +1,91 @@
+/**
+ * \class sca3300Iio
+ *
+ * \brief Buffered capture through the Linux sca3300 IIO driver.
+ *
+ * The kernel samples the device on its trigger and stores packed scans in
+ * the IIO buffer. This class configures the buffer through sysfs, waits
+ * for the watermark with poll() and reads whole blocks of scans with one
+ * read() on /dev/iio:deviceN.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_IIO_H_
+#define SCA3300_IIO_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300.h"
+
+namespace sca3300d01
+{
+  class sca3300Iio
+  {
+      public:
+          /**
+           * @brief      Scan elements of the sca3300 IIO device
+           */
+          enum channel
+          {
+            IIO_ACCEL_X   = 0x01,
+            IIO_ACCEL_Y   = 0x02,
+            IIO_ACCEL_Z   = 0x04,
+            IIO_TEMP      = 0x08,
+            IIO_TIMESTAMP = 0x10,
+            IIO_ALL       = 0x1F,
+          };
+
+          sca3300Iio( const int aDevice, \
+                      const std::string aSysfsRoot = "/sys/bus/iio/devices",\
+                      const std::string aDevRoot   = "/dev");
+          ~sca3300Iio();
+
+          bool Configure( const unsigned int aBufferLength, \
+                          const unsigned int aWatermark,    \
+                          const unsigned int aChannels = IIO_ALL, \
+                          const operationMode aMode = OPMODE1 );
+          size_t ReadSamples( sca3300Sample *aSamples, const size_t aMax, const int aTimeoutMs );
+          bool Disable( void );
+
+      private:
+          static const int NB_CHANNELS = 5;
+
+          /**
+           * @brief      Position of a channel inside a packed scan
+           */
+          struct scanElement
+          {
+            bool     enabled = false;
+            int      index = 0;       /**< scan_elements/..._index */
+            bool     bigEndian = false;
+            bool     isSigned = false;
+            unsigned realBits = 0;
+            unsigned storageBytes = 0;
+            unsigned shift = 0;
+            size_t   offset = 0;      /**< Byte offset inside the scan */
+          };
+
+          std::string sysfsDir;
+          std::string devNode;
+          int fd;
+          int sensivity;
+
+          scanElement elements[NB_CHANNELS];
+          size_t scanBytes;
+
+          std::vector<uint8_t> readBuffer;
+          size_t pendingBytes;
+          uint32_t sequence;
+
+          bool ParseType( const std::string &aType, scanElement &aElement );
+          int64_t Extract( const uint8_t *aScan, const scanElement &aElement ) const;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_IIO_H_
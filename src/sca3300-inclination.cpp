@@ -0,0 +1,215 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-inclination.cpp
+ * @brief Inclination (pitch, roll, tilt) from acceleration blocks
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <math.h>
+#include <algorithm> // min...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-inclination.h"
+#include "sca3300-simd.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+static constexpr float HALF_PI = 1.57079637f;
+static constexpr float PI      = 3.14159274f;
+static constexpr float DEGREES = 57.2957795f; // 180 / pi
+
+// atan(t) on [0, 1]: t * P(t²), odd minimax polynomial
+static constexpr float ATAN_C1  =  0.99997726f;
+static constexpr float ATAN_C3  = -0.33262347f;
+static constexpr float ATAN_C5  =  0.19354346f;
+static constexpr float ATAN_C7  = -0.11643287f;
+static constexpr float ATAN_C9  =  0.05265332f;
+static constexpr float ATAN_C11 = -0.01172120f;
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      atan2 of 4 lanes, same steps as FastAtan2
+ */
+static inline v4f FastAtan2x4( const v4f aY, const v4f aX )
+{
+    const v4f ax = v4f::Abs( aX );
+    const v4f ay = v4f::Abs( aY );
+
+    // t = min / max in [0, 1], 0 for the origin
+    const v4f t = v4f::Min( ax, ay ) / v4f::Max( v4f::Max( ax, ay ), v4f::Set1( 1e-30f ) );
+    const v4f s = t * t;
+
+    v4f r = v4f::Set1( ATAN_C11 );
+    r = r * s + v4f::Set1( ATAN_C9 );
+    r = r * s + v4f::Set1( ATAN_C7 );
+    r = r * s + v4f::Set1( ATAN_C5 );
+    r = r * s + v4f::Set1( ATAN_C3 );
+    r = r * s + v4f::Set1( ATAN_C1 );
+    r = r * t;
+
+    r = v4f::SelectGreater( ay, ax, v4f::Set1( HALF_PI ) - r, r );
+    r = v4f::SelectGreater( v4f::Set1( 0.0f ), aX, v4f::Set1( PI ) - r, r );
+
+    return v4f::CopySign( r, aY );
+}
+
+
+/**
+ * @brief      Polynomial approximation of atan2
+ *
+ * @note       Octant reduction to atan(t), t in [0, 1], then an 11th order
+ *             odd minimax polynomial. Error at most FAST_ATAN2_MAX_ERROR.
+ *
+ * @param[in]  aY    Ordinate
+ * @param[in]  aX    Abscissa
+ *
+ * @return     Angle in [-pi, pi] (rad)
+ */
+float sca3300d01::FastAtan2( const float aY, const float aX )
+{
+    const float ax = fabsf( aX );
+    const float ay = fabsf( aY );
+
+    const float t = std::min( ax, ay ) / std::max( std::max( ax, ay ), 1e-30f );
+    const float s = t * t;
+
+    float r = t * ( ATAN_C1 + s * ( ATAN_C3 + s * ( ATAN_C5 + s * ( ATAN_C7 + s * ( ATAN_C9 + s * ATAN_C11 ) ) ) ) );
+
+    if ( ay > ax )
+        r = HALF_PI - r;
+    if ( aX < 0.0f )
+        r = PI - r;
+
+    return copysignf( r, aY );
+}
+
+
+/**
+ * @brief      Inclination of one acceleration vector
+ *
+ * @param[in]  aAccel   Acceleration X, Y, Z (g)
+ * @param[in]  aMethod  atan2f or FastAtan2
+ *
+ * @return     Pitch, roll and tilt (degrees)
+ */
+sca3300Inclination sca3300d01::ComputeInclination( const float aAccel[3], const inclinationMethod aMethod )
+{
+    const float x = aAccel[0], y = aAccel[1], z = aAccel[2];
+
+    const float yz = sqrtf( y * y + z * z );
+    const float xz = sqrtf( x * x + z * z );
+    const float xy = sqrtf( x * x + y * y );
+
+    sca3300Inclination inclination;
+
+    if ( INCLINATION_LIBM == aMethod )
+    {
+        inclination.st_Pitch = atan2f( x, yz ) * DEGREES;
+        inclination.st_Roll  = atan2f( y, xz ) * DEGREES;
+        inclination.st_Tilt  = atan2f( xy, z ) * DEGREES;
+    }
+    else
+    {
+        inclination.st_Pitch = FastAtan2( x, yz ) * DEGREES;
+        inclination.st_Roll  = FastAtan2( y, xz ) * DEGREES;
+        inclination.st_Tilt  = FastAtan2( xy, z ) * DEGREES;
+    }
+
+    return inclination;
+}
+
+
+/**
+ * @brief      Inclination of a block of acceleration vectors
+ *
+ * @note       INCLINATION_FAST computes 4 samples per iteration.
+ *
+ * @param[in]  aAccel        X, Y, Z of sample i at aAccel[i * aStride] (g)
+ * @param[in]  aStride       Floats between two samples: 3 for packed XYZ,
+ *                           4 for the frames of sca3300FilterBank
+ * @param[out] aInclination  Pitch, roll and tilt (degrees)
+ * @param[in]  aCount        Number of samples
+ * @param[in]  aMethod       atan2f or FastAtan2
+ */
+void sca3300d01::ComputeInclinationBlock( const float *aAccel, const size_t aStride, sca3300Inclination *aInclination,
+                                          const size_t aCount, const inclinationMethod aMethod )
+{
+    size_t i = 0;
+
+    if ( INCLINATION_FAST == aMethod )
+    {
+        const v4f degrees = v4f::Set1( DEGREES );
+
+        for ( ; i + 4 <= aCount; i += 4)
+        {
+            float lanes[3][4];
+
+            // Transpose 4 samples to one vector per axis
+            for (int k = 0; k < 4; ++k)
+                for (int axe = 0; axe < 3; ++axe)
+                    lanes[axe][k] = aAccel[( i + k ) * aStride + axe];
+
+            const v4f x = v4f::Load( lanes[0] );
+            const v4f y = v4f::Load( lanes[1] );
+            const v4f z = v4f::Load( lanes[2] );
+
+            const v4f xx = x * x, yy = y * y, zz = z * z;
+
+            float angles[3][4];
+            ( FastAtan2x4( x, v4f::Sqrt( yy + zz ) ) * degrees ).Store( angles[0] );
+            ( FastAtan2x4( y, v4f::Sqrt( xx + zz ) ) * degrees ).Store( angles[1] );
+            ( FastAtan2x4( v4f::Sqrt( xx + yy ), z ) * degrees ).Store( angles[2] );
+
+            for (int k = 0; k < 4; ++k)
+            {
+                aInclination[i + k].st_Pitch = angles[0][k];
+                aInclination[i + k].st_Roll  = angles[1][k];
+                aInclination[i + k].st_Tilt  = angles[2][k];
+            }
+        }
+    }
+
+    for ( ; i < aCount; ++i)
+        aInclination[i] = ComputeInclination( aAccel + i * aStride, aMethod );
+}
+
+
+/**
+ * @brief      Inclination of a block of samples
+ *
+ * @note       Invalid samples are computed as the others.
+ *
+ * @param[in]  aSamples      The samples
+ * @param[out] aInclination  Pitch, roll and tilt (degrees)
+ * @param[in]  aCount        Number of samples
+ * @param[in]  aMethod       atan2f or FastAtan2
+ */
+void sca3300d01::ComputeInclinationBlock( const sca3300Sample *aSamples, sca3300Inclination *aInclination,
+                                          const size_t aCount, const inclinationMethod aMethod )
+{
+    const size_t CHUNK = 64;
+    float accel[CHUNK * 3];
+
+    for (size_t done = 0; done < aCount; done += CHUNK)
+    {
+        const size_t count = std::min( CHUNK, aCount - done );
+
+        for (size_t i = 0; i < count; ++i)
+            for (int axe = 0; axe < 3; ++axe)
+                accel[i * 3 + axe] = aSamples[done + i].st_Accel[axe];
+
+        ComputeInclinationBlock( accel, 3, aInclination + done, count, aMethod );
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-inclination.h
+ * @brief Inclination (pitch, roll, tilt) from acceleration blocks
+ *
+ * Angles of the datasheet, in degrees:
+ *  - pitch: X axis to the horizontal plane, atan2(x, sqrt(y² + z²))
+ *  - roll:  Y axis to the horizontal plane, atan2(y, sqrt(x² + z²))
+ *  - tilt:  Z axis to the vertical, atan2(sqrt(x² + y²), z)
+ *
+ * INCLINATION_LIBM uses atan2f. INCLINATION_FAST evaluates an odd minimax
+ * polynomial of atan on 4 samples per SIMD vector, its error is at most
+ * FAST_ATAN2_MAX_ERROR radians (≈ 0.00015°), far below the resolution of
+ * the sensor.
+ *
+ */
+
+#ifndef SCA3300_INCLINATION_H_
+#define SCA3300_INCLINATION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  enum inclinationMethod
+  {
+    INCLINATION_LIBM,
+    INCLINATION_FAST,
+  };
+
+  /** Maximum absolute error of FastAtan2 (rad), whole plane */
+  constexpr float FAST_ATAN2_MAX_ERROR = 2.5e-6f;
+
+  /**
+   * @brief      Inclination of a sample (degrees)
+   */
+  struct sca3300Inclination
+  {
+    float st_Pitch = 0.0f;
+    float st_Roll = 0.0f;
+    float st_Tilt = 0.0f;
+  };
+
+  float FastAtan2( const float aY, const float aX );
+
+  sca3300Inclination ComputeInclination( const float aAccel[3], const inclinationMethod aMethod = INCLINATION_FAST );
+  void ComputeInclinationBlock( const float *aAccel, const size_t aStride, sca3300Inclination *aInclination,
+                                const size_t aCount, const inclinationMethod aMethod = INCLINATION_FAST );
+  void ComputeInclinationBlock( const sca3300Sample *aSamples, sca3300Inclination *aInclination,
+                                const size_t aCount, const inclinationMethod aMethod = INCLINATION_FAST );
+
+} //namespace sca3300d01
+
+#endif //SCA3300_INCLINATION_H_
@@ -0,0 +1,157 @@
+/**
+ * \class sca3300Latest
+ *
+ * \brief Wait-free "latest value" channel (seqlock), one writer, many readers.
+ *
+ * The writer never waits. Readers copy the value and retry if the writer
+ * updated it meanwhile, so any number of threads gets a consistent
+ * snapshot without taking a lock. The value is stored as relaxed atomic
+ * words, which keeps the concurrent copy well defined. A writer killed
+ * while publishing (another process) blocks Read() for good: such readers
+ * use TryRead().
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_LATEST_H_
+#define SCA3300_LATEST_H_
+
+#include <atomic>
+#include <cstring> // memcpy...
+#include <type_traits>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sca3300d01
+{
+  template <typename T>
+  class sca3300Latest
+  {
+      static_assert( std::is_trivially_copyable<T>::value, "sca3300Latest needs a trivially copyable type" );
+
+      public:
+          sca3300Latest()
+              : sequence( 0 )
+          {
+              for (size_t i = 0; i < NB_WORDS; ++i)
+                  this->words[i].store( 0, std::memory_order_relaxed );
+          }
+
+          /**
+           * @brief      Writer side: publish a new value.
+           *
+           * @note       Only one thread may publish.
+           */
+          void Publish( const T &aValue )
+          {
+              uint32_t buffer[NB_WORDS] = { 0 };
+              memcpy( buffer, &aValue, sizeof(T) );
+
+              const uint32_t seq = this->sequence.load( std::memory_order_relaxed );
+
+              // 0 means "never published": skipped when the sequence wraps
+              // (2^31 publishes, 12 days at 2 kHz)
+              const uint32_t next = ( 0 == (uint32_t)( seq + 2 ) ) ? 2 : seq + 2;
+
+              // Odd sequence: update in progress
+              this->sequence.store( seq + 1, std::memory_order_relaxed );
+              std::atomic_thread_fence( std::memory_order_release );
+
+              for (size_t i = 0; i < NB_WORDS; ++i)
+                  this->words[i].store( buffer[i], std::memory_order_relaxed );
+
+              this->sequence.store( next, std::memory_order_release );
+          }
+
+          /**
+           * @brief      Reader side: copy the latest value.
+           *
+           * @param[out] aValue  The value
+           *
+           * @return     false if nothing has been published yet
+           */
+          bool Read( T &aValue ) const
+          {
+              uint32_t buffer[NB_WORDS];
+              uint32_t seq;
+
+              while ( !this->Snapshot( buffer, seq ) )
+                  ;
+
+              if ( 0 == seq )
+                  return false;
+
+              memcpy( &aValue, buffer, sizeof(T) );
+
+              return true;
+          }
+
+          /**
+           * @brief      Reader side: copy the latest value, bounded number of attempts.
+           *
+           * @param[out] aValue     The value
+           * @param[in]  aAttempts  Copies tried before giving up
+           *
+           * @return     false if nothing has been published yet or if every
+           *             copy overlapped a publish
+           */
+          bool TryRead( T &aValue, const uint32_t aAttempts ) const
+          {
+              uint32_t buffer[NB_WORDS];
+              uint32_t seq;
+
+              for (uint32_t i = 0; i < aAttempts; ++i)
+              {
+                  if ( !this->Snapshot( buffer, seq ) )
+                      continue;
+
+                  if ( 0 == seq )
+                      return false;
+
+                  memcpy( &aValue, buffer, sizeof(T) );
+
+                  return true;
+              }
+
+              return false;
+          }
+
+          /**
+           * @brief      Has a value been published (or is one being published)?
+           */
+          bool IsPublished( void ) const
+          {
+              return 0 != this->sequence.load( std::memory_order_acquire );
+          }
+
+      private:
+          static const size_t NB_WORDS = ( sizeof(T) + sizeof(uint32_t) - 1 ) / sizeof(uint32_t);
+
+          /**
+           * @brief      One copy of the words
+           *
+           * @return     false if a publish overlapped the copy
+           */
+          bool Snapshot( uint32_t *aBuffer, uint32_t &aSequence ) const
+          {
+              const uint32_t before = this->sequence.load( std::memory_order_acquire );
+
+              for (size_t i = 0; i < NB_WORDS; ++i)
+                  aBuffer[i] = this->words[i].load( std::memory_order_relaxed );
+
+              std::atomic_thread_fence( std::memory_order_acquire );
+              const uint32_t after = this->sequence.load( std::memory_order_relaxed );
+
+              aSequence = before;
+
+              return !( before & 1 ) && before == after;
+          }
+
+          std::atomic<uint32_t> sequence;
+          std::atomic<uint32_t> words[NB_WORDS];
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_LATEST_H_
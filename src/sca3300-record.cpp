@@ -0,0 +1,589 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-record.cpp
+ * @brief Binary recording of raw samples (mmap append writer and reader)
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // memcpy...
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h> // open, fallocate...
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-record.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Consts ********************************************** */
+static const char RECORD_MAGIC[8] = { 'S', 'C', 'A', '3', '3', '0', '0', 'R' };
+
+#define CHUNK_MAGIC          0x4B4E4843 /* "CHNK" */
+#define CHUNK_FOOTER_MAGIC   0x444E4543 /* "CEND" */
+#define RECORD_FLAG_VALID    0x01
+#define RECORD_MAX_CHUNK     ( 1 << 20 ) /* samples */
+
+/* ******** Definitions/Types *********************************************** */
+/**
+ * @brief      CRC-32 (IEEE 802.3, reflected 0xEDB88320) lookup table
+ */
+struct recordCrcTable
+{
+    uint32_t st_Table[256];
+
+    constexpr recordCrcTable() : st_Table()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = ( crc & 1 ) ? ( crc >> 1 ) ^ 0xEDB88320 : crc >> 1;
+
+            st_Table[i] = crc;
+        }
+    }
+};
+
+static constexpr recordCrcTable CRC32_TABLE;
+
+static_assert( CRC32_TABLE.st_Table[1] == 0x77073096 && CRC32_TABLE.st_Table[255] == 0x2D02EF8D, "Unexpected CRC-32 table" );
+
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      CRC-32 of a buffer (zlib compatible)
+ *
+ * @param[in]  aData  The bytes
+ * @param[in]  aSize  Number of bytes
+ * @param[in]  aCrc   CRC of the previous bytes, 0 to start
+ */
+uint32_t sca3300d01::RecordCRC( const uint8_t *aData, const size_t aSize, const uint32_t aCrc )
+{
+    uint32_t crc = ~aCrc;
+
+    for (size_t i = 0; i < aSize; ++i)
+        crc = CRC32_TABLE.st_Table[( crc ^ aData[i] ) & 0xFF] ^ ( crc >> 8 );
+
+    return ~crc;
+}
+
+
+/**
+ * @brief      Bytes of a chunk of aChunkSamples samples
+ */
+static inline size_t ChunkSize( const uint32_t aChunkSamples )
+{
+    return sizeof(sca3300ChunkHeader) + aChunkSamples * sizeof(sca3300RecordSample) + sizeof(sca3300ChunkFooter);
+}
+
+
+/**
+ * @brief      File offset of a chunk
+ */
+static inline off_t ChunkOffset( const uint32_t aIndex, const size_t aChunkSize )
+{
+    return (off_t)sizeof(sca3300RecordHeader) + (off_t)aIndex * (off_t)aChunkSize;
+}
+
+
+/*============================================================================*/
+/*                                   WRITER                                   */
+/*============================================================================*/
+
+sca3300RecordWriter::sca3300RecordWriter()
+{
+    this->fd             = -1;
+    this->map            = nullptr;
+    this->mapSize        = 0;
+    this->mapOffset      = 0;
+    this->chunkSamples   = 0;
+    this->chunkSize      = 0;
+    this->preallocChunks = 0;
+    this->nbChunks       = 0;
+    this->chunkIndex     = 0;
+    this->chunkCount     = 0;
+    this->baseTimestamp  = 0;
+    this->nextSequence   = 0;
+    this->nbSamples      = 0;
+}
+
+
+sca3300RecordWriter::~sca3300RecordWriter()
+{
+    this->Close();
+}
+
+
+/**
+ * @brief      Create (or truncate) a recording.
+ *
+ * @param[in]  aPath            File path
+ * @param[in]  aInfo            Device and acquisition settings, in the header
+ * @param[in]  aChunkSamples    Sample capacity of a chunk
+ * @param[in]  aPreallocChunks  Chunks allocated ahead when the file grows
+ *
+ * @return     false if the file could not be created and mapped
+ */
+bool sca3300RecordWriter::Open( const std::string &aPath, const sca3300RecordInfo &aInfo,
+                                const uint32_t aChunkSamples, const uint32_t aPreallocChunks )
+{
+    if ( 0 == aChunkSamples || aChunkSamples > RECORD_MAX_CHUNK || 0 == aPreallocChunks )
+    {
+        LOG_ERROR("invalid recording geometry: %u samples per chunk, %u chunks ahead", aChunkSamples, aPreallocChunks);
+        return false;
+    }
+
+    this->Close();
+
+    this->fd = open( aPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+
+    if ( this->fd < 0 )
+    {
+        LOG_ERROR("could not create %s: %s", aPath.c_str(), strerror( errno ));
+        return false;
+    }
+
+    this->chunkSamples   = aChunkSamples;
+    this->chunkSize      = ChunkSize( aChunkSamples );
+    this->preallocChunks = aPreallocChunks;
+    this->nbChunks       = 0;
+    this->chunkIndex     = 0;
+    this->chunkCount     = 0;
+    this->nbSamples      = 0;
+
+    if ( !this->Grow() )
+    {
+        close( this->fd );
+        this->fd = -1;
+        return false;
+    }
+
+    sca3300RecordHeader header;
+    memset( &header, 0, sizeof(header) );
+
+    memcpy( header.st_Magic, RECORD_MAGIC, sizeof(header.st_Magic) );
+    header.st_Version      = RECORD_VERSION;
+    header.st_HeaderSize   = sizeof(sca3300RecordHeader);
+    header.st_ChunkSamples = aChunkSamples;
+    header.st_ChunkSize    = this->chunkSize;
+    header.st_DeviceId     = aInfo.st_DeviceId;
+    header.st_Sensitivity  = aInfo.st_Sensitivity;
+    header.st_Odr          = aInfo.st_Odr;
+    header.st_StartTime    = aInfo.st_StartTime;
+    header.st_Mode         = aInfo.st_Mode;
+
+    if ( (ssize_t)sizeof(header) != pwrite( this->fd, &header, sizeof(header), 0 ) )
+    {
+        LOG_ERROR("could not write the header of %s: %s", aPath.c_str(), strerror( errno ));
+        this->Close();
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief      Preallocate preallocChunks more chunks and map them in place of the previous ones
+ */
+bool sca3300RecordWriter::Grow( void )
+{
+    const uint32_t nbChunks = this->nbChunks + this->preallocChunks;
+    const off_t start = ChunkOffset( this->nbChunks, this->chunkSize );
+    const off_t end   = ChunkOffset( nbChunks, this->chunkSize );
+
+    // Real blocks: no page fault allocation nor ENOSPC (SIGBUS) while mapped.
+    // A sparse file only where the file system cannot preallocate.
+    if ( 0 != fallocate( this->fd, 0, start, end - start ) &&
+         ( EOPNOTSUPP != errno || 0 != ftruncate( this->fd, end ) ) )
+    {
+        LOG_ERROR("could not grow the recording to %lld bytes: %s", (long long)end, strerror( errno ));
+        return false;
+    }
+
+    const off_t offset = start - start % sysconf( _SC_PAGESIZE );
+    const size_t size  = end - offset;
+
+    void *map = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, offset );
+
+    if ( MAP_FAILED == map )
+    {
+        LOG_ERROR("could not map the recording: %s", strerror( errno ));
+        return false;
+    }
+
+    // The chunks before are sealed, their pages stay in the page cache
+    if ( nullptr != this->map )
+        munmap( this->map, this->mapSize );
+
+    this->map       = (uint8_t *)map;
+    this->mapSize   = size;
+    this->mapOffset = offset;
+    this->nbChunks  = nbChunks;
+
+    return true;
+}
+
+
+/**
+ * @brief      Address of a chunk of the window
+ */
+uint8_t *sca3300RecordWriter::Chunk( const uint32_t aIndex ) const
+{
+    return this->map + ( ChunkOffset( aIndex, this->chunkSize ) - this->mapOffset );
+}
+
+
+void sca3300RecordWriter::StartChunk( const sca3300RawSample &aFirst )
+{
+    sca3300ChunkHeader header;
+    memset( &header, 0, sizeof(header) );
+
+    header.st_Magic         = CHUNK_MAGIC;
+    header.st_Index         = this->chunkIndex;
+    header.st_BaseTimestamp = aFirst.st_Timestamp;
+    header.st_FirstSequence = aFirst.st_Sequence;
+
+    memcpy( this->Chunk( this->chunkIndex ), &header, sizeof(header) );
+
+    this->baseTimestamp = aFirst.st_Timestamp;
+    this->nextSequence  = aFirst.st_Sequence;
+}
+
+
+/**
+ * @brief      Write the footer of the current chunk, next samples go to the next one
+ */
+void sca3300RecordWriter::SealChunk( void )
+{
+    uint8_t *chunk = this->Chunk( this->chunkIndex );
+
+    sca3300ChunkFooter footer;
+    memset( &footer, 0, sizeof(footer) );
+
+    footer.st_Magic = CHUNK_FOOTER_MAGIC;
+    footer.st_Count = this->chunkCount;
+    footer.st_Crc   = RecordCRC( chunk, sizeof(sca3300ChunkHeader) + this->chunkCount * sizeof(sca3300RecordSample) );
+
+    memcpy( chunk + this->chunkSize - sizeof(footer), &footer, sizeof(footer) );
+
+    this->chunkIndex++;
+    this->chunkCount = 0;
+}
+
+
+/**
+ * @brief      Append raw samples.
+ *
+ * @note       Timestamps are stored with a 1 µs resolution. A sequence gap
+ *             (dropped samples) or more than 71 minutes since the chunk
+ *             base starts a new chunk.
+ *
+ * @param[in]  aSamples  The samples, in acquisition order
+ * @param[in]  aCount    Number of samples
+ *
+ * @return     false if the recording is closed or could not grow
+ */
+bool sca3300RecordWriter::Append( const sca3300RawSample *aSamples, const size_t aCount )
+{
+    if ( this->fd < 0 )
+        return false;
+
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        const sca3300RawSample &sample = aSamples[i];
+
+        if ( this->chunkCount > 0 )
+        {
+            const int64_t offset = sample.st_Timestamp - this->baseTimestamp;
+
+            if ( sample.st_Sequence != this->nextSequence || offset < 0 || offset / 1000 > UINT32_MAX )
+                this->SealChunk();
+        }
+
+        if ( 0 == this->chunkCount )
+        {
+            if ( this->chunkIndex >= this->nbChunks && !this->Grow() )
+                return false;
+
+            this->StartChunk( sample );
+        }
+
+        sca3300RecordSample record;
+
+        record.st_TimeOffsetUs = (uint32_t)( ( sample.st_Timestamp - this->baseTimestamp ) / 1000 );
+        record.st_Accel[0]     = sample.st_Accel[0];
+        record.st_Accel[1]     = sample.st_Accel[1];
+        record.st_Accel[2]     = sample.st_Accel[2];
+        record.st_Temp         = sample.st_Temp;
+        record.st_Status       = sample.st_Status;
+        record.st_Mode         = sample.st_Mode;
+        record.st_Flags        = sample.st_IsValid ? RECORD_FLAG_VALID : 0;
+
+        memcpy( this->Chunk( this->chunkIndex ) + sizeof(sca3300ChunkHeader) + this->chunkCount * sizeof(record),
+                &record, sizeof(record) );
+
+        this->chunkCount++;
+        this->nextSequence = sample.st_Sequence + 1;
+        this->nbSamples++;
+
+        if ( this->chunkCount == this->chunkSamples )
+            this->SealChunk();
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief      Write the recording to the disk (blocks), the window and the chunks before it.
+ */
+bool sca3300RecordWriter::Flush( void )
+{
+    if ( nullptr == this->map )
+        return false;
+
+    return 0 == msync( this->map, this->mapSize, MS_SYNC ) && 0 == fdatasync( this->fd );
+}
+
+
+/**
+ * @brief      Seal the last chunk, drop the unused preallocated chunks.
+ *
+ * @return     false if nothing was open or the file could not be trimmed
+ */
+bool sca3300RecordWriter::Close( void )
+{
+    if ( this->fd < 0 )
+        return false;
+
+    if ( this->chunkCount > 0 )
+        this->SealChunk();
+
+    bool ret = this->Flush();
+
+    munmap( this->map, this->mapSize );
+    this->map       = nullptr;
+    this->mapSize   = 0;
+    this->mapOffset = 0;
+
+    const off_t used = ChunkOffset( this->chunkIndex, this->chunkSize );
+
+    if ( 0 != ftruncate( this->fd, used ) )
+    {
+        LOG_ERROR("could not trim the recording: %s", strerror( errno ));
+        ret = false;
+    }
+
+    close( this->fd );
+    this->fd = -1;
+
+    return ret;
+}
+
+
+/*============================================================================*/
+/*                                   READER                                   */
+/*============================================================================*/
+
+/**
+ * @brief      Read aSize bytes at aOffset (pread until done)
+ */
+static bool ReadAt( const int aFd, void *aOut, const size_t aSize, const off_t aOffset )
+{
+    size_t done = 0;
+
+    while ( done < aSize )
+    {
+        const ssize_t nbRead = pread( aFd, (uint8_t *)aOut + done, aSize - done, aOffset + (off_t)done );
+
+        if ( nbRead < 0 && EINTR == errno )
+            continue;
+
+        if ( nbRead <= 0 )
+            return false;
+
+        done += nbRead;
+    }
+
+    return true;
+}
+
+
+sca3300RecordReader::sca3300RecordReader()
+{
+    this->fd           = -1;
+    this->chunkSamples = 0;
+    this->chunkSize    = 0;
+    this->nbChunks     = 0;
+}
+
+
+sca3300RecordReader::~sca3300RecordReader()
+{
+    this->Close();
+}
+
+
+/**
+ * @brief      Open a recording and check its chunks.
+ *
+ * @note       Chunks are counted up to the first one that is not sealed
+ *             or whose CRC is wrong (recording interrupted). The file is
+ *             read chunk by chunk, never mapped as a whole, so a recording
+ *             may be larger than the address space.
+ *
+ * @param[in]  aPath  File path
+ *
+ * @return     false if the file is not a recording
+ */
+bool sca3300RecordReader::Open( const std::string &aPath )
+{
+    this->Close();
+
+    this->fd = open( aPath.c_str(), O_RDONLY );
+
+    if ( this->fd < 0 )
+    {
+        LOG_ERROR("could not open %s: %s", aPath.c_str(), strerror( errno ));
+        return false;
+    }
+
+    struct stat st;
+    sca3300RecordHeader header;
+
+    if ( 0 != fstat( this->fd, &st ) || st.st_size < (off_t)sizeof(header) ||
+         !ReadAt( this->fd, &header, sizeof(header), 0 ) )
+    {
+        LOG_ERROR("%s is not a recording", aPath.c_str());
+        this->Close();
+        return false;
+    }
+
+    if ( 0 != memcmp( header.st_Magic, RECORD_MAGIC, sizeof(header.st_Magic) ) || RECORD_VERSION != header.st_Version ||
+         sizeof(header) != header.st_HeaderSize || 0 == header.st_ChunkSamples ||
+         header.st_ChunkSamples > RECORD_MAX_CHUNK || ChunkSize( header.st_ChunkSamples ) != header.st_ChunkSize )
+    {
+        LOG_ERROR("%s: unknown recording format", aPath.c_str());
+        this->Close();
+        return false;
+    }
+
+    this->info.st_DeviceId    = header.st_DeviceId;
+    this->info.st_Mode        = header.st_Mode;
+    this->info.st_Sensitivity = header.st_Sensitivity;
+    this->info.st_Odr         = header.st_Odr;
+    this->info.st_StartTime   = header.st_StartTime;
+
+    this->chunkSamples = header.st_ChunkSamples;
+    this->chunkSize    = header.st_ChunkSize;
+    this->nbChunks     = 0;
+
+    const off_t available = ( st.st_size - (off_t)sizeof(header) ) / (off_t)this->chunkSize;
+    std::vector<uint8_t> chunk( this->chunkSize );
+
+    for (off_t i = 0; i < available && i < UINT32_MAX; ++i)
+    {
+        sca3300ChunkHeader chunkHeader;
+        sca3300ChunkFooter footer;
+
+        const bool read = ReadAt( this->fd, chunk.data(), this->chunkSize, ChunkOffset( i, this->chunkSize ) );
+
+        memcpy( &chunkHeader, chunk.data(), sizeof(chunkHeader) );
+        memcpy( &footer, chunk.data() + this->chunkSize - sizeof(footer), sizeof(footer) );
+
+        if ( !read || CHUNK_MAGIC != chunkHeader.st_Magic || i != chunkHeader.st_Index ||
+             CHUNK_FOOTER_MAGIC != footer.st_Magic || 0 == footer.st_Count || footer.st_Count > this->chunkSamples ||
+             footer.st_Crc != RecordCRC( chunk.data(), sizeof(chunkHeader) + footer.st_Count * sizeof(sca3300RecordSample) ) )
+        {
+            LOG_ERROR("%s: recording ends at chunk %lld", aPath.c_str(), (long long)i);
+            break;
+        }
+
+        this->nbChunks++;
+    }
+
+    return true;
+}
+
+
+void sca3300RecordReader::Close( void )
+{
+    if ( this->fd >= 0 )
+        close( this->fd );
+
+    this->fd       = -1;
+    this->info     = sca3300RecordInfo();
+    this->nbChunks = 0;
+}
+
+
+/**
+ * @brief      Decode the samples of a chunk.
+ *
+ * @param[in]  aIndex    Chunk number, below GetChunkCount()
+ * @param[out] aSamples  Room for GetChunkSamples() samples
+ *
+ * @return     Number of samples, 0 if aIndex is out of the recording or could not be read
+ */
+size_t sca3300RecordReader::ReadChunk( const uint32_t aIndex, sca3300RawSample *aSamples ) const
+{
+    if ( aIndex >= this->nbChunks )
+        return 0;
+
+    std::vector<uint8_t> chunk( this->chunkSize );
+
+    if ( !ReadAt( this->fd, chunk.data(), this->chunkSize, ChunkOffset( aIndex, this->chunkSize ) ) )
+    {
+        LOG_ERROR("could not read chunk %u: %s", aIndex, strerror( errno ));
+        return 0;
+    }
+
+    sca3300ChunkHeader header;
+    sca3300ChunkFooter footer;
+
+    memcpy( &header, chunk.data(), sizeof(header) );
+    memcpy( &footer, chunk.data() + this->chunkSize - sizeof(footer), sizeof(footer) );
+
+    if ( footer.st_Count > this->chunkSamples )
+        return 0;
+
+    for (uint32_t i = 0; i < footer.st_Count; ++i)
+    {
+        sca3300RecordSample record;
+        memcpy( &record, chunk.data() + sizeof(header) + i * sizeof(record), sizeof(record) );
+
+        sca3300RawSample &sample = aSamples[i];
+
+        sample.st_Timestamp = header.st_BaseTimestamp + (int64_t)record.st_TimeOffsetUs * 1000;
+        sample.st_Sequence  = header.st_FirstSequence + i;
+        sample.st_Accel[0]  = record.st_Accel[0];
+        sample.st_Accel[1]  = record.st_Accel[1];
+        sample.st_Accel[2]  = record.st_Accel[2];
+        sample.st_Temp      = record.st_Temp;
+        sample.st_Status    = record.st_Status;
+        sample.st_Mode      = record.st_Mode;
+        sample.st_IsValid   = 0 != ( record.st_Flags & RECORD_FLAG_VALID );
+    }
+
+    return footer.st_Count;
+}
@@ -0,0 +1,182 @@
+/**
+ * \class sca3300RecordWriter
+ *
+ * \brief Binary recording of raw samples, appended through a memory map.
+ *
+ * File layout (little endian):
+ *  - sca3300RecordHeader (64 bytes): device serial, mode, sensitivity,
+ *    output data rate, start time, chunk geometry
+ *  - fixed size chunks: sca3300ChunkHeader (32 bytes), st_ChunkSamples
+ *    packed sca3300RecordSample (16 bytes: X, Y, Z, T counts, status and
+ *    the time offset to the chunk base), sca3300ChunkFooter (16 bytes,
+ *    sample count and CRC-32)
+ *
+ * The file is preallocated (fallocate) chunks ahead and only these chunks
+ * are mapped, a window sliding along the file, so appending a sample is a
+ * 16 bytes store and a recording may outgrow the address space. A chunk is sealed (footer
+ * written) when full, when the sequence has a gap or on Close(); a chunk
+ * without a valid footer is an interrupted recording and ends the file
+ * for sca3300RecordReader.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_RECORD_H_
+#define SCA3300_RECORD_H_
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  static_assert( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Recording format is little endian" );
+
+  constexpr uint16_t RECORD_VERSION = 1;
+
+  /**
+   * @brief      What the recording is about
+   */
+  struct sca3300RecordInfo
+  {
+    uint32_t st_DeviceId = 0;       /**< Component serial number (sca3300::GetSerial) */
+    uint8_t st_Mode = OPMODE1;      /**< operationMode at the start */
+    int32_t st_Sensitivity = 0;     /**< LSB/g of st_Mode */
+    float st_Odr = 0.0f;            /**< Output data rate (Hz) */
+    int64_t st_StartTime = 0;       /**< Wall clock at the start (ns, CLOCK_REALTIME) */
+  };
+
+  /**
+   * @brief      File header
+   */
+  struct sca3300RecordHeader
+  {
+    char st_Magic[8];               /**< "SCA3300R" */
+    uint16_t st_Version;
+    uint16_t st_HeaderSize;         /**< sizeof(sca3300RecordHeader) */
+    uint32_t st_ChunkSamples;       /**< Sample capacity of a chunk */
+    uint32_t st_ChunkSize;          /**< Bytes per chunk, header and footer included */
+    uint32_t st_DeviceId;
+    int32_t st_Sensitivity;
+    float st_Odr;
+    int64_t st_StartTime;
+    uint8_t st_Mode;
+    uint8_t st_Reserved[23];
+  };
+
+  /**
+   * @brief      Chunk header
+   */
+  struct sca3300ChunkHeader
+  {
+    uint32_t st_Magic;              /**< CHUNK_MAGIC */
+    uint32_t st_Index;              /**< Chunk number in the file */
+    int64_t st_BaseTimestamp;       /**< Timestamp of the first sample (ns) */
+    uint32_t st_FirstSequence;      /**< Sequence of the first sample, the next ones follow */
+    uint8_t st_Reserved[12];
+  };
+
+  /**
+   * @brief      One raw sample in a chunk
+   */
+  struct sca3300RecordSample
+  {
+    uint32_t st_TimeOffsetUs;       /**< From st_BaseTimestamp (µs) */
+    int16_t st_Accel[3];
+    uint16_t st_Temp;
+    uint16_t st_Status;
+    uint8_t st_Mode;
+    uint8_t st_Flags;               /**< RECORD_FLAG_VALID */
+  };
+
+  /**
+   * @brief      Chunk footer, written when the chunk is sealed
+   */
+  struct sca3300ChunkFooter
+  {
+    uint32_t st_Magic;              /**< CHUNK_FOOTER_MAGIC */
+    uint32_t st_Count;              /**< Samples in the chunk */
+    uint32_t st_Crc;                /**< CRC-32 of the chunk header and the st_Count samples */
+    uint32_t st_Reserved;
+  };
+
+  static_assert( sizeof(sca3300RecordHeader) == 64, "Record header layout" );
+  static_assert( sizeof(sca3300ChunkHeader) == 32, "Chunk header layout" );
+  static_assert( sizeof(sca3300RecordSample) == 16, "Record sample layout" );
+  static_assert( sizeof(sca3300ChunkFooter) == 16, "Chunk footer layout" );
+
+  uint32_t RecordCRC( const uint8_t *aData, const size_t aSize, const uint32_t aCrc = 0 );
+
+  class sca3300RecordWriter
+  {
+      public:
+          sca3300RecordWriter();
+          ~sca3300RecordWriter();
+
+          sca3300RecordWriter( const sca3300RecordWriter & ) = delete;
+          sca3300RecordWriter &operator=( const sca3300RecordWriter & ) = delete;
+
+          bool Open( const std::string &aPath, const sca3300RecordInfo &aInfo,
+                     const uint32_t aChunkSamples = 1024, const uint32_t aPreallocChunks = 64 );
+          bool Append( const sca3300RawSample *aSamples, const size_t aCount );
+          bool Flush( void );
+          bool Close( void );
+
+          bool IsOpen( void ) const { return this->fd >= 0; }
+          uint64_t GetSampleCount( void ) const { return this->nbSamples; }
+
+      private:
+          bool Grow( void );
+          uint8_t *Chunk( const uint32_t aIndex ) const;
+          void StartChunk( const sca3300RawSample &aFirst );
+          void SealChunk( void );
+
+          int fd;
+          uint8_t *map;                   /**< Window of the last preallocated chunks */
+          size_t mapSize;
+          off_t mapOffset;                /**< File offset of the window, page aligned */
+          uint32_t chunkSamples;
+          size_t chunkSize;
+          uint32_t preallocChunks;
+          uint32_t nbChunks;              /**< Chunks preallocated, the window ends there */
+
+          uint32_t chunkIndex;            /**< Chunk being filled */
+          uint32_t chunkCount;            /**< Samples in it, 0 if not started */
+          int64_t baseTimestamp;
+          uint32_t nextSequence;
+
+          uint64_t nbSamples;
+  };
+
+  class sca3300RecordReader
+  {
+      public:
+          sca3300RecordReader();
+          ~sca3300RecordReader();
+
+          sca3300RecordReader( const sca3300RecordReader & ) = delete;
+          sca3300RecordReader &operator=( const sca3300RecordReader & ) = delete;
+
+          bool Open( const std::string &aPath );
+          void Close( void );
+
+          const sca3300RecordInfo &GetInfo( void ) const { return this->info; }
+          uint32_t GetChunkSamples( void ) const { return this->chunkSamples; }
+          uint32_t GetChunkCount( void ) const { return this->nbChunks; }
+          size_t ReadChunk( const uint32_t aIndex, sca3300RawSample *aSamples ) const;
+
+      private:
+          int fd;
+          sca3300RecordInfo info;
+          uint32_t chunkSamples;
+          size_t chunkSize;
+          uint32_t nbChunks;              /**< Sealed chunks before the first invalid one */
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_RECORD_H_
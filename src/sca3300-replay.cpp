@@ -0,0 +1,244 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-replay.cpp
+ * @brief Recording played back as a sample stream
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <algorithm> // min...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-tools.h"
+#include "sca3300-replay.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Consts ********************************************** */
+#define REPLAY_SLICE_NS      10000000LL /* Longest sleep without checking Stop() */
+
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief   Default constructor, real time without loop.
+ */
+sca3300Replay::sca3300Replay()
+    : replayed( 0 )
+{
+    this->chunkIndex   = 0;
+    this->chunkCount   = 0;
+    this->position     = 0;
+    this->speed        = 1.0;
+    this->loop         = false;
+    this->anchored     = false;
+    this->wallOrigin   = 0;
+    this->recordOrigin = 0;
+}
+
+
+/**
+ * @brief    Destructor, stops the replay.
+ */
+sca3300Replay::~sca3300Replay()
+{
+    this->Stop();
+}
+
+
+/**
+ * @brief      Open a recording, the replay starts from its first sample.
+ *
+ * @param[in]  aPath  Recording written by sca3300RecordWriter
+ *
+ * @return     false while playing or if the file is not a recording
+ */
+bool sca3300Replay::Open( const std::string &aPath )
+{
+    if ( this->IsStreaming() )
+        return false;
+
+    if ( !this->reader.Open( aPath ) )
+        return false;
+
+    this->chunk.resize( this->reader.GetChunkSamples() );
+    this->chunkIndex = 0;
+    this->chunkCount = 0;
+    this->position   = 0;
+    this->replayed   = 0;
+
+    return true;
+}
+
+
+/**
+ * @brief      Header of the open recording.
+ */
+const sca3300RecordInfo &sca3300Replay::GetInfo( void ) const
+{
+    return this->reader.GetInfo();
+}
+
+
+/**
+ * @brief      Set the time scaling.
+ *
+ * @param[in]  aSpeed  Recorded time / replay time: 1 for real time, 0 as fast as possible
+ *
+ * @return     false while playing or if aSpeed is negative
+ */
+bool sca3300Replay::SetSpeed( const double aSpeed )
+{
+    if ( this->IsStreaming() || !( aSpeed >= 0.0 ) )
+        return false;
+
+    this->speed = aSpeed;
+
+    return true;
+}
+
+
+/**
+ * @brief      Restart from the first sample at the end of the recording?
+ *
+ * @return     false while playing
+ */
+bool sca3300Replay::SetLoop( const bool aLoop )
+{
+    if ( this->IsStreaming() )
+        return false;
+
+    this->loop = aLoop;
+
+    return true;
+}
+
+
+/**
+ * @brief      Start the replay thread.
+ *
+ * @note       Pacing comes from the recorded timestamps, so the thread runs
+ *             without sampling period (Start(0)).
+ *
+ * @param[in]  aCallback  Optional, called from the replay thread for every sample
+ *
+ * @return     false if already playing or nothing to play
+ */
+bool sca3300Replay::Play( sampleCallback aCallback )
+{
+    if ( 0 == this->reader.GetChunkCount() )
+    {
+        LOG_ERROR("nothing to replay");
+        return false;
+    }
+
+    this->anchored = false;
+
+    return this->Start( 0, aCallback );
+}
+
+
+/**
+ * @brief      Samples played since Open().
+ */
+uint64_t sca3300Replay::GetReplayedCount( void ) const
+{
+    return this->replayed;
+}
+
+
+/**
+ * @brief      Next recorded sample, reading the next chunk when needed
+ *
+ * @return     false at the end of the recording (without loop)
+ */
+bool sca3300Replay::NextSample( sca3300RawSample &aSample )
+{
+    while ( this->position >= this->chunkCount )
+    {
+        if ( this->chunkIndex >= this->reader.GetChunkCount() )
+        {
+            if ( !this->loop )
+                return false;
+
+            // Recorded time goes back: new origin
+            this->chunkIndex = 0;
+            this->anchored   = false;
+        }
+
+        this->chunkCount = this->reader.ReadChunk( this->chunkIndex++, this->chunk.data() );
+        this->position   = 0;
+    }
+
+    aSample = this->chunk[this->position++];
+
+    return true;
+}
+
+
+/**
+ * @brief      Play the next sample, at its scaled recorded time.
+ *
+ * @param[out] aSample  The recorded sample (sequence set by the caller)
+ *
+ * @return     Validity of the recorded sample
+ */
+bool sca3300Replay::AcquireSample( sca3300RawSample &aSample )
+{
+    sca3300RawSample sample;
+
+    // Lossless when not paced: the consumer sets the pace
+    if ( 0.0 == this->speed && !this->WaitRingSpace() )
+    {
+        this->EndOfStream();
+        return false;
+    }
+
+    if ( !this->NextSample( sample ) )
+    {
+        this->EndOfStream();
+        return false;
+    }
+
+    if ( this->speed > 0.0 )
+    {
+        if ( !this->anchored )
+        {
+            this->wallOrigin   = GetMonotonicNs();
+            this->recordOrigin = sample.st_Timestamp;
+            this->anchored     = true;
+        }
+
+        const int64_t deadline = this->wallOrigin + (int64_t)( ( sample.st_Timestamp - this->recordOrigin ) / this->speed );
+
+        // Slices: a gap in the recording (hours) must not hold Stop()
+        for (int64_t now = GetMonotonicNs(); now < deadline; now = GetMonotonicNs())
+        {
+            if ( !this->IsStreaming() )
+            {
+                this->EndOfStream();
+                return false;
+            }
+
+            SleepUntilNs( std::min<int64_t>( deadline, now + REPLAY_SLICE_NS ) );
+        }
+    }
+
+    aSample = sample;
+    this->replayed++;
+
+    return aSample.st_IsValid;
+}
@@ -0,0 +1,75 @@
+/**
+ * \class sca3300Replay
+ *
+ * \brief Recording (sca3300RecordWriter file) played back as a sample stream.
+ *
+ * A sca3300Stream like the live driver: Play() starts the acquisition
+ * thread, samples go to the ring, the latest sample and the callback.
+ * Samples keep their recorded timestamps, mode and status, the sequence
+ * is renumbered from 0. Pacing follows the recorded timestamps divided by
+ * the speed: 1 for real time, 100 for 100x, 0 as fast as possible. At
+ * the end of the recording the stream stops (IsStreaming() is false) or
+ * loops.
+ *
+ * \note As fast as possible means as fast as the ring is emptied: at
+ *       speed 0 the replay waits for PopSamples() instead of dropping
+ *       samples when the ring is full.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_REPLAY_H_
+#define SCA3300_REPLAY_H_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+#include "sca3300-record.h"
+
+namespace sca3300d01
+{
+  class sca3300Replay : public sca3300Stream
+  {
+      public:
+          sca3300Replay();
+          ~sca3300Replay();
+
+          bool Open( const std::string &aPath );
+          const sca3300RecordInfo &GetInfo( void ) const;
+
+          bool SetSpeed( const double aSpeed );
+          bool SetLoop( const bool aLoop );
+          bool Play( sampleCallback aCallback = nullptr );
+
+          uint64_t GetReplayedCount( void ) const;
+
+      protected:
+          bool AcquireSample( sca3300RawSample &aSample );
+
+      private:
+          bool NextSample( sca3300RawSample &aSample );
+
+          sca3300RecordReader reader;
+          std::vector<sca3300RawSample> chunk;
+          uint32_t chunkIndex;            /**< Next chunk to read */
+          size_t chunkCount;              /**< Samples in chunk */
+          size_t position;                /**< Next sample in chunk */
+
+          double speed;
+          bool loop;
+
+          bool anchored;                  /**< Wall clock origin set? */
+          int64_t wallOrigin;             /**< Monotonic time of the first sample played (ns) */
+          int64_t recordOrigin;           /**< Its recorded timestamp (ns) */
+
+          std::atomic<uint64_t> replayed;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_REPLAY_H_
@@ -0,0 +1,146 @@
+/**
+ * \class sca3300Ring
+ *
+ * \brief Wait-free single-producer / single-consumer ring buffer.
+ *
+ * The acquisition thread pushes, one consumer pops. Neither side ever
+ * blocks: a push on a full ring drops the sample and counts an overrun.
+ * Capacity is a power of two so indexes wrap with a mask. Producer and
+ * consumer indexes live on their own cache line and each side keeps a
+ * cached copy of the other index, so the shared lines are only touched
+ * when the cached value says the ring looks full (or empty).
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_RING_H_
+#define SCA3300_RING_H_
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300def.h"
+
+namespace sca3300d01
+{
+  template <typename T>
+  class sca3300Ring
+  {
+      public:
+          /**
+           * @brief      Constructor
+           *
+           * @param[in]  aCapacity  Number of elements, rounded up to a power of two
+           */
+          explicit sca3300Ring( const size_t aCapacity )
+              : head( 0 ), cachedTail( 0 ), tail( 0 ), cachedHead( 0 ), overruns( 0 )
+          {
+              size_t capacity = 1;
+              while ( capacity < aCapacity )
+                  capacity <<= 1;
+
+              this->mask   = capacity - 1;
+              this->buffer = std::unique_ptr<T[]>( new T[capacity] );
+          }
+
+          /**
+           * @brief      Producer side: append one element.
+           *
+           * @return     false (and one more overrun) if the ring is full
+           */
+          bool Push( const T &aValue )
+          {
+              const size_t h = this->head.load( std::memory_order_relaxed );
+
+              if ( h - this->cachedTail > this->mask )
+              {
+                  this->cachedTail = this->tail.load( std::memory_order_acquire );
+
+                  if ( h - this->cachedTail > this->mask )
+                  {
+                      this->overruns.fetch_add( 1, std::memory_order_relaxed );
+                      return false;
+                  }
+              }
+
+              this->buffer[h & this->mask] = aValue;
+              this->head.store( h + 1, std::memory_order_release );
+
+              return true;
+          }
+
+          /**
+           * @brief      Consumer side: remove up to aMax elements.
+           *
+           * @param[out] aOut  Destination
+           * @param[in]  aMax  Size of aOut
+           *
+           * @return     Number of elements copied to aOut
+           */
+          size_t Pop( T *aOut, const size_t aMax )
+          {
+              const size_t t = this->tail.load( std::memory_order_relaxed );
+
+              if ( this->cachedHead - t < aMax )
+                  this->cachedHead = this->head.load( std::memory_order_acquire );
+
+              size_t count = this->cachedHead - t;
+              if ( count > aMax )
+                  count = aMax;
+
+              for (size_t i = 0; i < count; ++i)
+                  aOut[i] = this->buffer[( t + i ) & this->mask];
+
+              this->tail.store( t + count, std::memory_order_release );
+
+              return count;
+          }
+
+          /**
+           * @brief      Number of elements waiting (approximate while both sides run).
+           */
+          size_t Size( void ) const
+          {
+              return this->head.load( std::memory_order_acquire ) - this->tail.load( std::memory_order_acquire );
+          }
+
+          size_t Capacity( void ) const
+          {
+              return this->mask + 1;
+          }
+
+          /**
+           * @brief      Elements dropped because the ring was full.
+           */
+          uint64_t GetOverruns( void ) const
+          {
+              return this->overruns.load( std::memory_order_relaxed );
+          }
+
+      private:
+          // Producer and consumer indexes are padded to a full cache line
+          // (padding instead of alignas: C++14 new ignores over-alignment)
+          static const size_t INDEX_PAD = SCA3300_CACHE_LINE_BYTES - sizeof(std::atomic<size_t>) - sizeof(size_t);
+
+          // Producer cache line
+          std::atomic<size_t> head;
+          size_t cachedTail;
+          char padHead[INDEX_PAD];
+
+          // Consumer cache line
+          std::atomic<size_t> tail;
+          size_t cachedHead;
+          char padTail[INDEX_PAD];
+
+          // Read-mostly
+          std::unique_ptr<T[]> buffer;
+          size_t mask;
+          std::atomic<uint64_t> overruns;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_RING_H_
@@ -0,0 +1,639 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-shm.cpp
+ * @brief Raw sample bus in POSIX shared memory (one publisher, many readers)
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <atomic>
+#include <new> // placement new
+#include <cstring> // memcpy...
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <signal.h> // kill
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-shm.h"
+#include "sca3300-latest.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Consts ********************************************** */
+static const char SHM_MAGIC[8] = { 'S', 'C', 'A', '3', '3', '0', '0', 'S' };
+
+#define SHM_SLOT_WORDS       7         /* 24 bytes sample, 32 bytes slot */
+#define SHM_MAX_CAPACITY     ( 1 << 24 ) /* samples */
+#define SHM_LATEST_ATTEMPTS  64        /* Latest sample copies per round */
+#define SHM_LATEST_ROUNDS    1000      /* Rounds (yield in between) before giving up */
+
+#define SHM_STATE_INIT       0         /* Publisher filling the header */
+#define SHM_STATE_LIVE       1
+#define SHM_STATE_CLOSED     2         /* Publisher gone, no more samples */
+
+static_assert( ATOMIC_INT_LOCK_FREE == 2, "Shared memory atomics must be lock free" );
+static_assert( sizeof(sca3300RawSample) <= SHM_SLOT_WORDS * sizeof(uint32_t), "Raw sample does not fit a slot" );
+
+/* ******** Definitions/Types *********************************************** */
+/**
+ * @brief      Start of the segment
+ *
+ * @note       The map is page aligned, so are the cache line aligned members.
+ */
+struct sca3300d01::sca3300ShmHeader
+{
+    char st_Magic[8];                       /**< "SCA3300S" */
+    uint16_t st_Version;
+    uint16_t st_HeaderSize;                 /**< sizeof(sca3300ShmHeader) */
+    uint32_t st_SlotSize;                   /**< sizeof(sca3300ShmSlot) */
+    uint32_t st_Capacity;                   /**< Slots, power of two */
+    sca3300RecordInfo st_Info;
+    int32_t st_Pid;                         /**< Publisher process */
+    std::atomic<uint32_t> st_State;         /**< SHM_STATE_xxx */
+
+    alignas( SCA3300_CACHE_LINE_BYTES )
+    std::atomic<uint32_t> st_Head;          /**< Samples published, modulo 2^32 */
+
+    alignas( SCA3300_CACHE_LINE_BYTES )
+    sca3300Latest<sca3300RawSample> st_Latest;
+};
+
+/**
+ * @brief      One ring slot, a seqlock of its own
+ */
+struct sca3300d01::sca3300ShmSlot
+{
+    std::atomic<uint32_t> st_Sequence;      /**< 2 * lap + 1 while written, 2 * lap + 2 once written */
+    std::atomic<uint32_t> st_Words[SHM_SLOT_WORDS];
+};
+
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      Ring offset in the segment
+ */
+static inline size_t SlotsOffset( void )
+{
+    return ( sizeof(sca3300ShmHeader) + SCA3300_CACHE_LINE_BYTES - 1 ) & ~( (size_t)SCA3300_CACHE_LINE_BYTES - 1 );
+}
+
+
+/**
+ * @brief      shm_open names are "/name", one component
+ */
+static inline bool IsValidName( const std::string &aName )
+{
+    return aName.size() > 1 && '/' == aName[0] && std::string::npos == aName.find( '/', 1 );
+}
+
+
+/**
+ * @brief      Does a process still exist? (it may belong to another user)
+ */
+static inline bool IsProcessAlive( const int32_t aPid )
+{
+    return aPid > 0 && ( 0 == kill( aPid, 0 ) || EPERM == errno );
+}
+
+
+/**
+ * @brief      Process publishing on a bus, if it is still running
+ *
+ * @return     Its pid, 0 if there is no segment, it is closed or its publisher died
+ */
+static int32_t LivePublisher( const std::string &aName )
+{
+    const int fd = shm_open( aName.c_str(), O_RDONLY, 0 );
+
+    if ( fd < 0 )
+        return 0;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+
+    if ( 0 == fstat( fd, &st ) && (size_t)st.st_size >= sizeof(sca3300ShmHeader) )
+        map = mmap( nullptr, sizeof(sca3300ShmHeader), PROT_READ, MAP_SHARED, fd, 0 );
+
+    close( fd );
+
+    if ( MAP_FAILED == map )
+        return 0;
+
+    const sca3300ShmHeader *header = (const sca3300ShmHeader *)map;
+    int32_t pid = 0;
+
+    if ( 0 == memcmp( header->st_Magic, SHM_MAGIC, sizeof(SHM_MAGIC) ) && SHM_VERSION == header->st_Version &&
+         sizeof(sca3300ShmHeader) == header->st_HeaderSize &&
+         SHM_STATE_LIVE == header->st_State.load( std::memory_order_acquire ) && IsProcessAlive( header->st_Pid ) )
+        pid = header->st_Pid;
+
+    munmap( map, sizeof(sca3300ShmHeader) );
+
+    return pid;
+}
+
+
+/*============================================================================*/
+/*                                 PUBLISHER                                  */
+/*============================================================================*/
+
+sca3300ShmPublisher::sca3300ShmPublisher()
+{
+    this->inode       = 0;
+    this->map         = nullptr;
+    this->mapSize     = 0;
+    this->header      = nullptr;
+    this->slots       = nullptr;
+    this->mask        = 0;
+    this->shift       = 0;
+    this->head        = 0;
+    this->nbPublished = 0;
+}
+
+
+sca3300ShmPublisher::~sca3300ShmPublisher()
+{
+    this->Close();
+}
+
+
+/**
+ * @brief      Create the segment.
+ *
+ * @note       A segment left by a previous publisher (crash) is replaced,
+ *             its readers keep the old one mapped and should reopen. The
+ *             segment of a running publisher is not: one bus, one publisher.
+ *
+ * @param[in]  aName      shm_open name, e.g. "/sca3300"
+ * @param[in]  aInfo      Device and acquisition settings, given to the readers
+ * @param[in]  aCapacity  Ring slots, rounded up to a power of two
+ *
+ * @return     false if the name is used by a running publisher or the
+ *             segment could not be created and mapped
+ */
+bool sca3300ShmPublisher::Open( const std::string &aName, const sca3300RecordInfo &aInfo, const uint32_t aCapacity )
+{
+    this->Close();
+
+    if ( !IsValidName( aName ) || 0 == aCapacity || aCapacity > SHM_MAX_CAPACITY )
+    {
+        LOG_ERROR("invalid shared memory bus: %s, %u samples", aName.c_str(), aCapacity);
+        return false;
+    }
+
+    uint32_t capacity = 2;
+    uint32_t shift    = 1;
+
+    while ( capacity < aCapacity )
+    {
+        capacity <<= 1;
+        shift++;
+    }
+
+    const int32_t owner = LivePublisher( aName );
+
+    if ( 0 != owner )
+    {
+        LOG_ERROR("%s is published by process %d", aName.c_str(), owner);
+        return false;
+    }
+
+    shm_unlink( aName.c_str() );
+
+    const int fd = shm_open( aName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644 );
+
+    if ( fd < 0 )
+    {
+        LOG_ERROR("could not create %s: %s", aName.c_str(), strerror( errno ));
+        return false;
+    }
+
+    const size_t size = SlotsOffset() + (size_t)capacity * sizeof(sca3300ShmSlot);
+    void *map = MAP_FAILED;
+    struct stat st;
+
+    if ( 0 == ftruncate( fd, size ) && 0 == fstat( fd, &st ) )
+        map = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+    // The mapping keeps the segment
+    close( fd );
+
+    if ( MAP_FAILED == map )
+    {
+        LOG_ERROR("could not map %s: %s", aName.c_str(), strerror( errno ));
+        shm_unlink( aName.c_str() );
+        return false;
+    }
+
+    this->name    = aName;
+    this->inode   = st.st_ino;
+    this->map     = (uint8_t *)map;
+    this->mapSize = size;
+    this->header  = new ( this->map ) sca3300ShmHeader();
+    this->slots   = (sca3300ShmSlot *)( this->map + SlotsOffset() );
+    this->mask    = capacity - 1;
+    this->shift   = shift;
+    this->head    = 0;
+    this->nbPublished = 0;
+
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        sca3300ShmSlot *slot = new ( &this->slots[i] ) sca3300ShmSlot();
+
+        slot->st_Sequence.store( 0, std::memory_order_relaxed );
+        for (int w = 0; w < SHM_SLOT_WORDS; ++w)
+            slot->st_Words[w].store( 0, std::memory_order_relaxed );
+    }
+
+    memcpy( this->header->st_Magic, SHM_MAGIC, sizeof(SHM_MAGIC) );
+    this->header->st_Version    = SHM_VERSION;
+    this->header->st_HeaderSize = sizeof(sca3300ShmHeader);
+    this->header->st_SlotSize   = sizeof(sca3300ShmSlot);
+    this->header->st_Capacity   = capacity;
+    this->header->st_Info       = aInfo;
+    this->header->st_Pid        = getpid();
+    this->header->st_Head.store( 0, std::memory_order_relaxed );
+
+    // Readers check the state before anything else
+    this->header->st_State.store( SHM_STATE_LIVE, std::memory_order_release );
+
+    return true;
+}
+
+
+/**
+ * @brief      Append a sample to the ring and make it the latest one.
+ *
+ * @note       Never waits: the oldest slot is overwritten, late readers
+ *             count the samples they missed. Only one thread may publish.
+ *
+ * @return     false if the segment is not open
+ */
+bool sca3300ShmPublisher::Publish( const sca3300RawSample &aSample )
+{
+    if ( nullptr == this->header )
+        return false;
+
+    uint32_t buffer[SHM_SLOT_WORDS] = { 0 };
+    memcpy( buffer, &aSample, sizeof(aSample) );
+
+    const uint32_t index = this->head;
+    const uint32_t lap   = index >> this->shift;
+    sca3300ShmSlot *slot = &this->slots[index & this->mask];
+
+    // Odd sequence: slot being rewritten
+    slot->st_Sequence.store( 2 * lap + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    for (int w = 0; w < SHM_SLOT_WORDS; ++w)
+        slot->st_Words[w].store( buffer[w], std::memory_order_relaxed );
+
+    slot->st_Sequence.store( 2 * lap + 2, std::memory_order_release );
+
+    this->head = index + 1;
+    this->header->st_Head.store( this->head, std::memory_order_release );
+    this->header->st_Latest.Publish( aSample );
+
+    this->nbPublished++;
+
+    return true;
+}
+
+
+/**
+ * @brief      Tell the readers the publisher is gone, remove the name.
+ *
+ * @note       Readers keep their mapping until they close it.
+ *
+ * @return     false if nothing was open
+ */
+bool sca3300ShmPublisher::Close( void )
+{
+    if ( nullptr == this->header )
+        return false;
+
+    this->header->st_State.store( SHM_STATE_CLOSED, std::memory_order_release );
+
+    munmap( this->map, this->mapSize );
+
+    // Unless a newer publisher replaced the segment
+    const int fd = shm_open( this->name.c_str(), O_RDONLY, 0 );
+
+    if ( fd >= 0 )
+    {
+        struct stat st;
+
+        if ( 0 == fstat( fd, &st ) && st.st_ino == this->inode )
+            shm_unlink( this->name.c_str() );
+
+        close( fd );
+    }
+
+    this->map     = nullptr;
+    this->mapSize = 0;
+    this->header  = nullptr;
+    this->slots   = nullptr;
+    this->name.clear();
+
+    return true;
+}
+
+
+/*============================================================================*/
+/*                                   READER                                   */
+/*============================================================================*/
+
+sca3300ShmReader::sca3300ShmReader()
+{
+    this->map     = nullptr;
+    this->mapSize = 0;
+    this->header  = nullptr;
+    this->slots   = nullptr;
+    this->mask    = 0;
+    this->shift   = 0;
+    this->cursor  = 0;
+    this->lost    = 0;
+}
+
+
+sca3300ShmReader::~sca3300ShmReader()
+{
+    this->Close();
+}
+
+
+/**
+ * @brief      Map a publisher segment, read-only.
+ *
+ * @note       Reading starts with the next published sample.
+ *
+ * @param[in]  aName  shm_open name given to sca3300ShmPublisher::Open()
+ *
+ * @return     false if there is no such bus (yet)
+ */
+bool sca3300ShmReader::Open( const std::string &aName )
+{
+    this->Close();
+
+    const int fd = IsValidName( aName ) ? shm_open( aName.c_str(), O_RDONLY, 0 ) : -1;
+
+    if ( fd < 0 )
+    {
+        LOG_ERROR("could not open %s: %s", aName.c_str(), strerror( errno ));
+        return false;
+    }
+
+    struct stat st;
+    void *map = MAP_FAILED;
+
+    if ( 0 == fstat( fd, &st ) && (size_t)st.st_size >= SlotsOffset() )
+        map = mmap( nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+    close( fd );
+
+    if ( MAP_FAILED == map )
+    {
+        LOG_ERROR("could not map %s", aName.c_str());
+        return false;
+    }
+
+    this->map     = (const uint8_t *)map;
+    this->mapSize = st.st_size;
+
+    const sca3300ShmHeader *header = (const sca3300ShmHeader *)this->map;
+
+    if ( SHM_STATE_INIT == header->st_State.load( std::memory_order_acquire ) )
+    {
+        LOG_ERROR("%s: publisher not ready", aName.c_str());
+        this->Close();
+        return false;
+    }
+
+    const uint32_t capacity = header->st_Capacity;
+
+    if ( 0 != memcmp( header->st_Magic, SHM_MAGIC, sizeof(SHM_MAGIC) ) || SHM_VERSION != header->st_Version ||
+         sizeof(sca3300ShmHeader) != header->st_HeaderSize || sizeof(sca3300ShmSlot) != header->st_SlotSize ||
+         capacity < 2 || capacity > SHM_MAX_CAPACITY || 0 != ( capacity & ( capacity - 1 ) ) ||
+         SlotsOffset() + (size_t)capacity * sizeof(sca3300ShmSlot) > this->mapSize )
+    {
+        LOG_ERROR("%s: unknown shared memory bus format", aName.c_str());
+        this->Close();
+        return false;
+    }
+
+    this->header = header;
+    this->slots  = (const sca3300ShmSlot *)( this->map + SlotsOffset() );
+    this->info   = header->st_Info;
+    this->mask   = capacity - 1;
+    this->shift  = 0;
+
+    while ( ( 1u << this->shift ) < capacity )
+        this->shift++;
+
+    this->cursor = header->st_Head.load( std::memory_order_acquire );
+    this->lost   = 0;
+
+    return true;
+}
+
+
+void sca3300ShmReader::Close( void )
+{
+    if ( nullptr != this->map )
+        munmap( (void *)this->map, this->mapSize );
+
+    this->map     = nullptr;
+    this->mapSize = 0;
+    this->header  = nullptr;
+    this->slots   = nullptr;
+    this->info    = sca3300RecordInfo();
+    this->mask    = 0;
+}
+
+
+/**
+ * @brief      Is the publisher still there? Once it is gone no sample comes.
+ *
+ * @note       A publisher killed without Close() leaves its segment live,
+ *             its process is checked as well.
+ */
+bool sca3300ShmReader::IsPublisherAlive( void ) const
+{
+    return nullptr != this->header && SHM_STATE_LIVE == this->header->st_State.load( std::memory_order_acquire ) &&
+           IsProcessAlive( this->header->st_Pid );
+}
+
+
+/**
+ * @brief      Samples waiting for this reader (approximate while publishing).
+ */
+size_t sca3300ShmReader::Available( void ) const
+{
+    if ( nullptr == this->header )
+        return 0;
+
+    const uint32_t pending = this->header->st_Head.load( std::memory_order_acquire ) - this->cursor;
+
+    // The slot being rewritten is not readable
+    return std::min( pending, this->mask );
+}
+
+
+/**
+ * @brief      Get the oldest samples not read yet, never blocks.
+ *
+ * @note       Each reader object has its own cursor, one thread per reader.
+ *             When the publisher laps the reader, the overwritten samples
+ *             are skipped and added to GetLost().
+ *
+ * @param[out] aSamples  Destination
+ * @param[in]  aMax      Size of aSamples
+ *
+ * @return     Number of samples copied
+ */
+size_t sca3300ShmReader::ReadRawSamples( sca3300RawSample *aSamples, const size_t aMax )
+{
+    if ( nullptr == this->header )
+        return 0;
+
+    uint32_t head  = this->header->st_Head.load( std::memory_order_acquire );
+    size_t   count = 0;
+
+    while ( count < aMax && head != this->cursor )
+    {
+        // Lapped: resume at the oldest slot the publisher is not rewriting
+        if ( head - this->cursor > this->mask )
+        {
+            const uint32_t skip = head - this->mask - this->cursor;
+
+            this->lost   += skip;
+            this->cursor += skip;
+        }
+
+        const sca3300ShmSlot *slot = &this->slots[this->cursor & this->mask];
+        const uint32_t expected = 2 * ( this->cursor >> this->shift ) + 2;
+
+        uint32_t buffer[SHM_SLOT_WORDS];
+
+        const uint32_t before = slot->st_Sequence.load( std::memory_order_acquire );
+
+        for (int w = 0; w < SHM_SLOT_WORDS; ++w)
+            buffer[w] = slot->st_Words[w].load( std::memory_order_relaxed );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        const uint32_t after = slot->st_Sequence.load( std::memory_order_relaxed );
+
+        if ( before != expected || after != expected )
+        {
+            // Rewritten meanwhile: the new head tells how far to skip
+            const uint32_t latest = this->header->st_Head.load( std::memory_order_acquire );
+
+            if ( latest - this->cursor <= this->mask )
+                break; // Head store not visible yet, try again on the next call
+
+            head = latest;
+            continue;
+        }
+
+        memcpy( &aSamples[count++], buffer, sizeof(sca3300RawSample) );
+        this->cursor++;
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief      Get the oldest samples not read yet, converted, never blocks.
+ *
+ * @see        ReadRawSamples
+ */
+size_t sca3300ShmReader::ReadSamples( sca3300Sample *aSamples, const size_t aMax )
+{
+    sca3300RawSample raw[64];
+    size_t count = 0;
+
+    while ( count < aMax )
+    {
+        const size_t chunk = this->ReadRawSamples( raw, std::min( aMax - count, sizeof(raw) / sizeof(raw[0]) ) );
+
+        for (size_t i = 0; i < chunk; ++i)
+            ConvertSample( raw[i], aSamples[count + i] );
+
+        count += chunk;
+
+        if ( 0 == chunk )
+            break;
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief      Get the last published sample as raw counts, whatever the cursor.
+ *
+ * @note       Never blocks for good: a publisher killed while publishing
+ *             leaves the seqlock odd, the read gives up once the publisher
+ *             is not live anymore, or after SHM_LATEST_ROUNDS rounds (a
+ *             killed process does not close the bus).
+ *
+ * @return     false if nothing has been published yet or no consistent sample could be read
+ */
+bool sca3300ShmReader::GetLatestRaw( sca3300RawSample &aSample ) const
+{
+    if ( nullptr == this->header || !this->header->st_Latest.IsPublished() )
+        return false;
+
+    for (int round = 0; round < SHM_LATEST_ROUNDS; ++round)
+    {
+        if ( this->header->st_Latest.TryRead( aSample, SHM_LATEST_ATTEMPTS ) )
+            return true;
+
+        if ( !this->IsPublisherAlive() )
+            break;
+
+        // Publisher preempted in Publish()?
+        sched_yield();
+    }
+
+    LOG_ERROR("no consistent latest sample: publisher interrupted");
+    return false;
+}
+
+
+/**
+ * @brief      Get the last published sample, whatever the cursor.
+ *
+ * @return     false if nothing has been published yet
+ */
+bool sca3300ShmReader::GetLatest( sca3300Sample &aSample ) const
+{
+    sca3300RawSample raw;
+
+    if ( !this->GetLatestRaw( raw ) )
+        return false;
+
+    ConvertSample( raw, aSample );
+
+    return true;
+}
@@ -0,0 +1,118 @@
+/**
+ * \class sca3300ShmPublisher
+ *
+ * \brief Raw samples shared with other processes through POSIX shared memory.
+ *
+ * One process owns the SPI device and publishes, any number of local
+ * processes map the segment read-only and consume the samples without a
+ * system call or a socket copy.
+ *
+ * Segment layout (shm_open name, e.g. "/sca3300"):
+ *  - header: magic, geometry, sca3300RecordInfo of the device, publisher
+ *    process and state, write index (own cache line) and a sca3300Latest seqlock with
+ *    the last sample
+ *  - ring of st_Capacity slots (power of two), one raw sample each, every
+ *    slot with its own seqlock sequence (2 * lap + 1 while written,
+ *    2 * lap + 2 once written)
+ *
+ * The publisher never waits: readers cannot write to the segment, so each
+ * sca3300ShmReader keeps its own cursor. A reader which falls more than
+ * st_Capacity samples behind is moved to the oldest sample still in the
+ * ring and the skipped samples are counted in GetLost().
+ *
+ *     sca3300ShmPublisher bus;
+ *     bus.Open( "/sca3300", info );
+ *     chip.SetRawCallback( [&bus]( const sca3300RawSample &s ){ bus.Publish( s ); } );
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_SHM_H_
+#define SCA3300_SHM_H_
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+#include "sca3300-record.h"
+
+namespace sca3300d01
+{
+  constexpr uint16_t SHM_VERSION = 2;
+  constexpr uint32_t SHM_DEFAULT_CAPACITY = 4096;
+
+  struct sca3300ShmHeader;
+  struct sca3300ShmSlot;
+
+  class sca3300ShmPublisher
+  {
+      public:
+          sca3300ShmPublisher();
+          ~sca3300ShmPublisher();
+
+          sca3300ShmPublisher( const sca3300ShmPublisher & ) = delete;
+          sca3300ShmPublisher &operator=( const sca3300ShmPublisher & ) = delete;
+
+          bool Open( const std::string &aName, const sca3300RecordInfo &aInfo,
+                     const uint32_t aCapacity = SHM_DEFAULT_CAPACITY );
+          bool Publish( const sca3300RawSample &aSample );
+          bool Close( void );
+
+          bool IsOpen( void ) const { return nullptr != this->header; }
+          uint64_t GetPublishedCount( void ) const { return this->nbPublished; }
+
+      private:
+          std::string name;
+          uint64_t inode;                 /**< Of the segment, to unlink only ours */
+          uint8_t *map;
+          size_t mapSize;
+          sca3300ShmHeader *header;
+          sca3300ShmSlot *slots;
+          uint32_t mask;
+          uint32_t shift;                 /**< log2 of the capacity: lap = index >> shift */
+          uint32_t head;                  /**< Next index, only the publisher writes it */
+          uint64_t nbPublished;
+  };
+
+  class sca3300ShmReader
+  {
+      public:
+          sca3300ShmReader();
+          ~sca3300ShmReader();
+
+          sca3300ShmReader( const sca3300ShmReader & ) = delete;
+          sca3300ShmReader &operator=( const sca3300ShmReader & ) = delete;
+
+          bool Open( const std::string &aName );
+          void Close( void );
+
+          bool IsOpen( void ) const { return nullptr != this->header; }
+          bool IsPublisherAlive( void ) const;
+          const sca3300RecordInfo &GetInfo( void ) const { return this->info; }
+          uint32_t GetCapacity( void ) const { return this->mask + 1; }
+
+          size_t Available( void ) const;
+          size_t ReadRawSamples( sca3300RawSample *aSamples, const size_t aMax );
+          size_t ReadSamples( sca3300Sample *aSamples, const size_t aMax );
+          uint64_t GetLost( void ) const { return this->lost; }
+
+          bool GetLatestRaw( sca3300RawSample &aSample ) const;
+          bool GetLatest( sca3300Sample &aSample ) const;
+
+      private:
+          const uint8_t *map;
+          size_t mapSize;
+          const sca3300ShmHeader *header;
+          const sca3300ShmSlot *slots;
+          sca3300RecordInfo info;
+          uint32_t mask;
+          uint32_t shift;
+          uint32_t cursor;                /**< Next index to read */
+          uint64_t lost;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_SHM_H_
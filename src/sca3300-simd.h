@@ -0,0 +1,149 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-simd.h
+ * @brief Four float lanes: SSE2, NEON, or plain C++ on other targets
+ *
+ * One lane per channel (X, Y, Z, temperature or unused), so the filters
+ * of the four channels run with the instructions of one.
+ *
+ */
+
+#ifndef SCA3300_SIMD_H_
+#define SCA3300_SIMD_H_
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#else
+#include <math.h>
+#endif
+
+namespace sca3300d01
+{
+  struct v4f
+  {
+#if defined(__SSE2__)
+      __m128 st_V;
+
+      static inline v4f Load( const float *aPtr ) { return { _mm_loadu_ps( aPtr ) }; }
+      static inline v4f Set1( const float aValue ) { return { _mm_set1_ps( aValue ) }; }
+      inline void Store( float *aPtr ) const { _mm_storeu_ps( aPtr, this->st_V ); }
+
+      friend inline v4f operator+( const v4f aA, const v4f aB ) { return { _mm_add_ps( aA.st_V, aB.st_V ) }; }
+      friend inline v4f operator-( const v4f aA, const v4f aB ) { return { _mm_sub_ps( aA.st_V, aB.st_V ) }; }
+      friend inline v4f operator*( const v4f aA, const v4f aB ) { return { _mm_mul_ps( aA.st_V, aB.st_V ) }; }
+      friend inline v4f operator/( const v4f aA, const v4f aB ) { return { _mm_div_ps( aA.st_V, aB.st_V ) }; }
+
+      static inline v4f Sqrt( const v4f aA ) { return { _mm_sqrt_ps( aA.st_V ) }; }
+      static inline v4f Min( const v4f aA, const v4f aB ) { return { _mm_min_ps( aA.st_V, aB.st_V ) }; }
+      static inline v4f Max( const v4f aA, const v4f aB ) { return { _mm_max_ps( aA.st_V, aB.st_V ) }; }
+      static inline v4f Abs( const v4f aA ) { return { _mm_andnot_ps( _mm_set1_ps( -0.0f ), aA.st_V ) }; }
+
+      /** Lanes of aValue with the sign of aSign */
+      static inline v4f CopySign( const v4f aValue, const v4f aSign )
+      {
+          const __m128 sign = _mm_set1_ps( -0.0f );
+          return { _mm_or_ps( _mm_andnot_ps( sign, aValue.st_V ), _mm_and_ps( sign, aSign.st_V ) ) };
+      }
+
+      /** aA > aB ? aIfTrue : aIfFalse, per lane */
+      static inline v4f SelectGreater( const v4f aA, const v4f aB, const v4f aIfTrue, const v4f aIfFalse )
+      {
+          const __m128 mask = _mm_cmpgt_ps( aA.st_V, aB.st_V );
+          return { _mm_or_ps( _mm_and_ps( mask, aIfTrue.st_V ), _mm_andnot_ps( mask, aIfFalse.st_V ) ) };
+      }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+      float32x4_t st_V;
+
+      static inline v4f Load( const float *aPtr ) { return { vld1q_f32( aPtr ) }; }
+      static inline v4f Set1( const float aValue ) { return { vdupq_n_f32( aValue ) }; }
+      inline void Store( float *aPtr ) const { vst1q_f32( aPtr, this->st_V ); }
+
+      friend inline v4f operator+( const v4f aA, const v4f aB ) { return { vaddq_f32( aA.st_V, aB.st_V ) }; }
+      friend inline v4f operator-( const v4f aA, const v4f aB ) { return { vsubq_f32( aA.st_V, aB.st_V ) }; }
+      friend inline v4f operator*( const v4f aA, const v4f aB ) { return { vmulq_f32( aA.st_V, aB.st_V ) }; }
+#if defined(__aarch64__)
+      friend inline v4f operator/( const v4f aA, const v4f aB ) { return { vdivq_f32( aA.st_V, aB.st_V ) }; }
+
+      static inline v4f Sqrt( const v4f aA ) { return { vsqrtq_f32( aA.st_V ) }; }
+#else
+      // ARMv7: reciprocal estimates refined by two Newton-Raphson steps
+      friend inline v4f operator/( const v4f aA, const v4f aB )
+      {
+          float32x4_t inv = vrecpeq_f32( aB.st_V );
+          inv = vmulq_f32( inv, vrecpsq_f32( aB.st_V, inv ) );
+          inv = vmulq_f32( inv, vrecpsq_f32( aB.st_V, inv ) );
+          return { vmulq_f32( aA.st_V, inv ) };
+      }
+
+      static inline v4f Sqrt( const v4f aA )
+      {
+          float32x4_t inv = vrsqrteq_f32( aA.st_V );
+          inv = vmulq_f32( inv, vrsqrtsq_f32( vmulq_f32( aA.st_V, inv ), inv ) );
+          inv = vmulq_f32( inv, vrsqrtsq_f32( vmulq_f32( aA.st_V, inv ), inv ) );
+          // sqrt(0) = 0 * inf otherwise
+          return { vbslq_f32( vcgtq_f32( aA.st_V, vdupq_n_f32( 0.0f ) ), vmulq_f32( aA.st_V, inv ), vdupq_n_f32( 0.0f ) ) };
+      }
+#endif
+      static inline v4f Min( const v4f aA, const v4f aB ) { return { vminq_f32( aA.st_V, aB.st_V ) }; }
+      static inline v4f Max( const v4f aA, const v4f aB ) { return { vmaxq_f32( aA.st_V, aB.st_V ) }; }
+      static inline v4f Abs( const v4f aA ) { return { vabsq_f32( aA.st_V ) }; }
+
+      /** Lanes of aValue with the sign of aSign */
+      static inline v4f CopySign( const v4f aValue, const v4f aSign )
+      {
+          return { vbslq_f32( vdupq_n_u32( 0x80000000 ), aSign.st_V, aValue.st_V ) };
+      }
+
+      /** aA > aB ? aIfTrue : aIfFalse, per lane */
+      static inline v4f SelectGreater( const v4f aA, const v4f aB, const v4f aIfTrue, const v4f aIfFalse )
+      {
+          return { vbslq_f32( vcgtq_f32( aA.st_V, aB.st_V ), aIfTrue.st_V, aIfFalse.st_V ) };
+      }
+#else
+      float st_V[4];
+
+      static inline v4f Load( const float *aPtr ) { return { { aPtr[0], aPtr[1], aPtr[2], aPtr[3] } }; }
+      static inline v4f Set1( const float aValue ) { return { { aValue, aValue, aValue, aValue } }; }
+      inline void Store( float *aPtr ) const { for (int i = 0; i < 4; ++i) aPtr[i] = this->st_V[i]; }
+
+      friend inline v4f operator+( const v4f aA, const v4f aB )
+      { return { { aA.st_V[0] + aB.st_V[0], aA.st_V[1] + aB.st_V[1], aA.st_V[2] + aB.st_V[2], aA.st_V[3] + aB.st_V[3] } }; }
+      friend inline v4f operator-( const v4f aA, const v4f aB )
+      { return { { aA.st_V[0] - aB.st_V[0], aA.st_V[1] - aB.st_V[1], aA.st_V[2] - aB.st_V[2], aA.st_V[3] - aB.st_V[3] } }; }
+      friend inline v4f operator*( const v4f aA, const v4f aB )
+      { return { { aA.st_V[0] * aB.st_V[0], aA.st_V[1] * aB.st_V[1], aA.st_V[2] * aB.st_V[2], aA.st_V[3] * aB.st_V[3] } }; }
+      friend inline v4f operator/( const v4f aA, const v4f aB )
+      { return { { aA.st_V[0] / aB.st_V[0], aA.st_V[1] / aB.st_V[1], aA.st_V[2] / aB.st_V[2], aA.st_V[3] / aB.st_V[3] } }; }
+
+      static inline v4f Sqrt( const v4f aA )
+      { return { { sqrtf( aA.st_V[0] ), sqrtf( aA.st_V[1] ), sqrtf( aA.st_V[2] ), sqrtf( aA.st_V[3] ) } }; }
+      static inline v4f Min( const v4f aA, const v4f aB )
+      { return { { fminf( aA.st_V[0], aB.st_V[0] ), fminf( aA.st_V[1], aB.st_V[1] ), fminf( aA.st_V[2], aB.st_V[2] ), fminf( aA.st_V[3], aB.st_V[3] ) } }; }
+      static inline v4f Max( const v4f aA, const v4f aB )
+      { return { { fmaxf( aA.st_V[0], aB.st_V[0] ), fmaxf( aA.st_V[1], aB.st_V[1] ), fmaxf( aA.st_V[2], aB.st_V[2] ), fmaxf( aA.st_V[3], aB.st_V[3] ) } }; }
+      static inline v4f Abs( const v4f aA )
+      { return { { fabsf( aA.st_V[0] ), fabsf( aA.st_V[1] ), fabsf( aA.st_V[2] ), fabsf( aA.st_V[3] ) } }; }
+
+      /** Lanes of aValue with the sign of aSign */
+      static inline v4f CopySign( const v4f aValue, const v4f aSign )
+      {
+          return { { copysignf( aValue.st_V[0], aSign.st_V[0] ), copysignf( aValue.st_V[1], aSign.st_V[1] ),
+                     copysignf( aValue.st_V[2], aSign.st_V[2] ), copysignf( aValue.st_V[3], aSign.st_V[3] ) } };
+      }
+
+      /** aA > aB ? aIfTrue : aIfFalse, per lane */
+      static inline v4f SelectGreater( const v4f aA, const v4f aB, const v4f aIfTrue, const v4f aIfFalse )
+      {
+          v4f result;
+          for (int i = 0; i < 4; ++i)
+              result.st_V[i] = ( aA.st_V[i] > aB.st_V[i] ) ? aIfTrue.st_V[i] : aIfFalse.st_V[i];
+          return result;
+      }
+#endif
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_SIMD_H_
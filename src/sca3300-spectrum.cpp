@@ -0,0 +1,457 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-spectrum.cpp
+ * @brief Real FFT and Welch power spectral density of the sample stream
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <math.h>
+#include <algorithm> // min, fill...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-spectrum.h"
+#include "sca3300-simd.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+#define FFT_MIN_SIZE 8
+#define FFT_MAX_SIZE ( 1 << 20 )
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/*============================================================================*/
+/*                                    FFT                                     */
+/*============================================================================*/
+
+/**
+ * @brief      Precompute the tables of a transform size.
+ *
+ * @param[in]  aSize  Number of real points, power of 2 from 8 to 2^20
+ *
+ * @return     false if aSize is not supported (nothing changed)
+ */
+bool sca3300Fft::Init( const size_t aSize )
+{
+    if ( aSize < FFT_MIN_SIZE || aSize > FFT_MAX_SIZE || 0 != ( aSize & ( aSize - 1 ) ) )
+    {
+        LOG_ERROR("invalid FFT size %zu", aSize);
+        return false;
+    }
+
+    const size_t half = aSize / 2;
+    int bits = 0;
+
+    while ( ( (size_t)1 << bits ) < half )
+        ++bits;
+
+    this->size = aSize;
+
+    this->reverse.resize( half );
+    for (size_t n = 0; n < half; ++n)
+    {
+        uint32_t reversed = 0;
+        for (int b = 0; b < bits; ++b)
+            reversed |= ( ( n >> b ) & 1 ) << ( bits - 1 - b );
+        this->reverse[n] = reversed;
+    }
+
+    this->twiddleRe.resize( half / 2 );
+    this->twiddleIm.resize( half / 2 );
+    for (size_t k = 0; k < half / 2; ++k)
+    {
+        this->twiddleRe[k] = (float)cos( 2.0 * M_PI * k / half );
+        this->twiddleIm[k] = (float)-sin( 2.0 * M_PI * k / half );
+    }
+
+    this->splitRe.resize( half + 1 );
+    this->splitIm.resize( half + 1 );
+    for (size_t k = 0; k <= half; ++k)
+    {
+        this->splitRe[k] = (float)cos( 2.0 * M_PI * k / aSize );
+        this->splitIm[k] = (float)-sin( 2.0 * M_PI * k / aSize );
+    }
+
+    this->re.assign( half * NB_LANES, 0.0f );
+    this->im.assign( half * NB_LANES, 0.0f );
+    this->outRe.assign( ( half + 1 ) * NB_LANES, 0.0f );
+    this->outIm.assign( ( half + 1 ) * NB_LANES, 0.0f );
+
+    return true;
+}
+
+
+/**
+ * @brief      Transform N real frames
+ *
+ * @param[in]  aFrames  N frames of NB_LANES floats
+ * @param[out] aRe      N / 2 + 1 frames, real part of the bins
+ * @param[out] aIm      N / 2 + 1 frames, imaginary part of the bins
+ */
+void sca3300Fft::Forward( const float *aFrames, float *aRe, float *aIm )
+{
+    const size_t half = this->size / 2;
+    float *re = this->re.data();
+    float *im = this->im.data();
+
+    // z[n] = x[2n] + i x[2n+1], in bit reversed order
+    for (size_t n = 0; n < half; ++n)
+    {
+        const size_t to = this->reverse[n] * NB_LANES;
+
+        v4f::Load( aFrames + 2 * n * NB_LANES ).Store( re + to );
+        v4f::Load( aFrames + ( 2 * n + 1 ) * NB_LANES ).Store( im + to );
+    }
+
+    // Radix-2 decimation in time, 4 lanes per butterfly
+    for (size_t length = 2; length <= half; length <<= 1)
+    {
+        const size_t span = length / 2;
+        const size_t step = half / length;
+
+        for (size_t start = 0; start < half; start += length)
+        {
+            for (size_t j = 0; j < span; ++j)
+            {
+                const size_t a = ( start + j ) * NB_LANES;
+                const size_t b = a + span * NB_LANES;
+
+                const v4f wr = v4f::Set1( this->twiddleRe[j * step] );
+                const v4f wi = v4f::Set1( this->twiddleIm[j * step] );
+
+                const v4f br = v4f::Load( re + b );
+                const v4f bi = v4f::Load( im + b );
+                const v4f tr = wr * br - wi * bi;
+                const v4f ti = wr * bi + wi * br;
+
+                const v4f ar = v4f::Load( re + a );
+                const v4f ai = v4f::Load( im + a );
+
+                ( ar - tr ).Store( re + b );
+                ( ai - ti ).Store( im + b );
+                ( ar + tr ).Store( re + a );
+                ( ai + ti ).Store( im + a );
+            }
+        }
+    }
+
+    // Split: X[k] = (Z[k] + Z*[M-k]) / 2 + W^k (Z[k] - Z*[M-k]) / 2i
+    const v4f oneHalf = v4f::Set1( 0.5f );
+
+    for (size_t k = 0; k <= half; ++k)
+    {
+        const size_t p = ( k % half ) * NB_LANES;
+        const size_t q = ( ( half - k ) % half ) * NB_LANES;
+
+        const v4f a = v4f::Load( re + p ), b = v4f::Load( im + p );
+        const v4f c = v4f::Load( re + q ), d = v4f::Load( im + q );
+
+        const v4f evenRe = ( a + c ) * oneHalf;
+        const v4f evenIm = ( b - d ) * oneHalf;
+        const v4f oddRe  = ( b + d ) * oneHalf;
+        const v4f oddIm  = ( c - a ) * oneHalf;
+
+        const v4f wr = v4f::Set1( this->splitRe[k] );
+        const v4f wi = v4f::Set1( this->splitIm[k] );
+
+        ( evenRe + wr * oddRe - wi * oddIm ).Store( aRe + k * NB_LANES );
+        ( evenIm + wr * oddIm + wi * oddRe ).Store( aIm + k * NB_LANES );
+    }
+}
+
+
+/**
+ * @brief      Squared magnitude of the bins of N real frames
+ *
+ * @param[in]  aFrames  N frames of NB_LANES floats
+ * @param[out] aPower   N / 2 + 1 frames, |X[k]|²
+ */
+void sca3300Fft::Power( const float *aFrames, float *aPower )
+{
+    this->Forward( aFrames, this->outRe.data(), this->outIm.data() );
+
+    for (size_t k = 0; k <= this->size / 2; ++k)
+    {
+        const v4f xr = v4f::Load( this->outRe.data() + k * NB_LANES );
+        const v4f xi = v4f::Load( this->outIm.data() + k * NB_LANES );
+
+        ( xr * xr + xi * xi ).Store( aPower + k * NB_LANES );
+    }
+}
+
+
+/*============================================================================*/
+/*                                   WELCH                                    */
+/*============================================================================*/
+
+/**
+ * @brief   Default constructor, Configure() before use.
+ */
+sca3300Spectrum::sca3300Spectrum()
+{
+    this->sampleRate = 0.0f;
+    this->segment    = 0;
+    this->hop        = 0;
+    this->average    = 0;
+    this->scale      = 0.0f;
+
+    this->Reset();
+}
+
+
+/**
+ * @brief      Set the averaging.
+ *
+ * @param[in]  aSampleRate  Sampling rate (Hz)
+ * @param[in]  aSegment     Samples per segment, power of 2 (FFT size)
+ * @param[in]  aOverlap     Samples shared by two segments, below aSegment
+ * @param[in]  aAverage     Segments averaged per PSD
+ * @param[in]  aWindow      Window applied to each segment
+ *
+ * @return     false if a parameter is out of range (nothing changed)
+ */
+bool sca3300Spectrum::Configure( const float aSampleRate, const size_t aSegment, const size_t aOverlap,
+                                 const size_t aAverage, const spectrumWindow aWindow )
+{
+    if ( !( aSampleRate > 0.0f ) || aOverlap >= aSegment || 0 == aAverage )
+    {
+        LOG_ERROR("invalid Welch settings: %.3f Hz, segment %zu, overlap %zu, average %zu",
+                  aSampleRate, aSegment, aOverlap, aAverage);
+        return false;
+    }
+
+    if ( WINDOW_RECTANGULAR != aWindow && WINDOW_HANN != aWindow && WINDOW_HAMMING != aWindow )
+    {
+        LOG_ERROR("unknown window %d", aWindow);
+        return false;
+    }
+
+    if ( !this->fft.Init( aSegment ) )
+        return false;
+
+    this->sampleRate = aSampleRate;
+    this->segment    = aSegment;
+    this->hop        = aSegment - aOverlap;
+    this->average    = aAverage;
+
+    // Periodic windows, as for spectral analysis
+    double sumSquares = 0.0;
+    this->window.resize( aSegment );
+
+    for (size_t n = 0; n < aSegment; ++n)
+    {
+        const double phase = 2.0 * M_PI * n / aSegment;
+
+        switch ( aWindow )
+        {
+            case WINDOW_HANN:    this->window[n] = (float)( 0.5 - 0.5 * cos( phase ) ); break;
+            case WINDOW_HAMMING: this->window[n] = (float)( 0.54 - 0.46 * cos( phase ) ); break;
+            default:             this->window[n] = 1.0f; break;
+        }
+
+        sumSquares += (double)this->window[n] * this->window[n];
+    }
+
+    this->scale = (float)( 1.0 / ( aSampleRate * sumSquares ) );
+
+    this->history.resize( 2 * aSegment * NB_LANES );
+    this->frames.resize( aSegment * NB_LANES );
+    this->power.resize( ( aSegment / 2 + 1 ) * NB_LANES );
+    this->accumulated.resize( ( aSegment / 2 + 1 ) * NB_LANES );
+
+    this->Reset();
+
+    return true;
+}
+
+
+/**
+ * @brief      Forget every sample and the last PSD.
+ */
+void sca3300Spectrum::Reset( void )
+{
+    std::fill( this->history.begin(), this->history.end(), 0.0f );
+    std::fill( this->accumulated.begin(), this->accumulated.end(), 0.0f );
+
+    this->position   = 0;
+    this->countdown  = this->segment;
+    this->consumed   = 0;
+    this->nbSegments = 0;
+    this->psd        = sca3300Psd();
+    this->hasPsd     = false;
+}
+
+
+/**
+ * @brief      Account the last segment, close the PSD after aAverage segments
+ */
+void sca3300Spectrum::ProcessSegment( void )
+{
+    const size_t length = this->segment;
+    const float *last   = this->history.data() + this->position * NB_LANES; // oldest first
+
+    // Constant detrend: gravity would leak in the low bins otherwise
+    v4f sum = v4f::Set1( 0.0f );
+    for (size_t n = 0; n < length; ++n)
+        sum = sum + v4f::Load( last + n * NB_LANES );
+
+    const v4f mean = sum * v4f::Set1( 1.0f / length );
+
+    for (size_t n = 0; n < length; ++n)
+        ( ( v4f::Load( last + n * NB_LANES ) - mean ) * v4f::Set1( this->window[n] ) ).Store( &this->frames[n * NB_LANES] );
+
+    this->fft.Power( this->frames.data(), this->power.data() );
+
+    for (size_t i = 0; i < this->power.size(); ++i)
+        this->accumulated[i] += this->power[i];
+
+    if ( ++this->nbSegments < this->average )
+        return;
+
+    // One-sided density: every bin but DC and Nyquist counts twice
+    const size_t nbBins = length / 2 + 1;
+    const float normalization = this->scale / this->nbSegments;
+
+    this->psd.st_Resolution = this->sampleRate / length;
+    this->psd.st_Segments   = this->nbSegments;
+    this->psd.st_LastSample = this->consumed;
+
+    for (int axe = 0; axe < 3; ++axe)
+        this->psd.st_Accel[axe].resize( nbBins );
+    this->psd.st_Temp.resize( nbBins );
+
+    for (size_t k = 0; k < nbBins; ++k)
+    {
+        const float factor = ( 0 == k || nbBins - 1 == k ) ? normalization : 2.0f * normalization;
+        const float *bin = &this->accumulated[k * NB_LANES];
+
+        for (int axe = 0; axe < 3; ++axe)
+            this->psd.st_Accel[axe][k] = bin[axe] * factor;
+        this->psd.st_Temp[k] = bin[3] * factor;
+    }
+
+    std::fill( this->accumulated.begin(), this->accumulated.end(), 0.0f );
+    this->nbSegments = 0;
+    this->hasPsd = true;
+}
+
+
+/**
+ * @brief      Consume frames up to the end of the current PSD period.
+ *
+ * @note       Stops right after the frame that completes a PSD, so no PSD
+ *             is ever overwritten before the caller could read it.
+ *
+ * @param[in]  aFrames  Frames of NB_LANES floats (X, Y, Z, T)
+ * @param[in]  aCount   Number of frames
+ * @param[out] aReady   true if a new PSD is available (GetPsd)
+ *
+ * @return     Number of frames consumed
+ */
+size_t sca3300Spectrum::Add( const float *aFrames, const size_t aCount, bool &aReady )
+{
+    aReady = false;
+
+    if ( 0 == this->segment )
+        return 0;
+
+    float *history = this->history.data();
+
+    for (size_t n = 0; n < aCount; ++n)
+    {
+        // Delay line written twice, so the last segment is always contiguous
+        const v4f frame = v4f::Load( aFrames + n * NB_LANES );
+
+        frame.Store( history + this->position * NB_LANES );
+        frame.Store( history + ( this->position + this->segment ) * NB_LANES );
+
+        this->position = ( this->position + 1 ) % this->segment;
+        this->consumed++;
+
+        if ( --this->countdown > 0 )
+            continue;
+
+        this->countdown = this->hop;
+        this->ProcessSegment();
+
+        if ( 0 == this->nbSegments )
+        {
+            aReady = true;
+            return n + 1;
+        }
+    }
+
+    return aCount;
+}
+
+
+/**
+ * @brief      Consume samples up to the end of the current PSD period.
+ *
+ * @note       Invalid samples are accounted as the others.
+ *
+ * @param[in]  aSamples  The samples
+ * @param[in]  aCount    Number of samples
+ * @param[out] aReady    true if a new PSD is available (GetPsd)
+ *
+ * @return     Number of samples consumed
+ */
+size_t sca3300Spectrum::Add( const sca3300Sample *aSamples, const size_t aCount, bool &aReady )
+{
+    const size_t CHUNK = 64;
+    float chunk[CHUNK * NB_LANES];
+    size_t done = 0;
+
+    aReady = false;
+
+    while ( done < aCount && !aReady )
+    {
+        const size_t count = std::min( CHUNK, aCount - done );
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            chunk[i * NB_LANES + 0] = aSamples[done + i].st_Accel[0];
+            chunk[i * NB_LANES + 1] = aSamples[done + i].st_Accel[1];
+            chunk[i * NB_LANES + 2] = aSamples[done + i].st_Accel[2];
+            chunk[i * NB_LANES + 3] = aSamples[done + i].st_Temp;
+        }
+
+        const size_t consumed = this->Add( chunk, count, aReady );
+        done += consumed;
+
+        if ( 0 == consumed )
+            break;
+    }
+
+    return done;
+}
+
+
+/**
+ * @brief      Last complete PSD.
+ *
+ * @param[out] aPsd  The PSD
+ *
+ * @return     false if no averaging period is complete yet
+ */
+bool sca3300Spectrum::GetPsd( sca3300Psd &aPsd ) const
+{
+    if ( this->hasPsd )
+        aPsd = this->psd;
+
+    return this->hasPsd;
+}
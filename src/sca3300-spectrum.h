@@ -0,0 +1,117 @@
+/**
+ * \class sca3300Spectrum
+ *
+ * \brief Power spectral density of the sample stream (Welch method).
+ *
+ * Samples are consumed incrementally. Every (segment - overlap) samples
+ * the last segment is detrended (mean removed), windowed and transformed;
+ * the power spectra of aAverage segments are averaged into one PSD
+ * (one-sided, g²/Hz). X, Y, Z and the temperature are the four lanes of
+ * the same real FFT (sca3300Fft), so the four spectra cost one.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_SPECTRUM_H_
+#define SCA3300_SPECTRUM_H_
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  enum spectrumWindow
+  {
+    WINDOW_RECTANGULAR,
+    WINDOW_HANN,
+    WINDOW_HAMMING,
+  };
+
+  /**
+   * @brief      One-sided PSD, bin k at k * st_Resolution Hz
+   */
+  struct sca3300Psd
+  {
+    float st_Resolution = 0.0f;      /**< Bin width (Hz) */
+    uint32_t st_Segments = 0;        /**< Segments averaged */
+    uint64_t st_LastSample = 0;      /**< Samples consumed since Reset() at the end of the period */
+    std::vector<float> st_Accel[3];  /**< X, Y, Z (g²/Hz), segment / 2 + 1 bins */
+    std::vector<float> st_Temp;      /**< Temperature (°C²/Hz) */
+  };
+
+  /**
+   * @brief      Real FFT of 4 channels at once (radix-2, precomputed twiddles)
+   *
+   * @note       A real transform of N points is a complex one of N / 2
+   *             points on (even, odd) pairs, then one split pass.
+   */
+  class sca3300Fft
+  {
+      public:
+          static const int NB_LANES = 4;
+
+          bool Init( const size_t aSize );
+          size_t GetSize( void ) const { return this->size; }
+
+          void Forward( const float *aFrames, float *aRe, float *aIm );
+          void Power( const float *aFrames, float *aPower );
+
+      private:
+          size_t size = 0;                /**< Real points N, power of 2 */
+          std::vector<uint32_t> reverse;  /**< Bit reversal of the N / 2 complex points */
+          std::vector<float> twiddleRe;   /**< exp(-2 i pi k / (N / 2)), k < N / 4 */
+          std::vector<float> twiddleIm;
+          std::vector<float> splitRe;     /**< exp(-2 i pi k / N), k <= N / 2 */
+          std::vector<float> splitIm;
+          std::vector<float> re;          /**< Work buffers, N / 2 frames */
+          std::vector<float> im;
+          std::vector<float> outRe;       /**< N / 2 + 1 frames */
+          std::vector<float> outIm;
+  };
+
+  class sca3300Spectrum
+  {
+      public:
+          static const int NB_LANES = sca3300Fft::NB_LANES; // X, Y, Z, temperature
+
+          sca3300Spectrum();
+
+          bool Configure( const float aSampleRate, const size_t aSegment, const size_t aOverlap,
+                          const size_t aAverage, const spectrumWindow aWindow = WINDOW_HANN );
+          size_t Add( const float *aFrames, const size_t aCount, bool &aReady );
+          size_t Add( const sca3300Sample *aSamples, const size_t aCount, bool &aReady );
+          bool GetPsd( sca3300Psd &aPsd ) const;
+          void Reset( void );
+
+      private:
+          void ProcessSegment( void );
+
+          float sampleRate;
+          size_t segment;                 /**< Samples per segment (power of 2) */
+          size_t hop;                     /**< segment - overlap */
+          size_t average;                 /**< Segments per PSD */
+          std::vector<float> window;
+          float scale;                    /**< 1 / (sample rate * sum of squared window) */
+
+          sca3300Fft fft;
+          std::vector<float> history;     /**< Two copies of the last segment (frames) */
+          size_t position;
+          size_t countdown;               /**< Samples before the next segment */
+          uint64_t consumed;
+
+          std::vector<float> frames;      /**< Windowed segment */
+          std::vector<float> power;
+          std::vector<float> accumulated; /**< Sum of the power spectra of the period */
+          uint32_t nbSegments;
+
+          sca3300Psd psd;
+          bool hasPsd;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_SPECTRUM_H_
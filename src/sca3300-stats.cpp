@@ -0,0 +1,284 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-stats.cpp
+ * @brief Streaming statistics of the acquired samples
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <math.h>
+#include <algorithm> // min, max...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-stats.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/*============================================================================*/
+/*                                  MOMENTS                                   */
+/*============================================================================*/
+
+/**
+ * @brief      Account one value (Welford update)
+ */
+void sca3300Moments::Add( const double aValue )
+{
+    if ( 0 == this->count )
+    {
+        this->min = aValue;
+        this->max = aValue;
+    }
+    else
+    {
+        this->min = std::min( this->min, aValue );
+        this->max = std::max( this->max, aValue );
+    }
+
+    this->count++;
+
+    const double delta = aValue - this->mean;
+    this->mean += delta / this->count;
+    this->m2   += delta * ( aValue - this->mean );
+
+    this->sumSq += aValue * aValue;
+}
+
+
+/**
+ * @brief      Account the values of another accumulator
+ *
+ * @note       Pairwise combination of Chan et al., as accurate as Add().
+ */
+void sca3300Moments::Merge( const sca3300Moments &aOther )
+{
+    if ( 0 == aOther.count )
+        return;
+
+    if ( 0 == this->count )
+    {
+        *this = aOther;
+        return;
+    }
+
+    const double n     = (double)( this->count + aOther.count );
+    const double delta = aOther.mean - this->mean;
+
+    this->mean += delta * aOther.count / n;
+    this->m2   += aOther.m2 + delta * delta * this->count * aOther.count / n;
+
+    this->count += aOther.count;
+    this->sumSq += aOther.sumSq;
+    this->min    = std::min( this->min, aOther.min );
+    this->max    = std::max( this->max, aOther.max );
+}
+
+
+void sca3300Moments::Reset( void )
+{
+    *this = sca3300Moments();
+}
+
+
+/**
+ * @brief      Current statistics
+ */
+sca3300ChannelStats sca3300Moments::Get( void ) const
+{
+    sca3300ChannelStats stats;
+
+    if ( 0 == this->count )
+        return stats;
+
+    stats.st_Count    = this->count;
+    stats.st_Mean     = this->mean;
+    stats.st_Variance = this->m2 / this->count;
+    stats.st_Min      = this->min;
+    stats.st_Max      = this->max;
+    stats.st_Rms      = sqrt( this->sumSq / this->count );
+
+    return stats;
+}
+
+
+/*============================================================================*/
+/*                                 AGGREGATE                                  */
+/*============================================================================*/
+
+void sca3300Stats::aggregate::Add( const sca3300Sample &aSample )
+{
+    if ( !aSample.st_IsValid )
+    {
+        this->invalid++;
+        return;
+    }
+
+    if ( 0 == this->channels[0].GetCount() )
+        this->firstTimestamp = aSample.st_Timestamp;
+    this->lastTimestamp = aSample.st_Timestamp;
+
+    for (int axe = 0; axe < 3; ++axe)
+        this->channels[axe].Add( aSample.st_Accel[axe] );
+
+    this->channels[3].Add( aSample.st_Temp );
+}
+
+
+/**
+ * @brief      Account an aggregate of later samples
+ */
+void sca3300Stats::aggregate::Merge( const aggregate &aOther )
+{
+    if ( 0 == this->channels[0].GetCount() )
+        this->firstTimestamp = aOther.firstTimestamp;
+    if ( 0 != aOther.channels[0].GetCount() )
+        this->lastTimestamp = aOther.lastTimestamp;
+
+    for (int i = 0; i < NB_CHANNELS; ++i)
+        this->channels[i].Merge( aOther.channels[i] );
+
+    this->invalid += aOther.invalid;
+}
+
+
+sca3300SampleStats sca3300Stats::aggregate::Get( void ) const
+{
+    sca3300SampleStats stats;
+
+    for (int axe = 0; axe < 3; ++axe)
+        stats.st_Accel[axe] = this->channels[axe].Get();
+
+    stats.st_Temp           = this->channels[3].Get();
+    stats.st_Invalid        = this->invalid;
+    stats.st_FirstTimestamp = this->firstTimestamp;
+    stats.st_LastTimestamp  = this->lastTimestamp;
+
+    return stats;
+}
+
+
+/*============================================================================*/
+/*                                   STATS                                    */
+/*============================================================================*/
+
+/**
+ * @brief   Constructor.
+ *
+ * @note    aWindow must be a multiple of aPanes. Otherwise the windowing
+ *          is rejected: IsValid() returns false, only cumulative
+ *          statistics are kept and GetWindowLength() is 0.
+ *
+ * @param[in]   aWindow  { Samples per window, 0 for cumulative statistics only }
+ * @param[in]   aPanes   { 1 for tumbling windows, K > 1 for a window sliding by aWindow / K samples }
+ */
+sca3300Stats::sca3300Stats( const size_t aWindow, const size_t aPanes )
+{
+    this->nbPanes    = std::max( aPanes, (size_t)1 );
+    this->paneLength = aWindow / this->nbPanes;
+    this->valid      = ( 0 == aWindow % this->nbPanes );
+
+    if ( !this->valid )
+    {
+        LOG_ERROR("window of %zu samples can not be cut in %zu panes", aWindow, this->nbPanes);
+        this->paneLength = 0;
+    }
+
+    this->panes.resize( this->nbPanes );
+    this->Reset();
+}
+
+
+/**
+ * @brief      Forget every sample.
+ */
+void sca3300Stats::Reset( void )
+{
+    for (aggregate &pane : this->panes)
+        pane = aggregate();
+
+    this->paneIndex     = 0;
+    this->nbComplete    = 0;
+    this->current       = aggregate();
+    this->currentLength = 0;
+    this->total         = aggregate();
+    this->window        = sca3300SampleStats();
+    this->hasWindow     = false;
+}
+
+
+/**
+ * @brief      Account a sample.
+ *
+ * @note       O(1), except when a sliding window closes: O(number of panes).
+ *
+ * @param[in]  aSample  The sample, invalid samples are only counted
+ *
+ * @return     true if a new window is available (GetWindow)
+ */
+bool sca3300Stats::Add( const sca3300Sample &aSample )
+{
+    this->total.Add( aSample );
+
+    if ( 0 == this->paneLength )
+        return false;
+
+    this->current.Add( aSample );
+
+    if ( ++this->currentLength < this->paneLength )
+        return false;
+
+    // Pane complete
+    this->panes[this->paneIndex] = this->current;
+    this->paneIndex = ( this->paneIndex + 1 ) % this->nbPanes;
+    this->nbComplete = std::min( this->nbComplete + 1, this->nbPanes );
+
+    this->current = aggregate();
+    this->currentLength = 0;
+
+    if ( this->nbComplete < this->nbPanes )
+        return false;
+
+    // Merge from the oldest pane, which is the next one to be overwritten
+    aggregate merged;
+    for (size_t i = 0; i < this->nbPanes; ++i)
+        merged.Merge( this->panes[( this->paneIndex + i ) % this->nbPanes] );
+
+    this->window    = merged.Get();
+    this->hasWindow = true;
+
+    return true;
+}
+
+
+/**
+ * @brief      Statistics of the last complete window.
+ *
+ * @param[out] aStats  The statistics
+ *
+ * @return     false if no window is complete yet
+ */
+bool sca3300Stats::GetWindow( sca3300SampleStats &aStats ) const
+{
+    if ( this->hasWindow )
+        aStats = this->window;
+
+    return this->hasWindow;
+}
+
+
+/**
+ * @brief      Statistics of every sample since Reset().
+ */
+sca3300SampleStats sca3300Stats::GetTotal( void ) const
+{
+    return this->total.Get();
+}
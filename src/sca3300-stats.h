@@ -0,0 +1,133 @@
+/**
+ * \class sca3300Stats
+ *
+ * \brief Streaming statistics of the acquired samples.
+ *
+ * Every sample updates count, mean and variance (Welford), min, max and
+ * RMS of each axis and of the temperature, in O(1) time and memory.
+ * Results are given per window:
+ *  - cumulative (window of 0 samples): everything since Reset()
+ *  - tumbling (1 pane): consecutive, non overlapping windows
+ *  - sliding (K panes): the window is cut in K panes, it slides by one
+ *    pane and is the merge of the K last pane aggregates, so memory stays
+ *    O(K) whatever the sampling rate.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_STATS_H_
+#define SCA3300_STATS_H_
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300-stream.h"
+
+namespace sca3300d01
+{
+  /**
+   * @brief      Statistics of one channel
+   */
+  struct sca3300ChannelStats
+  {
+    uint64_t st_Count = 0;      /**< Number of values */
+    double st_Mean = 0.0;
+    double st_Variance = 0.0;   /**< Population variance */
+    double st_Min = 0.0;
+    double st_Max = 0.0;
+    double st_Rms = 0.0;        /**< Root mean square */
+  };
+
+  /**
+   * @brief      Statistics of a window of samples
+   */
+  struct sca3300SampleStats
+  {
+    sca3300ChannelStats st_Accel[3]; /**< Acceleration X, Y, Z (g) */
+    sca3300ChannelStats st_Temp;     /**< Temperature (°C) */
+    uint64_t st_Invalid = 0;         /**< Invalid samples, not accounted */
+    int64_t st_FirstTimestamp = 0;   /**< First valid sample of the window (ns) */
+    int64_t st_LastTimestamp = 0;    /**< Last valid sample of the window (ns) */
+  };
+
+  /**
+   * @brief      Welford accumulator, mergeable (Chan et al.)
+   */
+  class sca3300Moments
+  {
+      public:
+          void Add( const double aValue );
+          void Merge( const sca3300Moments &aOther );
+          void Reset( void );
+          sca3300ChannelStats Get( void ) const;
+
+          uint64_t GetCount( void ) const { return this->count; }
+
+      private:
+          uint64_t count = 0;
+          double mean = 0.0;
+          double m2 = 0.0;    /**< Sum of squared differences to the mean */
+          double sumSq = 0.0; /**< Sum of squares, for the RMS */
+          double min = 0.0;
+          double max = 0.0;
+  };
+
+  class sca3300Stats
+  {
+      public:
+          explicit sca3300Stats( const size_t aWindow = 0, const size_t aPanes = 1 );
+
+          bool Add( const sca3300Sample &aSample );
+          bool GetWindow( sca3300SampleStats &aStats ) const;
+          sca3300SampleStats GetTotal( void ) const;
+          void Reset( void );
+
+          /**
+           * @brief      Samples per window, 0 for cumulative statistics only
+           */
+          size_t GetWindowLength( void ) const { return this->paneLength * this->nbPanes; }
+
+          /**
+           * @brief      False when the window given to the constructor was rejected
+           */
+          bool IsValid( void ) const { return this->valid; }
+
+      private:
+          static const int NB_CHANNELS = 4; // X, Y, Z, temperature
+
+          /**
+           * @brief      Aggregate of a pane (or of everything since Reset)
+           */
+          struct aggregate
+          {
+            sca3300Moments channels[NB_CHANNELS];
+            uint64_t invalid = 0;
+            int64_t firstTimestamp = 0;
+            int64_t lastTimestamp = 0;
+
+            void Add( const sca3300Sample &aSample );
+            void Merge( const aggregate &aOther );
+            sca3300SampleStats Get( void ) const;
+          };
+
+          size_t paneLength;   /**< Samples per pane, 0 for cumulative only */
+          size_t nbPanes;
+          bool valid;          /**< The requested window was accepted */
+
+          std::vector<aggregate> panes; /**< The nbPanes last complete panes (circular) */
+          size_t paneIndex;             /**< Next pane to overwrite */
+          size_t nbComplete;            /**< Complete panes, up to nbPanes */
+
+          aggregate current;            /**< Pane being filled */
+          size_t currentLength;         /**< Samples in the current pane */
+
+          aggregate total;              /**< Since Reset() */
+          sca3300SampleStats window;    /**< Last complete window */
+          bool hasWindow;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_STATS_H_
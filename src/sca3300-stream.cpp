@@ -0,0 +1,338 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-stream.cpp
+ * @brief Continuous sample acquisition thread
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <algorithm> // min...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300-tools.h"
+#include "sca3300-stream.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/**
+ * @brief      Convert a raw sample (g, °C)
+ *
+ * @param[in]  aRaw     The raw sample
+ * @param[out] aSample  The converted sample
+ */
+void sca3300d01::ConvertSample( const sca3300RawSample &aRaw, sca3300Sample &aSample )
+{
+    const sca3300Scale scale = GetModeScale( (operationMode)aRaw.st_Mode );
+
+    aSample.st_Timestamp = aRaw.st_Timestamp;
+    aSample.st_Sequence  = aRaw.st_Sequence;
+
+    for (int axe = 0; axe < 3; ++axe)
+        aSample.st_Accel[axe] = ProcessAccel( aRaw.st_Accel[axe], scale.st_Sensitivity );
+
+    aSample.st_Temp    = ConvertTemperature( aRaw.st_Temp );
+    aSample.st_Status  = aRaw.st_Status;
+    aSample.st_IsValid = aRaw.st_IsValid;
+}
+
+
+/**
+ * @brief   Default constructor.
+ */
+sca3300Stream::sca3300Stream()
+    : running( false ), ended( false ), periodUs( 0 ),
+      ring( new sca3300Ring<sca3300RawSample>( SCA3300_RING_CAPACITY ) ), missedDeadlines( 0 )
+{
+}
+
+
+/**
+ * @brief    Destructor, stops the acquisition.
+ */
+sca3300Stream::~sca3300Stream()
+{
+    this->Stop();
+}
+
+
+/**
+ * @brief      Start the acquisition thread.
+ *
+ * @param[in]  aPeriodUs  Sampling period, 0 to acquire as fast as possible
+ * @param[in]  aCallback  Optional, called from the acquisition thread for every sample
+ *
+ * @return     false if already streaming
+ */
+bool sca3300Stream::Start( const uint32_t aPeriodUs, sampleCallback aCallback )
+{
+    if ( this->running )
+        return false;
+
+    // Thread ended by EndOfStream()
+    if ( this->thread.joinable() )
+        this->thread.join();
+
+    this->periodUs = aPeriodUs;
+    this->callback = aCallback;
+    this->missedDeadlines = 0;
+    this->ended   = false;
+    this->running = true;
+
+    this->thread = std::thread( &sca3300Stream::AcquisitionLoop, this );
+
+    return true;
+}
+
+
+/**
+ * @brief      Stop the acquisition thread and wait for it.
+ */
+void sca3300Stream::Stop( void )
+{
+    this->running = false;
+
+    if ( this->thread.joinable() )
+        this->thread.join();
+}
+
+
+/**
+ * @brief      Is the acquisition thread running?
+ */
+bool sca3300Stream::IsStreaming( void ) const
+{
+    return this->running;
+}
+
+
+/**
+ * @brief      Forward every sample as raw counts, e.g. to a sca3300ShmPublisher.
+ *
+ * @param[in]  aCallback  Called from the acquisition thread, before the
+ *                        sampleCallback, nullptr to remove it
+ *
+ * @return     false while streaming
+ */
+bool sca3300Stream::SetRawCallback( rawSampleCallback aCallback )
+{
+    if ( this->running )
+        return false;
+
+    this->rawCallback = aCallback;
+
+    return true;
+}
+
+
+/**
+ * @brief      Resize the sample ring.
+ *
+ * @param[in]  aCapacity  Number of samples, rounded up to a power of two
+ *
+ * @return     false while streaming
+ */
+bool sca3300Stream::SetRingCapacity( const size_t aCapacity )
+{
+    if ( this->running )
+        return false;
+
+    this->ring.reset( new sca3300Ring<sca3300RawSample>( aCapacity ) );
+
+    return true;
+}
+
+
+/**
+ * @brief      Get the oldest acquired samples, never blocks.
+ *
+ * @note       Only one thread may consume the ring.
+ *
+ * @param[out] aSamples  Destination
+ * @param[in]  aMax      Size of aSamples
+ *
+ * @return     Number of samples copied
+ */
+size_t sca3300Stream::PopSamples( sca3300Sample *aSamples, const size_t aMax )
+{
+    sca3300RawSample raw[64];
+    size_t count = 0;
+
+    while ( count < aMax )
+    {
+        const size_t chunk = this->ring->Pop( raw, std::min( aMax - count, sizeof(raw) / sizeof(raw[0]) ) );
+
+        for (size_t i = 0; i < chunk; ++i)
+            ConvertSample( raw[i], aSamples[count + i] );
+
+        count += chunk;
+
+        if ( 0 == chunk )
+            break;
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief      Get the oldest acquired samples as raw counts, never blocks.
+ *
+ * @note       Only one thread may consume the ring.
+ *
+ * @param[out] aSamples  Destination
+ * @param[in]  aMax      Size of aSamples
+ *
+ * @return     Number of samples copied
+ */
+size_t sca3300Stream::PopRawSamples( sca3300RawSample *aSamples, const size_t aMax )
+{
+    return this->ring->Pop( aSamples, aMax );
+}
+
+
+/**
+ * @brief      Samples dropped because the consumer did not empty the ring.
+ */
+uint64_t sca3300Stream::GetOverruns( void ) const
+{
+    return this->ring->GetOverruns();
+}
+
+
+/**
+ * @brief      Most recent sample acquired by the thread.
+ *
+ * @note       Wait-free, callable from any thread while streaming.
+ *
+ * @param[out] aSample  The sample
+ *
+ * @return     false if no sample has been acquired yet
+ */
+bool sca3300Stream::GetLatest( sca3300Sample &aSample ) const
+{
+    sca3300RawSample raw;
+
+    if ( !this->latest.Read( raw ) )
+        return false;
+
+    ConvertSample( raw, aSample );
+
+    return true;
+}
+
+
+/**
+ * @brief      Most recent sample acquired by the thread, as raw counts.
+ *
+ * @note       Wait-free, callable from any thread while streaming.
+ *
+ * @param[out] aSample  The sample
+ *
+ * @return     false if no sample has been acquired yet
+ */
+bool sca3300Stream::GetLatestRaw( sca3300RawSample &aSample ) const
+{
+    return this->latest.Read( aSample );
+}
+
+
+/**
+ * @brief      Periods skipped because an acquisition took longer than the period.
+ */
+uint64_t sca3300Stream::GetMissedDeadlines( void ) const
+{
+    return this->missedDeadlines;
+}
+
+
+/**
+ * @brief      Wait until the ring can take one more sample, called from
+ *             AcquireSample() by sources that must not drop samples.
+ *
+ * @note       Polls every 100 µs: the consumer does not signal the producer.
+ *
+ * @return     false if Stop() was called while waiting
+ */
+bool sca3300Stream::WaitRingSpace( void )
+{
+    // From the producer, Size() can only be over estimated
+    while ( this->running && this->ring->Size() >= this->ring->Capacity() )
+        SleepUntilNs( GetMonotonicNs() + 100000 );
+
+    return this->running;
+}
+
+
+/**
+ * @brief      Acquisition thread body.
+ *
+ * @details    Deadlines are absolute: deadline(n) = start + n * period.
+ *             When an acquisition overruns, the late periods are skipped
+ *             (and counted) instead of being acquired in a burst.
+ */
+void sca3300Stream::AcquisitionLoop( void )
+{
+    const int64_t period = (int64_t)this->periodUs * 1000;
+
+    int64_t  deadline = GetMonotonicNs();
+    uint32_t sequence = 0;
+
+    while ( this->running )
+    {
+        sca3300RawSample sample;
+
+        sample.st_Timestamp = GetMonotonicNs();
+        this->AcquireSample( sample );
+        sample.st_Sequence  = sequence++;
+
+        // A sample read while Stop() was called is still delivered
+        if ( this->ended )
+            break;
+
+        this->ring->Push( sample );
+        this->latest.Publish( sample );
+
+        if ( this->rawCallback )
+            this->rawCallback( sample );
+
+        // Only the callback needs a conversion on this thread
+        if ( this->callback )
+        {
+            sca3300Sample converted;
+            ConvertSample( sample, converted );
+            this->callback( converted );
+        }
+
+        if ( 0 == period || !this->running )
+            continue;
+
+        deadline += period;
+
+        const int64_t now = GetMonotonicNs();
+        if ( now >= deadline )
+        {
+            const int64_t late = ( now - deadline ) / period + 1;
+
+            this->missedDeadlines += late;
+            deadline += late * period;
+        }
+
+        SleepUntilNs( deadline );
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * \class sca3300Stream
+ *
+ * \brief Continuous sample acquisition on a dedicated thread.
+ *
+ * Start() spawns a thread which acquires one sample per period and pushes
+ * it to a wait-free SPSC ring read with PopSamples(), to a seqlock read
+ * by any number of threads with GetLatest(), and to an optional callback.
+ * Wake-ups are scheduled on absolute CLOCK_MONOTONIC deadlines so the
+ * sampling period does not drift. Derived classes only provide
+ * AcquireSample().
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_STREAM_H_
+#define SCA3300_STREAM_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <stdint.h>
+
+#include "sca3300def.h"
+#include "sca3300-ring.h"
+#include "sca3300-latest.h"
+
+/**
+ * @brief      One complete measurement cycle (X, Y, Z, temperature, status)
+ */
+struct sca3300Sample
+{
+  int64_t st_Timestamp = 0;            /**< Acquisition time (ns, CLOCK_MONOTONIC) */
+  uint32_t st_Sequence = 0;            /**< Sample number since Start() */
+  float st_Accel[3] = {0.0, 0.0, 0.0}; /**< Acceleration X, Y, Z (g) */
+  float st_Temp = 0.0;                 /**< Temperature (°C) */
+  uint16_t st_Status = 0;              /**< STATUS register content */
+  bool st_IsValid = false;             /**< Every frame of the cycle is valid? */
+};
+
+/**
+ * @brief      One measurement cycle as read from the device, integer only
+ *
+ * @note       Raw counts are what the acquisition thread stores, they are
+ *             converted only when a sca3300Sample is asked for.
+ */
+struct sca3300RawSample
+{
+  int64_t st_Timestamp = 0;            /**< Acquisition time (ns, CLOCK_MONOTONIC) */
+  uint32_t st_Sequence = 0;            /**< Sample number since Start() */
+  int16_t st_Accel[3] = {0, 0, 0};     /**< Acceleration X, Y, Z (counts, see GetModeScale) */
+  uint16_t st_Temp = 0;                /**< Raw temperature */
+  uint16_t st_Status = 0;              /**< STATUS register content */
+  uint8_t st_Mode = OPMODE1;           /**< operationMode of the acceleration counts */
+  bool st_IsValid = false;             /**< Every frame of the cycle is valid? */
+};
+
+namespace sca3300d01
+{
+  typedef std::function<void( const sca3300Sample & )> sampleCallback;
+  typedef std::function<void( const sca3300RawSample & )> rawSampleCallback;
+
+  void ConvertSample( const sca3300RawSample &aRaw, sca3300Sample &aSample );
+
+  class sca3300Stream
+  {
+      public:
+          sca3300Stream();
+          virtual ~sca3300Stream();
+
+          bool Start( const uint32_t aPeriodUs, sampleCallback aCallback = nullptr );
+          void Stop( void );
+          bool IsStreaming( void ) const;
+          bool SetRawCallback( rawSampleCallback aCallback );
+
+          // Single consumer side of the sample ring
+          bool SetRingCapacity( const size_t aCapacity );
+          size_t PopSamples( sca3300Sample *aSamples, const size_t aMax );
+          size_t PopRawSamples( sca3300RawSample *aSamples, const size_t aMax );
+          uint64_t GetOverruns( void ) const;
+
+          // Any number of readers, no bus access
+          bool GetLatest( sca3300Sample &aSample ) const;
+          bool GetLatestRaw( sca3300RawSample &aSample ) const;
+
+          uint64_t GetMissedDeadlines( void ) const;
+
+      protected:
+          /**
+           * @brief      Acquire one sample, called from the acquisition thread.
+           *
+           * @note       A derived class must call Stop() in its destructor.
+           *
+           * @param[out] aSample  The sample. Timestamp is preset to the acquisition
+           *                      start and may be overwritten, sequence is set by the caller
+           *
+           * @return     true if the sample is valid
+           */
+          virtual bool AcquireSample( sca3300RawSample &aSample ) = 0;
+
+          /**
+           * @brief      No more samples: called from AcquireSample(), the
+           *             acquisition thread ends without storing that sample.
+           */
+          void EndOfStream( void ) { this->ended = true; this->running = false; }
+
+          bool WaitRingSpace( void );
+
+      private:
+          std::thread       thread;
+          std::atomic<bool> running;
+          bool              ended;      /**< EndOfStream() called, acquisition thread only */
+          uint32_t          periodUs;
+          sampleCallback    callback;
+          rawSampleCallback rawCallback;
+
+          std::unique_ptr< sca3300Ring<sca3300RawSample> > ring;
+          sca3300Latest<sca3300RawSample> latest;
+
+          std::atomic<uint64_t> missedDeadlines;
+
+          void AcquisitionLoop( void );
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_STREAM_H_
@@ -11,6 +11,14 @@
 /*============================================================================*/
 /* ******** Includes/System ************************************************* */
 #include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 /* *********Includes/functions prototypes *********************************** */
 #include "sca3300def.h"
@@ -21,6 +29,83 @@
 /*============================================================================*/
 using namespace sca3300d01;
 
+/* SCA3300_ERRORS is indexed by bit number */
+static_assert( GetResetRequiredMask() == 0x0386, "Unexpected reset required flags" );
+static_assert( SCA3300_ERRORS[SCA3300_ERR_DIGI1_BIT].bit == SCA3300_ERR_DIGI1_BIT &&
+               SCA3300_ERRORS[SCA3300_ERR_PIN_CONTINUITY_BIT].bit == SCA3300_ERR_PIN_CONTINUITY_BIT,
+               "SCA3300_ERRORS must be sorted by bit" );
+
+/* Temperature conversion in single precision */
+static constexpr float TEMP_SCALE  = (float)( 1.0 / TEMP_SIGNAL_SENSITIVITY );
+static constexpr float TEMP_OFFSET = (float)TEMP_ABSOLUTE_ZERO;
+
+/* Fixed-point conversions */
+static_assert( AccelToMilliG( SENSITIVITY_MODE_1, GetModeScale( OPMODE1 ) ) == 1000 &&
+               AccelToMilliG( -SENSITIVITY_MODE_3_4, GetModeScale( OPMODE4 ) ) == -1000, "Unexpected milli-g scale" );
+static_assert( TempToCentiDeg( 0x15C5 ) == 2172, "Unexpected centi-degree scale" );
+
+/* CRC8 lookup table, poly 0x1D */
+static constexpr sca3300CrcTable CRC_TABLE;
+
+/**
+ * @brief      CRC of the 24 MSB's of a frame, one table lookup per byte
+ */
+static constexpr uint8_t TableCRC( const uint32_t aFrame )
+{
+    uint8_t crc = 0xFF;
+
+    crc = CRC_TABLE.st_Table[crc ^ (uint8_t)( aFrame >> 24 )];
+    crc = CRC_TABLE.st_Table[crc ^ (uint8_t)( aFrame >> 16 )];
+    crc = CRC_TABLE.st_Table[crc ^ (uint8_t)( aFrame >>  8 )];
+
+    return (uint8_t)~crc;
+}
+
+static_assert( CRC_TABLE.st_Table[1] == 0x1D && CRC_TABLE.st_Table[0x80] == 0x26, "Unexpected CRC8 table" );
+static_assert( TableCRC( 0x04000000 ) == 0xF7 && TableCRC( 0xB4000200 ) == 0x25, "CRC8 does not match the datasheet" );
+
+/* Hand computed requests against the compile time builder */
+static_assert( MakeRequest( false, REG_ACC_X )        == REQ_READ_ACC_X,     "REQ_READ_ACC_X" );
+static_assert( MakeRequest( false, REG_ACC_Y )        == REQ_READ_ACC_Y,     "REQ_READ_ACC_Y" );
+static_assert( MakeRequest( false, REG_ACC_Z )        == REQ_READ_ACC_Z,     "REQ_READ_ACC_Z" );
+static_assert( MakeRequest( false, REG_STO )          == REQ_READ_STO,       "REQ_READ_STO" );
+static_assert( MakeRequest( false, REG_TEMP )         == REQ_READ_TEMP,      "REQ_READ_TEMP" );
+static_assert( MakeRequest( false, REG_STATUS )       == REQ_READ_STATUS,    "REQ_READ_STATUS" );
+static_assert( MakeRequest( true,  REG_MODE, 0x0020 ) == REQ_WRITE_SW_RESET, "REQ_WRITE_SW_RESET" );
+static_assert( MakeRequest( true,  REG_MODE, 0x0000 ) == REQ_WRITE_MODE1,    "REQ_WRITE_MODE1" );
+static_assert( MakeRequest( true,  REG_MODE, 0x0001 ) == REQ_WRITE_MODE2,    "REQ_WRITE_MODE2" );
+static_assert( MakeRequest( true,  REG_MODE, 0x0002 ) == REQ_WRITE_MODE3,    "REQ_WRITE_MODE3" );
+static_assert( MakeRequest( true,  REG_MODE, 0x0003 ) == REQ_WRITE_MODE4,    "REQ_WRITE_MODE4" );
+static_assert( MakeRequest( false, REG_WHOAMI )       == REQ_READ_WHOAMI,    "REQ_READ_WHOAMI" );
+
+
+/**
+ * @brief      Human readable STATUS flag
+ *
+ * @param[in]  aBit  STATUS bit
+ *
+ * @return     Description, or NULL for a bit without meaning
+ */
+const char *sca3300d01::GetStatusFlagDescription( const int aBit )
+{
+    const int nbErrors = sizeof(SCA3300_ERRORS) / sizeof(SCA3300_ERRORS[0]);
+
+    return ( aBit >= 0 && aBit < nbErrors ) ? SCA3300_ERRORS[aBit].description : NULL;
+}
+
+
+/**
+ * @brief      Human readable Return Status
+ *
+ * @param[in]  aRs  RS field of a frame
+ *
+ * @return     Description
+ */
+const char *sca3300d01::GetReturnStatusDescription( const uint8_t aRs )
+{
+    return SCA3300_RETURN_STATUS[aRs & 0x03];
+}
+
 
 /**
  * @brief      Check if the CRC of SPI trame is valid
@@ -34,49 +119,75 @@ using namespace sca3300d01;
  */
 bool sca3300d01::CheckCRCTrame(uint8_t *ptr, const uint8_t octets)
 {
-    uint8_t crc  = 0xFF;
-    uint8_t data = 0x00;
+    uint8_t crc = 0xFF;
 
     // (8 LSB's are the CRC field and are not included in CRC calculation)
     for (uint8_t i = 0; i < octets -1; i++)
-    {
-        data = *ptr++;
+        crc = CRC_TABLE.st_Table[crc ^ *ptr++];
+
+    return uint8_t(~crc) == *ptr;
+}
+
+
+/**
+ * @brief      Calculate the CRC field of a SPI trame
+ *
+ * @param[in]  aFrame  The 32 bit frame (8 LSB's are ignored)
+ *
+ * @return     CRC to put in the 8 LSB's
+ */
+uint8_t sca3300d01::CalculateCRC( const uint32_t aFrame )
+{
+    return TableCRC( aFrame );
+}
 
-        for (uint8_t mask = 0x80; mask != 0; mask >>= 1)
-        {
-            uint8_t poly = 0, adder = 0;
 
-            /* case for new bit = 1 */
-            if (data & mask)
-            {/* define the polynomial */
-                poly = 0x1C;
-                adder++;
-            }
+/**
+ * @brief      Check the CRC of several received frames at once
+ *
+ * @param[in]  aFrames  aCount frames of SCA3300_FRAME_SIZE_BYTES bytes (MSB first)
+ * @param[in]  aCount   Number of frames
+ * @param[out] aValid   Validity bitmap, (aCount + 63) / 64 words: bit i % 64
+ *                      of aValid[i / 64] is set if the CRC of frame i is valid
+ *
+ * @return     Number of frames with a valid CRC
+ */
+size_t sca3300d01::CheckCRCFrames( const uint8_t *aFrames, const size_t aCount, uint64_t *aValid )
+{
+    size_t nbValid = 0;
+
+    for (size_t word = 0; word * 64 < aCount; ++word)
+    {
+        const size_t   first = word * 64;
+        const size_t   count = ( aCount - first < 64 ) ? aCount - first : 64;
+        const uint8_t *frame = aFrames + first * SCA3300_FRAME_SIZE_BYTES;
+        uint64_t       bits  = 0;
 
-            if (crc & 0x80)
-                poly ^= 0x1D;
+        for (size_t i = 0; i < count; ++i, frame += SCA3300_FRAME_SIZE_BYTES)
+        {
+            const uint8_t crc = CRC_TABLE.st_Table[CRC_TABLE.st_Table[CRC_TABLE.st_Table[0xFF ^ frame[0]] ^ frame[1]] ^ frame[2]];
 
-            crc <<= 1;
-            crc += adder;
-            crc ^= poly;
+            bits |= (uint64_t)( (uint8_t)~crc == frame[3] ) << i;
         }
+
+        aValid[word] = bits;
+        nbValid += __builtin_popcountll( bits );
     }
 
-    if (uint8_t(~crc) == *ptr)
-        return true;
-    else
-        return false;
+    return nbValid;
 }
 
 
 /**
  * @brief      Convert data from SPI trame to acceleration
  *
- * @param[in]  aAccel  A data acceleration
+ * @note       Reference of ConvertAccelBlock.
+ *
+ * @param[in]  aAccel  A data acceleration (two's complement)
  *
  * @return     Acceleration converted (g.)
  */
-float sca3300d01::ProcessAccel( const uint16_t aAccel, const int aSensivity )
+float sca3300d01::ProcessAccel( const int16_t aAccel, const int aSensivity )
 {
     float value = (float)aAccel / aSensivity;
 
@@ -86,15 +197,154 @@ float sca3300d01::ProcessAccel( const uint16_t aAccel, const int aSensivity )
 /**
  * @brief      Converts raw data from SPI trame in degrees Celcuis (°C)
  *
+ * @note       Rounded to 0.01 °C, ConvertTempBlock gives the unrounded value.
+ *
  * @param[in]  aRawTemp  A raw data from SPI trame
  *
  * @return     Temperature in degrees Celcuis
  */
 float sca3300d01::ConvertTemperature( const uint16_t aRawTemp )
 {
-    float ftemp = TEMP_ABSOLUTE_ZERO + ( aRawTemp / TEMP_SIGNAL_SENSITIVITY );
+    float ftemp = TEMP_OFFSET + aRawTemp * TEMP_SCALE;
 
     ftemp = roundf( ftemp * 100 ) / 100;
 
     return ftemp;
 }
+
+/**
+ * @brief      Convert a block of acceleration data
+ *
+ * @note       Multiplies by the reciprocal of the sensitivity: within 1 ULP
+ *             of ProcessAccel. SSE2 / NEON convert 8 values per iteration.
+ *
+ * @param[in]  aRaw        Acceleration data (two's complement)
+ * @param[out] aAccel      Accelerations (g.)
+ * @param[in]  aCount      Number of values
+ * @param[in]  aSensivity  Sensitivity of the operation mode (LSB/g)
+ */
+void sca3300d01::ConvertAccelBlock( const int16_t *aRaw, float *aAccel, const size_t aCount, const int aSensivity )
+{
+    const float scale = 1.0f / aSensivity;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps( scale );
+
+    for ( ; i + 8 <= aCount; i += 8)
+    {
+        const __m128i raw = _mm_loadu_si128( (const __m128i *)( aRaw + i ) );
+
+        // Sign extension: value in the high half of each 32 bit lane, then arithmetic shift
+        const __m128i lo = _mm_srai_epi32( _mm_unpacklo_epi16( raw, raw ), 16 );
+        const __m128i hi = _mm_srai_epi32( _mm_unpackhi_epi16( raw, raw ), 16 );
+
+        _mm_storeu_ps( aAccel + i,     _mm_mul_ps( _mm_cvtepi32_ps( lo ), vscale ) );
+        _mm_storeu_ps( aAccel + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), vscale ) );
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for ( ; i + 8 <= aCount; i += 8)
+    {
+        const int16x8_t raw = vld1q_s16( aRaw + i );
+
+        vst1q_f32( aAccel + i,     vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( raw ) ) ), scale ) );
+        vst1q_f32( aAccel + i + 4, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_high_s16( raw ) ) ), scale ) );
+    }
+#endif
+
+    for ( ; i < aCount; ++i)
+        aAccel[i] = aRaw[i] * scale;
+}
+
+/**
+ * @brief      Convert a block of raw temperatures in degrees Celcuis (°C)
+ *
+ * @note       Not rounded to 0.01 °C (see ConvertTemperature).
+ *
+ * @param[in]  aRaw    Raw temperatures
+ * @param[out] aTemp   Temperatures (°C)
+ * @param[in]  aCount  Number of values
+ */
+void sca3300d01::ConvertTempBlock( const uint16_t *aRaw, float *aTemp, const size_t aCount )
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 vscale  = _mm_set1_ps( TEMP_SCALE );
+    const __m128 voffset = _mm_set1_ps( TEMP_OFFSET );
+
+    for ( ; i + 8 <= aCount; i += 8)
+    {
+        const __m128i raw = _mm_loadu_si128( (const __m128i *)( aRaw + i ) );
+        const __m128i lo  = _mm_unpacklo_epi16( raw, _mm_setzero_si128() );
+        const __m128i hi  = _mm_unpackhi_epi16( raw, _mm_setzero_si128() );
+
+        _mm_storeu_ps( aTemp + i,     _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( lo ), vscale ), voffset ) );
+        _mm_storeu_ps( aTemp + i + 4, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( hi ), vscale ), voffset ) );
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t voffset = vdupq_n_f32( TEMP_OFFSET );
+
+    for ( ; i + 8 <= aCount; i += 8)
+    {
+        const uint16x8_t raw = vld1q_u16( aRaw + i );
+
+        // Separate multiply and add, same rounding as the scalar tail
+        vst1q_f32( aTemp + i,     vaddq_f32( vmulq_n_f32( vcvtq_f32_u32( vmovl_u16( vget_low_u16( raw ) ) ), TEMP_SCALE ), voffset ) );
+        vst1q_f32( aTemp + i + 4, vaddq_f32( vmulq_n_f32( vcvtq_f32_u32( vmovl_u16( vget_high_u16( raw ) ) ), TEMP_SCALE ), voffset ) );
+    }
+#endif
+
+    for ( ; i < aCount; ++i)
+        aTemp[i] = aRaw[i] * TEMP_SCALE + TEMP_OFFSET;
+}
+
+/**
+ * @brief      Current CLOCK_MONOTONIC time
+ *
+ * @return     Time in nanoseconds
+ */
+int64_t sca3300d01::GetMonotonicNs( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief      Sleep until a CLOCK_MONOTONIC deadline
+ *
+ * @note       Absolute deadlines do not drift when used for periodic wake-ups.
+ *
+ * @param[in]  aDeadlineNs  Deadline in nanoseconds (GetMonotonicNs() time base)
+ */
+void sca3300d01::SleepUntilNs( const int64_t aDeadlineNs )
+{
+    struct timespec ts;
+
+    ts.tv_sec  = aDeadlineNs / 1000000000LL;
+    ts.tv_nsec = aDeadlineNs % 1000000000LL;
+
+    while ( EINTR == clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) ) {}
+}
+
+/**
+ * @brief      Wait until a CLOCK_MONOTONIC deadline
+ *
+ * @note       Sleeps with clock_nanosleep(TIMER_ABSTIME) until SCA3300_SPIN_THRESHOLD_NS
+ *             before the deadline, then spins: the scheduler wake-up latency is
+ *             larger than the few microseconds we usually have to wait.
+ *
+ * @param[in]  aDeadlineNs  Deadline in nanoseconds (GetMonotonicNs() time base)
+ */
+void sca3300d01::WaitUntilNs( const int64_t aDeadlineNs )
+{
+    int64_t now = GetMonotonicNs();
+
+    if ( aDeadlineNs - now > SCA3300_SPIN_THRESHOLD_NS )
+        SleepUntilNs( aDeadlineNs - SCA3300_SPIN_THRESHOLD_NS );
+
+    while ( now < aDeadlineNs )
+        now = GetMonotonicNs();
+}
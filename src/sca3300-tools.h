@@ -2,12 +2,130 @@
 #define SCA3300_TOOLS_H_
 
 #include <stdint.h>
+#include <stddef.h>
+
+#include "sca3300def.h"
 
 namespace sca3300d01
 {
+    /**
+     * @brief      Decoded STATUS register
+     */
+    struct sca3300Status
+    {
+        uint16_t st_Flags = 0;         /**< Active error flags, bit n is described by SCA3300_ERRORS[n] */
+        uint16_t st_ResetRequired = 0; /**< Active flags that need a component reset */
+    };
+
+    /**
+     * @brief      STATUS flags that need a component reset, built from SCA3300_ERRORS
+     */
+    constexpr uint16_t GetResetRequiredMask( void )
+    {
+        uint16_t mask = 0;
+
+        for (const sca3300ErrorInfo &error : SCA3300_ERRORS)
+            if ( error.resetRequired )
+                mask |= 1 << error.bit;
+
+        return mask;
+    }
+
+    /**
+     * @brief      Decode the STATUS register, no allocation, no string
+     *
+     * @param[in]  aData  STATUS register content
+     *
+     * @return     Every active flag and the ones that need a reset
+     */
+    constexpr sca3300Status DecodeStatus( const uint16_t aData )
+    {
+        return sca3300Status{ (uint16_t)( aData & SCA3300_STATUS_FLAGS_MASK ),
+                              (uint16_t)( aData & GetResetRequiredMask() ) };
+    }
+
+    /**
+     * @brief      CRC8 lookup table (polynomial 0x1D), generated at compile time
+     *
+     * @note       st_Table[i] is the CRC register after shifting the byte i in
+     *             with a zero register, so one table lookup replaces 8 bit steps.
+     */
+    struct sca3300CrcTable
+    {
+        uint8_t st_Table[256];
+
+        constexpr sca3300CrcTable() : st_Table()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                uint8_t crc = (uint8_t)i;
+
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = ( crc & 0x80 ) ? (uint8_t)( ( crc << 1 ) ^ 0x1D ) : (uint8_t)( crc << 1 );
+
+                st_Table[i] = crc;
+            }
+        }
+    };
+
+    /**
+     * @brief      Scale of the acceleration counts of a measurement mode
+     */
+    struct sca3300Scale
+    {
+        int32_t st_Sensitivity; /**< LSB/g */
+        float   st_GPerLsb;     /**< g per count, 1 / st_Sensitivity */
+        int64_t st_MilliGMul;   /**< milli-g per count, SCA3300_FIXED_SHIFT fractional bits */
+    };
+
+    constexpr sca3300Scale MakeScale( const int32_t aSensivity )
+    {
+        return sca3300Scale{ aSensivity, 1.0f / aSensivity,
+                             ( ( 1000LL << SCA3300_FIXED_SHIFT ) + aSensivity / 2 ) / aSensivity };
+    }
+
+    /**
+     * @brief      Scale of a measurement mode, mode 1 scale for an unknown mode
+     */
+    constexpr sca3300Scale GetModeScale( const operationMode aMode )
+    {
+        return ( OPMODE2 == aMode ) ? MakeScale( SENSITIVITY_MODE_2 ) :
+               ( OPMODE3 == aMode || OPMODE4 == aMode ) ? MakeScale( SENSITIVITY_MODE_3_4 ) :
+               MakeScale( SENSITIVITY_MODE_1 );
+    }
+
+    /**
+     * @brief      Acceleration counts to milli-g, integer only (multiply-shift, rounded)
+     */
+    constexpr int32_t AccelToMilliG( const int16_t aRaw, const sca3300Scale &aScale )
+    {
+        return (int32_t)( ( aRaw * aScale.st_MilliGMul + ( 1LL << ( SCA3300_FIXED_SHIFT - 1 ) ) ) >> SCA3300_FIXED_SHIFT );
+    }
+
+    /**
+     * @brief      Raw temperature to centi-degrees Celcuis, integer only (multiply-shift, rounded)
+     */
+    constexpr int32_t TempToCentiDeg( const uint16_t aRaw )
+    {
+        return (int32_t)( ( aRaw * (int64_t)( 100.0 / TEMP_SIGNAL_SENSITIVITY * ( 1LL << SCA3300_FIXED_SHIFT ) + 0.5 ) +
+                            ( 1LL << ( SCA3300_FIXED_SHIFT - 1 ) ) ) >> SCA3300_FIXED_SHIFT ) +
+               (int32_t)( TEMP_ABSOLUTE_ZERO * 100 - 0.5 );
+    }
+
+    const char *GetStatusFlagDescription( const int aBit );
+    const char *GetReturnStatusDescription( const uint8_t aRs );
+
     bool CheckCRCTrame( uint8_t *ptr, const uint8_t octets );
-    float ProcessAccel( const uint16_t aAccel, const int aSensivity );
+    uint8_t CalculateCRC( const uint32_t aFrame );
+    size_t CheckCRCFrames( const uint8_t *aFrames, const size_t aCount, uint64_t *aValid );
+    float ProcessAccel( const int16_t aAccel, const int aSensivity );
     float ConvertTemperature( const uint16_t aRawTemp );
+    void ConvertAccelBlock( const int16_t *aRaw, float *aAccel, const size_t aCount, const int aSensivity );
+    void ConvertTempBlock( const uint16_t *aRaw, float *aTemp, const size_t aCount );
+
+    int64_t GetMonotonicNs( void );
+    void SleepUntilNs( const int64_t aDeadlineNs );
+    void WaitUntilNs( const int64_t aDeadlineNs );
 }
 
 #endif //SCA3300_TOOLS_H_
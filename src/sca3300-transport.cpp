@@ -0,0 +1,385 @@
+/**
+ * @author Nicolas SALMIN
+ * @file sca3300-transport.cpp
+ * @brief SPI transports for SCA3300 device
+ *
+ */
+
+/*============================================================================*/
+/*                                  INCLUDES                                  */
+/*============================================================================*/
+/* ******** Includes/System ************************************************* */
+#include <cstring> // memset...
+#include <cstdio>
+#include <algorithm> // min...
+#include <unistd.h>
+#include <fcntl.h> // O_RDWR...
+#include <sys/ioctl.h> // SPI_IOC_WR_MODE ...
+
+/* *********Includes/functions prototypes *********************************** */
+#include "sca3300def.h"
+#include "sca3300-tools.h"
+#include "sca3300-transport.h"
+
+#include "macrologger.h"
+
+/*============================================================================*/
+/*                                DEFINITIONS                                 */
+/*============================================================================*/
+/* ******** Definitions/Functions ******************************************* */
+#define LOG_LEVEL INFO_LEVEL
+
+/*============================================================================*/
+/*                                NAMESPACES                                  */
+/*============================================================================*/
+using namespace std;
+using namespace sca3300d01;
+
+
+/*============================================================================*/
+/*                               SPIDEV TRANSPORT                             */
+/*============================================================================*/
+
+/**
+ * @brief   Constructor, opens and configures the spidev device.
+ *
+ * @param[in]   devspi  { SPI Device }
+ * @param[in]   spiMode { SPI Mode }
+ * @param[in]   spiSpeed    { SPI Max Speed }
+ * @param[in]   spibitsPerWord  { SPI Bits per word }
+ */
+sca3300SpidevTransport::sca3300SpidevTransport(std::string devspi, unsigned char spiMode, unsigned int spiSpeed, unsigned char spibitsPerWord){
+    this->mode        = spiMode ;
+    this->bitsPerWord = spibitsPerWord;
+    this->speed       = spiSpeed;
+    this->spifd       = -1;
+
+    this->OpenSpiBus(devspi);
+}
+
+
+/**
+ * @brief    Destructor, closes the spidev device.
+ */
+sca3300SpidevTransport::~sca3300SpidevTransport(){
+    this->CloseSpiBus();
+}
+
+
+/**
+ *
+ * @brief      { Function is called by the constructor.
+ * It is responsible for opening the spidev device "devspi" and then setting up the spidev interface.
+ * Private member variables are used to configure spidev. }
+ *
+ *@note         { They must be set appropriately by constructor before calling this function.}
+ *
+ * @param[in] SPI Device
+ *
+ */
+void sca3300SpidevTransport::OpenSpiBus(std::string devspi)
+{
+    int iStatus = -1;
+
+    this->spifd = open(devspi.c_str(), O_RDWR);
+
+    if(this->spifd < 0){
+        LOG_ERROR("could not open SPI device");
+        exit(1);
+    }
+
+    iStatus = ioctl (this->spifd, SPI_IOC_WR_MODE, &(this->mode));
+    if(iStatus < 0){
+        LOG_ERROR("Could not set SPIMode (WR)...ioctl fail");
+        exit(1);
+    }
+
+    iStatus = ioctl (this->spifd, SPI_IOC_RD_MODE, &(this->mode));
+    if(iStatus < 0) {
+      LOG_ERROR("Could not set SPIMode (RD)...ioctl fail");
+      exit(1);
+    }
+
+    iStatus = ioctl (this->spifd, SPI_IOC_WR_BITS_PER_WORD, &(this->bitsPerWord));
+    if(iStatus < 0) {
+      LOG_ERROR("Could not set SPI bitsPerWord (WR)...ioctl fail");
+      exit(1);
+    }
+
+    iStatus = ioctl (this->spifd, SPI_IOC_RD_BITS_PER_WORD, &(this->bitsPerWord));
+    if(iStatus < 0) {
+      LOG_ERROR("Could not set SPI bitsPerWord(RD)...ioctl fail");
+      exit(1);
+    }
+
+    iStatus = ioctl (this->spifd, SPI_IOC_WR_MAX_SPEED_HZ, &(this->speed));
+    if(iStatus < 0) {
+      LOG_ERROR("Could not set SPI speed (WR)...ioctl fail");
+      exit(1);
+    }
+
+    iStatus = ioctl (this->spifd, SPI_IOC_RD_MAX_SPEED_HZ, &(this->speed));
+    if(iStatus < 0) {
+      LOG_ERROR("Could not set SPI speed (RD)...ioctl fail");
+      exit(1);
+    }
+}
+
+
+/**
+ * @brief      CloseSpiBus(): Responsible for closing the spidev interface.
+ *
+ * @note     Called in destructor.
+ */
+int sca3300SpidevTransport::CloseSpiBus()
+{
+    int iStatus = -1;
+    iStatus = close(this->spifd);
+
+    if(iStatus < 0)
+    {
+        LOG_ERROR("Could not close SPI device");
+        exit(1);
+    }
+
+    return iStatus;
+}
+
+
+/**
+ * @brief      Sends the frames with one ioctl per SCA3300_MAX_BATCH_FRAMES frames.
+ *
+ * @details    One spi_ioc_transfer is built per frame. cs_change releases
+ *             the chip select between two frames so that every request is
+ *             seen as a distinct SPI cycle by the device, and the gap is
+ *             timed by the kernel through delay_usecs.
+ */
+bool sca3300SpidevTransport::Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs )
+{
+    bool ret = true;
+
+    struct spi_ioc_transfer tr[SCA3300_MAX_BATCH_FRAMES];
+
+    for (size_t done = 0; done < aCount; )
+    {
+        const size_t batch = std::min( aCount - done, (size_t)SCA3300_MAX_BATCH_FRAMES );
+
+        memset(tr, 0, sizeof (tr[0]) * batch);
+
+        for (size_t i = 0; i < batch; ++i)
+        {
+            tr[i].tx_buf = (unsigned long)( aTx + ( done + i ) * SCA3300_FRAME_SIZE_BYTES );
+            tr[i].rx_buf = (unsigned long)( aRx + ( done + i ) * SCA3300_FRAME_SIZE_BYTES );
+            tr[i].len = SCA3300_FRAME_SIZE_BYTES;
+            tr[i].speed_hz = this->speed;
+            tr[i].bits_per_word = this->bitsPerWord;
+
+            // Release CSB between frames, not after the last one
+            if ( i + 1 < batch )
+            {
+                tr[i].cs_change = 1;
+                tr[i].delay_usecs = aGapUs;
+            }
+        }
+
+        // SPI_IOC_MESSAGE(N) with a runtime N
+        int status = ioctl(this->spifd, _IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, SPI_MSGSIZE(batch)), tr);
+        if (status < 1)
+        {
+            LOG_ERROR("can't send spi message");
+            ret = false;
+        }
+
+        done += batch;
+    }
+
+    return ret;
+}
+
+
+/*============================================================================*/
+/*                              SIMULATED DEVICE                              */
+/*============================================================================*/
+
+/**
+ * @brief   Constructor, device is at rest (1 g on Z in mode 3) at 21.72 °C.
+ */
+sca3300SimTransport::sca3300SimTransport(){
+    memset(this->registers, 0, sizeof(this->registers));
+
+    this->registers[REG_ACC_Z]  = SENSITIVITY_MODE_3_4;
+    this->registers[REG_TEMP]   = 0x15C5;
+    this->registers[REG_WHOAMI] = SCA3300_CHIP_ID;
+
+    this->returnStatus = ST_NORMAL_OP;
+    this->pending      = 0;
+    this->frameCount   = 0;
+}
+
+
+/**
+ * @brief      Sets a register of the simulated device.
+ */
+void sca3300SimTransport::SetRegister( const uint8_t aAddr, const uint16_t aValue )
+{
+    this->registers[aAddr % NB_REGISTERS] = aValue;
+}
+
+
+/**
+ * @brief      Gets a register of the simulated device.
+ */
+uint16_t sca3300SimTransport::GetRegister( const uint8_t aAddr ) const
+{
+    return this->registers[aAddr % NB_REGISTERS];
+}
+
+
+/**
+ * @brief      Sets the Return Status put in every answer.
+ */
+void sca3300SimTransport::SetReturnStatus( const uint8_t aRs )
+{
+    this->returnStatus = aRs;
+}
+
+
+/**
+ * @brief      Number of frames exchanged since construction.
+ */
+uint64_t sca3300SimTransport::GetFrameCount( void ) const
+{
+    return this->frameCount;
+}
+
+
+/**
+ * @brief      Builds the answer of the device to a request.
+ *
+ * @param[in]  aRequest  The request
+ *
+ * @return     Frame sent back during the next SPI cycle
+ */
+uint32_t sca3300SimTransport::Answer( const uint32_t aRequest )
+{
+    const uint8_t  addr = ( aRequest & ADDR_FIELD_MASK ) >> 26;
+    const uint16_t data = ( aRequest & DATA_FIELD_MASK ) >> 8;
+    const bool     write = 0 != ( aRequest & 0x80000000 );
+
+    uint32_t rs = this->returnStatus;
+
+    if ( CalculateCRC( aRequest ) != ( aRequest & CRC_FIELD_MASK ) )
+        rs = ST_ERROR;
+    else if ( write )
+        this->registers[addr] = data;
+
+    uint32_t answer = ( aRequest & OPCODE_FIELD_MASK ) | ( rs << 24 ) | ( (uint32_t)this->registers[addr] << 8 );
+
+    return answer | CalculateCRC( answer );
+}
+
+
+/**
+ * @brief      Off-frame exchange: each frame carries the answer to the previous request.
+ */
+bool sca3300SimTransport::Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs )
+{
+    (void)aGapUs;
+
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        const uint8_t *tx = aTx + i * SCA3300_FRAME_SIZE_BYTES;
+        uint8_t       *rx = aRx + i * SCA3300_FRAME_SIZE_BYTES;
+
+        const uint32_t request = ( (uint32_t)tx[0] << 24 ) | ( tx[1] << 16 ) | ( tx[2] << 8 ) | tx[3];
+
+        rx[0] = (uint8_t)( this->pending >> 24 );
+        rx[1] = (uint8_t)( this->pending >> 16 );
+        rx[2] = (uint8_t)( this->pending >>  8 );
+        rx[3] = (uint8_t)( this->pending );
+
+        this->pending = this->Answer( request );
+    }
+
+    this->frameCount += aCount;
+
+    return true;
+}
+
+
+/*============================================================================*/
+/*                                   REPLAY                                   */
+/*============================================================================*/
+
+/**
+ * @brief   Constructor from frames in memory.
+ *
+ * @param[in]   aFrames  Received frames, SCA3300_FRAME_SIZE_BYTES bytes each
+ * @param[in]   aCount   Number of frames
+ */
+sca3300ReplayTransport::sca3300ReplayTransport( const uint8_t *aFrames, const size_t aCount )
+    : frames( aFrames, aFrames + aCount * SCA3300_FRAME_SIZE_BYTES ), position( 0 )
+{
+}
+
+
+/**
+ * @brief   Constructor from a file of raw received frames.
+ *
+ * @param[in]   aPath  File path
+ */
+sca3300ReplayTransport::sca3300ReplayTransport( const std::string &aPath )
+    : position( 0 )
+{
+    FILE *file = fopen( aPath.c_str(), "rb" );
+
+    if ( NULL == file )
+    {
+        LOG_ERROR("could not open replay file %s", aPath.c_str());
+        return;
+    }
+
+    uint8_t buffer[4096];
+    size_t  nbRead;
+
+    while ( ( nbRead = fread( buffer, 1, sizeof(buffer), file ) ) > 0 )
+        this->frames.insert( this->frames.end(), buffer, buffer + nbRead );
+
+    fclose( file );
+
+    // Drop a truncated last frame
+    this->frames.resize( this->frames.size() - this->frames.size() % SCA3300_FRAME_SIZE_BYTES );
+}
+
+
+/**
+ * @brief      Number of recorded frames.
+ */
+size_t sca3300ReplayTransport::GetFrameCount( void ) const
+{
+    return this->frames.size() / SCA3300_FRAME_SIZE_BYTES;
+}
+
+
+/**
+ * @brief      Copies the next recorded frames, looping at the end of the recording.
+ */
+bool sca3300ReplayTransport::Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs )
+{
+    (void)aTx;
+    (void)aGapUs;
+
+    if ( this->frames.empty() )
+        return false;
+
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        memcpy( aRx + i * SCA3300_FRAME_SIZE_BYTES, &this->frames[this->position], SCA3300_FRAME_SIZE_BYTES );
+
+        this->position += SCA3300_FRAME_SIZE_BYTES;
+        if ( this->position >= this->frames.size() )
+            this->position = 0;
+    }
+
+    return true;
+}
@@ -0,0 +1,127 @@
+/**
+ * \file  sca3300-transport.h
+ *
+ * \brief SPI transports used by the sca3300 class
+ *
+ * \details The driver only exchanges 32-bit frames. How they reach a device
+ * is hidden behind sca3300Transport: a real spidev bus, an in-process
+ * simulated SCA3300 or a replay of recorded frames.
+ *
+ * \author Nicolas SALMIN
+ *
+ */
+
+#ifndef SCA3300_TRANSPORT_H_
+#define SCA3300_TRANSPORT_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/spi/spidev.h>
+
+#include "sca3300def.h"
+
+namespace sca3300d01
+{
+  /**
+   * @brief      Abstract full duplex SPI frame transport
+   */
+  class sca3300Transport
+  {
+      public:
+          virtual ~sca3300Transport() {}
+
+          /**
+           * @brief      Exchange aCount frames of SCA3300_FRAME_SIZE_BYTES bytes (MSB first).
+           *
+           * @param[in]  aTx     Bytes to send
+           * @param[out] aRx     Bytes received
+           * @param[in]  aCount  Number of frames
+           * @param[in]  aGapUs  Minimal gap between two frames of the exchange
+           *
+           * @return     true on success
+           */
+          virtual bool Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs ) = 0;
+  };
+
+  /**
+   * @brief      Linux spidev transport (/dev/spidevX.Y)
+   */
+  class sca3300SpidevTransport : public sca3300Transport
+  {
+      public:
+          sca3300SpidevTransport(std::string devspi, unsigned char spiMode, \
+                                                     unsigned int  spiSpeed,\
+                                                     unsigned char spiBitsPerWord);
+          ~sca3300SpidevTransport();
+
+          bool Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs );
+
+      private:
+          // SPI configuration
+          unsigned char mode;
+          unsigned char bitsPerWord;
+          unsigned int speed;
+          int spifd;
+
+          void OpenSpiBus( const std::string devspi );
+          int CloseSpiBus( void );
+  };
+
+  /**
+   * @brief      In-process SCA3300 model
+   *
+   * @note       Implements the off-frame protocol (answer of request N in
+   *             frame N+1), the CRC and the registers read by the driver.
+   */
+  class sca3300SimTransport : public sca3300Transport
+  {
+      public:
+          sca3300SimTransport();
+
+          bool Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs );
+
+          // Simulated device state
+          void SetRegister( const uint8_t aAddr, const uint16_t aValue );
+          uint16_t GetRegister( const uint8_t aAddr ) const;
+          void SetReturnStatus( const uint8_t aRs );
+
+          uint64_t GetFrameCount( void ) const;
+
+      private:
+          static const int NB_REGISTERS = 32;
+
+          uint16_t registers[NB_REGISTERS];
+          uint8_t  returnStatus;
+          uint32_t pending;
+          uint64_t frameCount;
+
+          uint32_t Answer( const uint32_t aRequest );
+  };
+
+  /**
+   * @brief      Replays recorded raw received frames
+   *
+   * @note       Frames are stored as received: SCA3300_FRAME_SIZE_BYTES bytes
+   *             per frame, MSB first. Sent frames are ignored. The recording
+   *             is looped when its end is reached.
+   */
+  class sca3300ReplayTransport : public sca3300Transport
+  {
+      public:
+          sca3300ReplayTransport( const uint8_t *aFrames, const size_t aCount );
+          explicit sca3300ReplayTransport( const std::string &aPath );
+
+          bool Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs );
+
+          size_t GetFrameCount( void ) const;
+
+      private:
+          std::vector<uint8_t> frames;
+          size_t position;
+  };
+
+} //namespace sca3300d01
+
+#endif //SCA3300_TRANSPORT_H_
@@ -42,6 +42,7 @@
 /* ******** Includes/System ************************************************* */
 #include <cstring> // memset...
 #include <iomanip> // setprecision...
+#include <algorithm> // min...
 
 /* *********Includes/functions prototypes *********************************** */
 #include "sca3300.h"
@@ -53,14 +54,6 @@
 /*============================================================================*/
 /*                                DEFINITIONS                                 */
 /*============================================================================*/
-/* ******** Definitions/Consts ********************************************** */
-/* Error and status maps */
-const std::map<std::string, std::pair<int, bool>> \
-                        sca3300d01::ErrorTable::SCA3300_ERRORMAP = ErrorTable::create_map();
-
-const std::map<std::string, int> \
-                        sca3300d01::StatusTable::SCA3300_STATUSMAP = StatusTable::create_map();
-
 /* ******** Definitions/Functions ******************************************* */
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
@@ -77,14 +70,9 @@ using namespace sca3300d01;
  * @brief   Default constructor.
  * @detail  No param needed
  */
-sca3300::sca3300(){
-    this->mode        = SPI_MODE_0;
-    this->bitsPerWord = 8;
-    this->speed       = SCA3300_MAX_SPI_FREQ_HZ;
-    this->spifd       = -1;
-
-    this->OpenSpiBus(std::string("/dev/spidev0.0"));
-    this->InitChip();
+sca3300::sca3300()
+    : sca3300( std::unique_ptr<sca3300Transport>( new sca3300SpidevTransport( "/dev/spidev0.0", SPI_MODE_0, SCA3300_MAX_SPI_FREQ_HZ, 8 ) ) )
+{
 }
 
 
@@ -98,102 +86,66 @@ sca3300::sca3300(){
  * @param[in]   spiSpeed    { SPI Max Speed }
  * @param[in]   spibitsPerWord  { SPI Bits per word }
  */
-sca3300::sca3300(std::string devspi, unsigned char spiMode, unsigned int spiSpeed, unsigned char spibitsPerWord){
-    this->mode        = spiMode ;
-    this->bitsPerWord = spibitsPerWord;
-    this->speed       = spiSpeed;
-    this->spifd       = -1;
-
-    this->OpenSpiBus(devspi);
-    this->InitChip();
+sca3300::sca3300(std::string devspi, unsigned char spiMode, unsigned int spiSpeed, unsigned char spibitsPerWord)
+    : sca3300( std::unique_ptr<sca3300Transport>( new sca3300SpidevTransport( devspi, spiMode, spiSpeed, spibitsPerWord ) ) )
+{
 }
 
 
 /**
- * @brief    Default destructor of sca3300.
+ * @brief   Overloaded constructor.
+ * @detail  Use any SPI transport (spidev, simulated device, replay...)
+ *
+ * @param[in]   aTransport  { SPI frames transport, owned by the object }
  */
-sca3300::~sca3300(){
-    this->CloseSpiBus();
+sca3300::sca3300(std::unique_ptr<sca3300Transport> aTransport)
+    : sca3300( std::move( aTransport ), OPMODE3 )
+{
 }
 
 
 /**
+ * @brief   Overloaded constructor.
+ * @detail  Start in a given measurement mode: it is written during the
+ *          power up sequence, before the status flags are cleared.
  *
- * @brief      { Function is called by the constructor.
- * It is responsible for opening the spidev device "devspi" and then setting up the spidev interface.
- * Private member variables are used to configure spidev. }
- *
- *@note         { They must be set appropriately by constructor before calling this function.}
- *
- * @param[in] SPI Device
- *
+ * @param[in]   aTransport  { SPI frames transport, owned by the object }
+ * @param[in]   aMode       { Measurement mode, mode 1 if unknown }
  */
-void sca3300::OpenSpiBus(std::string devspi)
+sca3300::sca3300(std::unique_ptr<sca3300Transport> aTransport, const operationMode aMode)
+    : sca3300( std::move( aTransport ), aMode,
+               MakeRequest( true, REG_MODE, ( ( aMode >= OPMODE1 && aMode <= OPMODE4 ) ? aMode : OPMODE1 ) - OPMODE1 ) )
 {
-    int iStatus = -1;
-
-    this->spifd = open(devspi.c_str(), O_RDWR);
-
-    if(this->spifd < 0){
-        LOG_ERROR("could not open SPI device");
-        exit(1);
-    }
-
-    iStatus = ioctl (this->spifd, SPI_IOC_WR_MODE, &(this->mode));
-    if(iStatus < 0){
-        LOG_ERROR("Could not set SPIMode (WR)...ioctl fail");
-        exit(1);
-    }
-
-    iStatus = ioctl (this->spifd, SPI_IOC_RD_MODE, &(this->mode));
-    if(iStatus < 0) {
-      LOG_ERROR("Could not set SPIMode (RD)...ioctl fail");
-      exit(1);
-    }
-
-    iStatus = ioctl (this->spifd, SPI_IOC_WR_BITS_PER_WORD, &(this->bitsPerWord));
-    if(iStatus < 0) {
-      LOG_ERROR("Could not set SPI bitsPerWord (WR)...ioctl fail");
-      exit(1);
-    }
-
-    iStatus = ioctl (this->spifd, SPI_IOC_RD_BITS_PER_WORD, &(this->bitsPerWord));
-    if(iStatus < 0) {
-      LOG_ERROR("Could not set SPI bitsPerWord(RD)...ioctl fail");
-      exit(1);
-    }
-
-    iStatus = ioctl (this->spifd, SPI_IOC_WR_MAX_SPEED_HZ, &(this->speed));
-    if(iStatus < 0) {
-      LOG_ERROR("Could not set SPI speed (WR)...ioctl fail");
-      exit(1);
-    }
-
-    iStatus = ioctl (this->spifd, SPI_IOC_RD_MAX_SPEED_HZ, &(this->speed));
-    if(iStatus < 0) {
-      LOG_ERROR("Could not set SPI speed (RD)...ioctl fail");
-      exit(1);
-    }
 }
 
 
 /**
- * @brief      CloseSpiBus(): Responsible for closing the spidev interface.
+ * @brief   Overloaded constructor.
+ * @detail  For modes fixed at build time: the mode-write frame is a constant
+ *          of the derived class (see sca3300Fixed).
  *
- * @note     Called in destructor.
+ * @param[in]   aTransport     { SPI frames transport, owned by the object }
+ * @param[in]   aMode          { Measurement mode }
+ * @param[in]   aModeRequest   { Its mode-write frame, sent during the power up sequence }
  */
-int sca3300::CloseSpiBus()
-{
-    int iStatus = -1;
-    iStatus = close(this->spifd);
+sca3300::sca3300(std::unique_ptr<sca3300Transport> aTransport, const operationMode aMode, const uint32_t aModeRequest){
+    this->transport   = std::move( aTransport );
+    this->inFlight    = 0;
+    this->inFlightNs  = 0;
+    this->frameGapUs  = SCA3300_FRAME_GAP_US;
+    this->nextFrameNs = 0;
+    this->frameCount  = 0;
+    this->rateStartNs = GetMonotonicNs();
+
+    this->InitChip( aMode, aModeRequest );
+}
 
-    if(iStatus < 0)
-    {
-        LOG_ERROR("Could not close SPI device");
-        exit(1);
-    }
 
-    return iStatus;
+/**
+ * @brief    Default destructor of sca3300.
+ */
+sca3300::~sca3300(){
+    this->Stop();
 }
 
 
@@ -214,48 +166,23 @@ bool sca3300::CheckRS( const uint16_t aRsCode )
 
 
 /**
- * @brief      This function sends data to the spidev device.
+ * @brief      Decode a received SPI frame
  *
- * @param[in]  aRequest  A request
+ * @param      aRx       The 4 bytes received from the device (MSB first)
+ * @param[in]  aCrcValid The CRC of the frame has been checked (CheckCRCFrames)
  *
  * @return     Filled sca3300Frame structure
  */
-sca3300Frame sca3300::SendRequest( const uint32_t aRequest ){
-
-    int ret;
-    const int REQUEST_SIZE_BYTES = 4; // u8*4 = 32bits
-
-    uint8_t arryBytes[REQUEST_SIZE_BYTES];
-    uint8_t rx[REQUEST_SIZE_BYTES];
-    uint32_t response = 0x00;
-
+sca3300Frame sca3300::ParseFrame( const uint8_t *aRx, const bool aCrcValid )
+{
     sca3300Frame cframe;
 
-    // LSB first datasheet p.9/21
-    arryBytes[3] = (unsigned char) ((aRequest) & 0xFF);
-    arryBytes[2] = (unsigned char) ((aRequest >>  8) & 0xFF);
-    arryBytes[1] = (unsigned char) ((aRequest >> 16) & 0xFF);
-    arryBytes[0] = (unsigned char) ((aRequest >> 24));
-
-    struct spi_ioc_transfer tr;
-    memset(&tr, 0, sizeof (tr));
-    tr.tx_buf = (unsigned long)arryBytes,
-    tr.rx_buf = (unsigned long)rx,
-    tr.len = ARRAY_SIZE(arryBytes),
-    tr.delay_usecs = 0,
-    tr.speed_hz = this->speed,
-    tr.bits_per_word = this->bitsPerWord,
-    tr.cs_change = 0;
-
-    ret = ioctl(this->spifd, SPI_IOC_MESSAGE(1), &tr);
-    if (ret < 1)
-        LOG_ERROR("can't send spi message");
-
-    response = ((rx[3] & 0xFF) | ((rx[2] << 8) & 0xFF00) | ((rx[1] << 16) & 0xFF0000) | (rx[0] << 24));
+    uint32_t response = ((aRx[3] & 0xFF) | ((aRx[2] << 8) & 0xFF00) | ((aRx[1] << 16) & 0xFF0000) | ((uint32_t)aRx[0] << 24));
 
     /* Check trame validity = CRC + Return Status */
     cframe.st_ReturnStatus = ( response & RS_FIELD_MASK ) >> 24 ;
-    cframe.st_IsValid = sca3300d01::CheckCRCTrame(rx, sizeof(rx) ) && CheckRS( cframe.st_ReturnStatus );
+    cframe.st_OpCode = ( response & OPCODE_FIELD_MASK ) >> 26;
+    cframe.st_IsValid = aCrcValid && CheckRS( cframe.st_ReturnStatus );
     cframe.st_Data = ( response & DATA_FIELD_MASK ) >> 8;
     cframe.st_Crc = response & CRC_FIELD_MASK;
 
@@ -265,28 +192,210 @@ sca3300Frame sca3300::SendRequest( const uint32_t aRequest ){
     LOG_DEBUG("response Data:    0x%04x\n", cframe.st_Data);
     LOG_DEBUG("response CRC:     0x%02x\n", cframe.st_Crc);
 
-    usleep(1000);
+    return cframe;
+}
+
+
+/**
+ * @brief      This function sends data to the spidev device.
+ *
+ * @param[in]  aRequest  A request
+ *
+ * @return     Filled sca3300Frame structure
+ */
+sca3300Frame sca3300::SendRequest( const uint32_t aRequest ){
+
+    sca3300Frame cframe;
+
+    this->SendRequests( &aRequest, &cframe, 1 );
 
     return cframe;
 }
 
 
+/**
+ * @brief      Sends several requests to the device in one transport exchange.
+ *
+ * @details    On spidev the whole batch is sent with a single ioctl. The
+ *             gap with the previous exchange is enforced here, the gap
+ *             between frames of the batch is left to the transport.
+ *             Batches larger than SCA3300_MAX_BATCH_FRAMES are split.
+ *
+ * @param[in]  aRequests  Requests to send, in order
+ * @param[out] aFrames    Decoded responses, aFrames[i] is received while aRequests[i] is sent
+ * @param[in]  aCount     Number of requests
+ *
+ * @return     true if every exchange succeeded
+ */
+bool sca3300::SendRequests( const uint32_t *aRequests, sca3300Frame *aFrames, const size_t aCount )
+{
+    bool ret = true;
+
+    static_assert( SCA3300_MAX_BATCH_FRAMES <= 64, "A batch CRC bitmap must fit in one word" );
+
+    uint8_t tx[SCA3300_MAX_BATCH_FRAMES][SCA3300_FRAME_SIZE_BYTES];
+    uint8_t rx[SCA3300_MAX_BATCH_FRAMES][SCA3300_FRAME_SIZE_BYTES];
+
+    for (size_t done = 0; done < aCount; )
+    {
+        const size_t batch = std::min( aCount - done, (size_t)SCA3300_MAX_BATCH_FRAMES );
+
+        memset(rx, 0, sizeof (rx[0]) * batch);
+
+        for (size_t i = 0; i < batch; ++i)
+        {
+            const uint32_t req = aRequests[done + i];
+
+            // LSB first datasheet p.9/21
+            tx[i][3] = (unsigned char) ((req) & 0xFF);
+            tx[i][2] = (unsigned char) ((req >>  8) & 0xFF);
+            tx[i][1] = (unsigned char) ((req >> 16) & 0xFF);
+            tx[i][0] = (unsigned char) ((req >> 24));
+        }
+
+        // Gap with the previous exchange is timed here
+        WaitUntilNs( this->nextFrameNs );
+
+        if ( false == this->transport->Transfer( tx[0], rx[0], batch, this->frameGapUs ) )
+        {
+            LOG_ERROR("can't send spi message");
+            ret = false;
+        }
+
+        this->nextFrameNs = GetMonotonicNs() + (int64_t)this->frameGapUs * 1000;
+        this->frameCount += batch;
+
+        // One CRC pass over the whole batch
+        uint64_t crcValid = 0;
+        CheckCRCFrames( rx[0], batch, &crcValid );
+
+        for (size_t i = 0; i < batch; ++i)
+            aFrames[done + i] = this->ParseFrame( rx[i], 0 != ( ( crcValid >> i ) & 1 ) );
+
+        done += batch;
+    }
+
+    // The last request sent is answered by the next frame
+    this->inFlight   = ( ret && aCount > 0 ) ? aRequests[aCount - 1] : 0;
+    this->inFlightNs = GetMonotonicNs();
+
+    return ret;
+}
+
+
+/**
+ * @brief      Sends requests and pairs each answer with its request.
+ *
+ * @details    The SCA3300 answers request N in frame N+1 (off-frame protocol).
+ *             The request left in flight by the previous exchange is tracked:
+ *             when it is aRequests[0] and was sent less than one ODR period
+ *             ago, its answer is collected in the first frame. Otherwise
+ *             (other request, or answer latched too long ago to be fresh)
+ *             one extra frame is spent to send aRequests[0] again.
+ *             The last frame re-issues aRequests[0] so that a periodic cycle
+ *             costs exactly aCount frames.
+ *
+ * @param[in]  aRequests  Requests to answer, in order
+ * @param[out] aAnswers   aAnswers[i] is the answer to aRequests[i]
+ * @param[in]  aCount     Number of requests (< SCA3300_MAX_BATCH_FRAMES)
+ *
+ * @return     true if every answer is valid and matches its request
+ */
+bool sca3300::Query( const uint32_t *aRequests, sca3300Frame *aAnswers, const size_t aCount )
+{
+    if ( 0 == aCount || aCount >= SCA3300_MAX_BATCH_FRAMES )
+    {
+        LOG_ERROR("Invalid request count: %u", (unsigned)aCount);
+        return false;
+    }
+
+    uint32_t     tx[SCA3300_MAX_BATCH_FRAMES];
+    sca3300Frame rx[SCA3300_MAX_BATCH_FRAMES];
+
+    // Answer to aRequests[0] is already on its way, and still fresh?
+    const bool fresh  = ( GetMonotonicNs() - this->inFlightNs ) <= SCA3300_IN_FLIGHT_MAX_NS;
+    const size_t skip = ( this->inFlight == aRequests[0] && fresh ) ? 1 : 0;
+    size_t nbFrames = 0;
+
+    for (size_t i = skip; i < aCount; ++i)
+        tx[nbFrames++] = aRequests[i];
+
+    // Next useful request: start of the next cycle
+    tx[nbFrames++] = aRequests[0];
+
+    bool ret = this->SendRequests( tx, rx, nbFrames );
+
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        aAnswers[i] = rx[i + 1 - skip];
+
+        if ( ( aAnswers[i].st_OpCode << 26 & ADDR_FIELD_MASK ) != ( aRequests[i] & ADDR_FIELD_MASK ) )
+        {/* Answer does not belong to the request: resync on next call */
+            LOG_ERROR("Unexpected answer 0x%02x for request 0x%08x", aAnswers[i].st_OpCode, aRequests[i]);
+            aAnswers[i].st_IsValid = false;
+            this->inFlight = 0;
+        }
+
+        ret &= aAnswers[i].st_IsValid;
+    }
+
+    return ret;
+}
+
+
+/**
+ * @brief      Set the minimal time between two SPI frames.
+ *
+ * @note       Default is SCA3300_FRAME_GAP_US, the CSB high time from the datasheet.
+ *
+ * @param[in]  aGapUs  Gap in microseconds
+ */
+void sca3300::SetFrameGap( const uint32_t aGapUs )
+{
+    this->frameGapUs = aGapUs;
+}
+
+
+/**
+ * @brief      Frame rate achieved since the previous call (or since construction).
+ *
+ * @return     Frames per second
+ */
+float sca3300::GetFrameRate( void )
+{
+    const int64_t now = GetMonotonicNs();
+    const int64_t elapsed = now - this->rateStartNs;
+
+    float rate = ( elapsed > 0 ) ? (float)( this->frameCount * 1e9 / elapsed ) : 0.0;
+
+    this->frameCount  = 0;
+    this->rateStartNs = now;
+
+    return rate;
+}
+
+
 /**
  * @brief      { This function send the SCA3300 init sequence }
  *
+ * @param[in]  aMode         { Measurement mode written before the status is cleared }
+ * @param[in]  aModeRequest  { Its mode-write frame }
+ *
  * @return     { true if the device is Successfully configured }
  * @return     { 0  Otherwise}
  */
-bool sca3300::InitChip( void )
+bool sca3300::InitChip( const operationMode aMode, const uint32_t aModeRequest )
 {/* Sensor Power Up sequence details in datasheet p.15 */
 
     // Wait 10 ms
     usleep(10000);
 
     //Set Mode
-    this->SendRequest ( REQ_WRITE_MODE3 );
-    if ( true == ChangeMode ( OPMODE3 ) )
+    if ( true == ChangeMode ( aMode ) )
+    {
         LOG_INFO("[OK] Change Mode done.\n");
+    }
+    this->SendRequest ( aModeRequest );
 
     //Wait 5 ms
     usleep(5000);
@@ -303,13 +412,7 @@ bool sca3300::InitChip( void )
     //Wait 5 ms
     usleep(5000);
 
-    bool ret = this->CheckChipId();
-
-    // First read temp once to get into desired
-    //  measurement cycle in off-frame protocol
-    this->SendRequest( REQ_READ_TEMP );
-
-    return ret;
+    return this->CheckChipId();
 }
 
 
@@ -324,11 +427,10 @@ bool sca3300::GetTemperature( float &temp )
 {
     bool ret = false;
 
-    sca3300Frame dummy = this->SendRequest ( REQ_READ_TEMP );
-    dummy = this->SendRequest ( REQ_READ_TEMP );
-    dummy = this->SendRequest ( REQ_READ_TEMP );
+    const uint32_t req = REQ_READ_TEMP;
+    sca3300Frame dummy;
 
-    if ( true == dummy.st_IsValid && ST_ERROR != dummy.st_ReturnStatus)
+    if ( true == this->Query ( &req, &dummy, 1 ) && ST_ERROR != dummy.st_ReturnStatus)
     {/* Temperature equation in datasheet p.4 */
         temp = ConvertTemperature( dummy.st_Data );
         ret  = true;
@@ -352,17 +454,12 @@ bool sca3300::GetTemperature( float &temp )
  */
 bool sca3300::CheckChipId( void )
 {
+    const uint32_t req = REQ_READ_WHOAMI;
     sca3300Frame dummy;
 
-    // Read again to get the correct status data
-    this->SendRequest ( REQ_READ_WHOAMI );
-    dummy = this->SendRequest ( REQ_READ_WHOAMI );
-
-    if ( true == dummy.st_IsValid && SCA3300_CHIP_ID == dummy.st_Data )
+    if ( true == this->Query ( &req, &dummy, 1 ) && SCA3300_CHIP_ID == dummy.st_Data )
     {
         LOG_INFO("SCA3300 Getting probed successfully.");
-        /* to avoid first bad measurement */
-        this->SendRequest ( REQ_READ_TEMP );
         return true;
     }
     else
@@ -372,6 +469,29 @@ bool sca3300::CheckChipId( void )
     }
 }
 
+/**
+ * @brief      Reads the component serial number.
+ *
+ * @param[out] aSerial  SERIAL2 << 16 | SERIAL1
+ *
+ * @return     true if both registers were read
+ */
+bool sca3300::GetSerial( uint32_t &aSerial )
+{
+    const uint32_t reqs[] = { REQ_READ_SERIAL1, REQ_READ_SERIAL2 };
+    sca3300Frame answers[2];
+
+    if ( !this->Query( reqs, answers, 2 ) )
+    {
+        LOG_ERROR("Failed to read the serial number!");
+        return false;
+    }
+
+    aSerial = (uint32_t)answers[1].st_Data << 16 | answers[0].st_Data;
+
+    return true;
+}
+
 /**
  * @brief      Change measurement mode
  *
@@ -387,33 +507,32 @@ bool sca3300::ChangeMode( const operationMode aMode)
     this->opMode = aMode;
 
     /* Update sensivity to get accel */
-    switch(aMode)
-    {
-    case OPMODE1:
-        this->sensivity = SENSITIVITY_MODE_1;
-        break;
-
-    case OPMODE2:
-        this->sensivity = SENSITIVITY_MODE_2;
-        break;
+    this->sensivity = GetModeSensitivity( aMode );
 
-    case OPMODE3:
-    case OPMODE4:
-        this->sensivity = SENSITIVITY_MODE_3_4;
-        break;
-
-    default:
+    if ( aMode < OPMODE1 || aMode > OPMODE4 )
+    {
         LOG_INFO("Set default sensivity mode.");
-        this->sensivity = SENSITIVITY_MODE_1;
         this->opMode = OPMODE1;
         ret = false;
-        break;
-   }
+    }
 
    return ret;
 }
 
 
+/**
+ * @brief      Sensitivity of a measurement mode
+ *
+ * @param[in]  aMode  A mode
+ *
+ * @return     Sensitivity (LSB/g), mode 1 sensitivity for an unknown mode
+ */
+int sca3300::GetModeSensitivity( const operationMode aMode )
+{
+    return GetModeScale( aMode ).st_Sensitivity;
+}
+
+
 /**
  * @brief      Read given acceleration from the device
  *
@@ -441,111 +560,143 @@ bool sca3300::GetAccel( const accelAxe aAxe, float &aAccel )
 
     if ( ret )
     {
-        sca3300Frame dummy = this->SendRequest ( req );
+        sca3300Frame dummy;
 
-        if ( true == dummy.st_IsValid )
+        if ( true == this->Query ( &req, &dummy, 1 ) )
         {
-            aAccel = ProcessAccel( dummy.st_Data, this->sensivity );
+            aAccel = ProcessAccel( (int16_t)dummy.st_Data, this->sensivity );
             LOG_INFO("Accel[%d]: %fg\n", aAxe, aAccel);
             ret = true;
         }
         else
+        {
             LOG_ERROR("Invalid response.");
+            ret = false;
+        }
     }
 
     return ret;
 }
 
 /**
- * @brief      Reads and process data.
+ * @brief      Reads one complete measurement cycle, raw counts.
  *
- * @param[in]  aLoop  A loop
+ * @details    X, Y, Z, temperature and status are requested back to back.
+ *             Thanks to the off-frame tracking done by Query(), a periodic
+ *             call costs exactly five frames and every value is attributed
+ *             to the request it answers. No float conversion is done.
  *
- * @return     1 if success 0 otherwise
+ * @param[out] aSample  The sample
+ *
+ * @return     true if every frame of the cycle is valid
  */
-bool sca3300::ReadAndProcessData( int aLoop )
+bool sca3300::ReadRawSample( sca3300RawSample &aSample )
 {
-    // Read temperature and accelerations.
-    // Note: interleaved reading due to off-frame protocol
-    sca3300Frame Response_Temp;
-
-    float Curr_T = 0.0;
-
-    float Sum_T = 0.0;
-    float Sum_X = 0.0;
-    float Sum_Y = 0.0;
-    float Sum_Z = 0.0;
+    static const uint32_t CYCLE[] = { REQ_READ_ACC_X, REQ_READ_ACC_Y, REQ_READ_ACC_Z,
+                                      REQ_READ_TEMP, REQ_READ_STATUS };
+    sca3300Frame answers[ARRAY_SIZE(CYCLE)];
 
-    float Acc_curr = 0.0;
+    aSample.st_IsValid = this->Query( CYCLE, answers, ARRAY_SIZE(CYCLE) );
 
-    for (int i = 0; i < aLoop; ++i)
-    {/* Ask sensor and check validity */
+    aSample.st_Accel[ACCEL_X] = (int16_t)answers[0].st_Data;
+    aSample.st_Accel[ACCEL_Y] = (int16_t)answers[1].st_Data;
+    aSample.st_Accel[ACCEL_Z] = (int16_t)answers[2].st_Data;
+    aSample.st_Temp           = answers[3].st_Data;
+    aSample.st_Status         = answers[4].st_Data;
+    aSample.st_Mode           = this->opMode;
 
-        Curr_T = 0.0;
+    return aSample.st_IsValid;
+}
 
-        // Handle temperature data
-        if ( true == GetTemperature(Curr_T) )
-            Sum_T += Curr_T;
 
-        if ( true == GetAccel ( ACCEL_X, Acc_curr ) )
-            Sum_X += Acc_curr;
+/**
+ * @brief      Reads one complete measurement cycle (g, °C).
+ *
+ * @param[out] aSample  The sample
+ *
+ * @return     true if every frame of the cycle is valid
+ */
+bool sca3300::ReadSample( sca3300Sample &aSample )
+{
+    sca3300RawSample raw;
 
-        if ( true == GetAccel ( ACCEL_Y, Acc_curr ) )
-            Sum_Y += Acc_curr;
+    raw.st_Timestamp = aSample.st_Timestamp;
+    raw.st_Sequence  = aSample.st_Sequence;
 
-        if ( true == GetAccel ( ACCEL_Z, Acc_curr ) )
-            Sum_Z += Acc_curr;
+    this->ReadRawSample( raw );
+    ConvertSample( raw, aSample );
 
-        sleep(1); // TODO check minimal time needed between each cmd
-    }
+    return aSample.st_IsValid;
+}
 
-    LOG_DEBUG("Processing Done.");
-    LOG_DEBUG("Acc_X: %f", Sum_X/aLoop);
-    LOG_DEBUG("Acc_Y: %f", Sum_Y/aLoop);
-    LOG_DEBUG("Acc_Z: %f", Sum_Z/aLoop);
-    LOG_DEBUG("Temp : %f", Sum_T/aLoop);
 
-    // TODO return ret &= ret
-    return true;
+/**
+ * @brief      Streaming acquisition: one measurement cycle per period.
+ *
+ * @param[out] aSample  The sample
+ *
+ * @return     true if every frame of the cycle is valid
+ */
+bool sca3300::AcquireSample( sca3300RawSample &aSample )
+{
+    return this->ReadRawSample( aSample );
 }
 
 
-int GetError ( uint16_t aData )
+/**
+ * @brief      Reads samples back to back and computes their statistics.
+ *
+ * @param[in]  aLoop   Number of samples
+ * @param[out] aStats  Statistics of the valid samples
+ *
+ * @return     true if every sample is valid
+ */
+bool sca3300::ReadAndProcessData( const int aLoop, sca3300SampleStats &aStats )
 {
-    unsigned   i = 1;
-    unsigned pos = 1;
+    sca3300Stats stats;
+    sca3300Sample sample;
 
-    while (!(i & aData))
+    for (int i = 0; i < aLoop; ++i)
     {
-        i = i << 1;
-        ++pos;
+        sample.st_Timestamp = GetMonotonicNs();
+        sample.st_Sequence  = i;
+
+        this->ReadSample( sample );
+        stats.Add( sample );
     }
 
-    return pos;
+    aStats = stats.GetTotal();
+
+    LOG_DEBUG("Processing Done.");
+    LOG_DEBUG("Acc_X: %f", aStats.st_Accel[ACCEL_X].st_Mean);
+    LOG_DEBUG("Acc_Y: %f", aStats.st_Accel[ACCEL_Y].st_Mean);
+    LOG_DEBUG("Acc_Z: %f", aStats.st_Accel[ACCEL_Z].st_Mean);
+    LOG_DEBUG("Temp : %f", aStats.st_Temp.st_Mean);
+
+    return 0 == aStats.st_Invalid;
 }
 
+
 /**
  * @brief      Gets the device status register.
  *
+ * @details    Active flags are logged with their description.
+ *
  * @return     1 as success and 0 if trouble appeared.
  */
 bool sca3300::GetStatus ( void )
 {
-    int err = 0;
-
-    sca3300Frame dummy = this->SendRequest ( REQ_READ_STATUS );
+    sca3300Status status;
 
-    if ( ST_ERROR == dummy.st_ReturnStatus )
+    if ( false == this->GetStatus( status ) )
     {
-        err = GetError( dummy.st_Data );
-
-        for (auto& t : ErrorTable::SCA3300_ERRORMAP)
+        for (int bit = 0; bit < 16; ++bit)
         {
-            if ( err == t.second.first)
+            if ( status.st_Flags & ( 1 << bit ) )
             {
-                LOG_ERROR("[ERRO] Error Id: %d", t.second.first  );
-                LOG_ERROR("[ERRO] Message : %s", t.first.c_str() );
-                LOG_ERROR("[ERRO] Reboot? : %d", t.second.second );
+                LOG_ERROR("[ERRO] Error Id: %d", bit );
+                LOG_ERROR("[ERRO] Message : %s", GetStatusFlagDescription( bit ) );
+                LOG_ERROR("[ERRO] Reboot? : %d", 0 != ( status.st_ResetRequired & ( 1 << bit ) ) );
             }
         }
         return false;
@@ -556,3 +707,23 @@ bool sca3300::GetStatus ( void )
         return true;
     }
 }
+
+
+/**
+ * @brief      Gets the decoded device status register.
+ *
+ * @param[out] aStatus  Active flags
+ *
+ * @return     true if the frame is valid and no flag is active
+ */
+bool sca3300::GetStatus ( sca3300Status &aStatus )
+{
+    const uint32_t req = REQ_READ_STATUS;
+    sca3300Frame dummy;
+
+    bool ret = this->Query ( &req, &dummy, 1 );
+
+    aStatus = DecodeStatus( dummy.st_Data );
+
+    return ret && ST_ERROR != dummy.st_ReturnStatus && 0 == aStatus.st_Flags;
+}
@@ -19,13 +19,16 @@
 #define SCA3300LIB_API_H_
 
 #include <iostream>
+#include <memory>
 #include <unistd.h>
 #include <stdint.h>
-#include <fcntl.h> // O_RDWR...
-#include <sys/ioctl.h> // SPI_IOC_WR_MODE ...
 #include <linux/spi/spidev.h>
 
 #include "sca3300def.h"
+#include "sca3300-tools.h"
+#include "sca3300-transport.h"
+#include "sca3300-stream.h"
+#include "sca3300-stats.h"
 
 /**
  * @brief      SPI frame structure
@@ -35,21 +38,10 @@ struct sca3300Frame
   uint16_t st_Data = 0;        /**< Data */
   uint16_t st_Crc  = 0;        /**< Cyclic Redundancy Check */
   uint8_t st_ReturnStatus = 0; /**< Return Status Code*/
+  uint8_t st_OpCode = 0;       /**< Operation code (RW + address) of the answered request */
   bool st_IsValid  = false;    /**< Trame is valid? */
 };
 
-/**
- * @brief      Measurement Mode
- */
-enum operationMode
-{
-  ERR = 0,
-  OPMODE1, /*!<   3g full-scale. 88 Hz 1st order low pass filter (default) */
-  OPMODE2, /*!<   6g full-scale. 88 Hz 1st order low pass filter */
-  OPMODE3, /*!< 1.5g full-scale. 88 Hz 1st order low pass filter */
-  OPMODE4, /*!< 1.5g full-scale. 10 Hz 1st order low pass filter */
-};
-
 /**
  * @brief      Acceleration axis
  */
@@ -62,7 +54,7 @@ enum accelAxe
 
 namespace sca3300d01
 {
-  class sca3300
+  class sca3300 : public sca3300Stream
   {
       public:
           // Constructors and Destructor
@@ -70,35 +62,58 @@ namespace sca3300d01
           sca3300(std::string devspi, unsigned char spiMode, \
                                       unsigned int  spiSpeed,\
                                       unsigned char spiBitsPerWord);
+          explicit sca3300(std::unique_ptr<sca3300Transport> aTransport);
+          sca3300(std::unique_ptr<sca3300Transport> aTransport, const operationMode aMode);
           ~sca3300();
 
           // Basics operations
           bool CheckChipId( void );
+          bool GetSerial( uint32_t &aSerial );
           bool GetStatus ( void );
+          bool GetStatus ( sca3300Status &aStatus );
           bool ChangeMode( const operationMode aMode);
+          static int GetModeSensitivity( const operationMode aMode );
 
           // Data processing
           bool GetAccel( const accelAxe aAxe, float &aAccel );
           bool GetTemperature( float &temp );
-          bool ReadAndProcessData( const int aLoop );
+          bool ReadSample( sca3300Sample &aSample );
+          bool ReadRawSample( sca3300RawSample &aSample );
+          bool ReadAndProcessData( const int aLoop, sca3300SampleStats &aStats );
           sca3300Frame SendRequest( const uint32_t aRequest );
+          bool SendRequests( const uint32_t *aRequests, sca3300Frame *aFrames, const size_t aCount );
+          bool Query( const uint32_t *aRequests, sca3300Frame *aAnswers, const size_t aCount );
+
+          // Frame scheduling
+          void SetFrameGap( const uint32_t aGapUs );
+          float GetFrameRate( void );
+
+      protected:
+          sca3300(std::unique_ptr<sca3300Transport> aTransport, const operationMode aMode, const uint32_t aModeRequest);
+
+          bool AcquireSample( sca3300RawSample &aSample );
 
       private:
-          // SPI configuration
-          unsigned char mode;
-          unsigned char bitsPerWord;
-          unsigned int speed;
-          int spifd;
+          // SPI frames transport
+          std::unique_ptr<sca3300Transport> transport;
+
+          // Off-frame protocol: request answered by the next frame (0 if unknown)
+          uint32_t inFlight;
+          int64_t  inFlightNs;    /**< When it was sent (its answer is latched then) */
 
-          void OpenSpiBus( const std::string devspi );
-          int CloseSpiBus( void );
+          // Inter-frame gap scheduling and frame rate measurement
+          uint32_t frameGapUs;
+          int64_t  nextFrameNs;
+          uint64_t frameCount;
+          int64_t  rateStartNs;
 
           // Basic device configuration
           operationMode opMode;
           int sensivity;
 
-          bool InitChip( void );
+          bool InitChip( const operationMode aMode, const uint32_t aModeRequest );
           bool CheckRS( const uint16_t aRsCode );
+          sca3300Frame ParseFrame( const uint8_t *aRx, const bool aCrcValid );
 
   }; // end of Class
 
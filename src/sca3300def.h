@@ -18,7 +18,19 @@
 #ifndef SCA3300DEF_API_HPP_
 #define SCA3300DEF_API_HPP_
 
-#include <map>
+#include <stdint.h>
+
+/**
+ * @brief      Measurement Mode
+ */
+enum operationMode
+{
+  ERR = 0,
+  OPMODE1, /*!<   3g full-scale. 88 Hz 1st order low pass filter (default) */
+  OPMODE2, /*!<   6g full-scale. 88 Hz 1st order low pass filter */
+  OPMODE3, /*!< 1.5g full-scale. 88 Hz 1st order low pass filter */
+  OPMODE4, /*!< 1.5g full-scale. 10 Hz 1st order low pass filter */
+};
 
 namespace sca3300d01
 {
@@ -27,60 +39,38 @@ namespace sca3300d01
 
 #define SCA3300_MAX_SPI_FREQ_HZ  8000000
 #define SCA3300_CHIP_ID           0x0051
+#define SCA3300_ODR_HZ              2000 // Output data rate, every mode
 
-#define TEMP_SIGNAL_SENSITIVITY    18.9
-#define TEMP_ABSOLUTE_ZERO       -273.15
+/* SPI frame timing (datasheet p.9) */
+#define SCA3300_FRAME_SIZE_BYTES        4 // u8*4 = 32bits
+#define SCA3300_FRAME_GAP_US           10 // CSB high time between two frames
+#define SCA3300_MAX_BATCH_FRAMES       64 // frames sent in one SPI_IOC_MESSAGE
+#define SCA3300_SPIN_THRESHOLD_NS   80000 // shorter waits are spun, not slept
+#define SCA3300_IN_FLIGHT_MAX_NS   ( 1000000000LL / SCA3300_ODR_HZ ) // answer in flight reused within one ODR period
 
-/**
- * @brief      SCA3300 Error Explanation
- *
- * @note datasheet p.18
- */
-struct ErrorTable{
-    static std::map<std::string, std::pair<int, bool> > create_map()
-    {
-            std::map<std::string, std::pair<int, bool> > m;
-            /* Description                                                           Bit |       reset? */
-            m.insert(std::make_pair("Digital block error type 1",                   std::make_pair(9, 1)));
-            m.insert(std::make_pair("Digital block error type 2",                   std::make_pair(8, 1)));
-            m.insert(std::make_pair("ASIC clock error",                             std::make_pair(7, 1)));
-            m.insert(std::make_pair("Signal saturated in signal path",              std::make_pair(6, 0)));
-            m.insert(std::make_pair("Signal saturated in temperature compensation", std::make_pair(5, 0)));
-            m.insert(std::make_pair("Voltage level failure",                        std::make_pair(4, 0)));
-            m.insert(std::make_pair("Memory error",                                 std::make_pair(3, 0)));
-            m.insert(std::make_pair("Digital block error type 3",                   std::make_pair(2, 1)));
-            m.insert(std::make_pair("Operation mode has changed",                   std::make_pair(1, 1)));
-            m.insert(std::make_pair("Component internal connection error",          std::make_pair(0, 0)));
-            return m;
-    }
-    static const std::map<std::string, std::pair<int, bool>> SCA3300_ERRORMAP;
-};
+/* Sample streaming */
+#define SCA3300_CACHE_LINE_BYTES       64
+#define SCA3300_RING_CAPACITY        4096 // samples, ~2 s at full ODR
 
-/**
- * @brief      SCA3300 Status Explanation
- *
- * @note datasheet p.18
- */
-struct StatusTable{
-    static std::map<std::string, int> create_map()
-        {
-          std::map<std::string, int> m;
-          m.insert(std::make_pair("Error",                     3));
-          m.insert(std::make_pair("Unknown error",             2));
-          m.insert(std::make_pair("Normal operation, no flag", 1));
-          m.insert(std::make_pair("Startup in progress",       0));
-          return m;
-        }
-    static const std::map<std::string, int> SCA3300_STATUSMAP;
-};
+#define TEMP_SIGNAL_SENSITIVITY    18.9
+#define TEMP_ABSOLUTE_ZERO       -273.15
 
 /* SCA3300 Sensivity definitions */
 #define SENSITIVITY_MODE_1          2700 // +/-6g   1350 LSB/g
 #define SENSITIVITY_MODE_2          1350 // +/-2g   2700 LSB/g
 #define SENSITIVITY_MODE_3_4        5400 // +/-1.5g 5400 LSB/g
 
+/* SCA3300 full-scale range */
+#define FULL_SCALE_MODE_1_MG        3000 // +/-3g
+#define FULL_SCALE_MODE_2_MG        6000 // +/-6g
+#define FULL_SCALE_MODE_3_4_MG      1500 // +/-1.5g
+
+/* Fixed-point conversion: value = ( raw * multiplier ) >> SCA3300_FIXED_SHIFT */
+#define SCA3300_FIXED_SHIFT           24
+
 /* SCA3300 SPI frame field masks */
 #define OPCODE_FIELD_MASK     0xFC000000
+#define ADDR_FIELD_MASK       0x7C000000
 #define RS_FIELD_MASK         0x03000000
 #define DATA_FIELD_MASK       0x00FFFF00
 #define CRC_FIELD_MASK        0x000000FF
@@ -88,7 +78,7 @@ struct StatusTable{
 /* SCA3300 return status */
 #define ST_START_UP                 0x00
 #define ST_NORMAL_OP                0x01
-#define ST_ERROR                    0x11
+#define ST_ERROR                    0x03 // '11'
 
 /* Status Explanation */
 #define SCA3300_ERR_DIGI1_BIT          9
@@ -102,6 +92,62 @@ struct StatusTable{
 #define SCA3300_ERR_MODE_CHANGE_BIT    1
 #define SCA3300_ERR_PIN_CONTINUITY_BIT 0
 
+#define SCA3300_STATUS_FLAGS_MASK  0x03FF
+
+/**
+ * @brief      SCA3300 Error Explanation
+ *
+ * @note datasheet p.18
+ */
+struct sca3300ErrorInfo
+{
+    uint8_t bit;             /**< STATUS register bit */
+    bool resetRequired;      /**< Component reset needed to recover? */
+    const char *description;
+};
+
+constexpr sca3300ErrorInfo SCA3300_ERRORS[] =
+{  /* Bit                             reset? Description */
+    { SCA3300_ERR_PIN_CONTINUITY_BIT, false, "Component internal connection error"          },
+    { SCA3300_ERR_MODE_CHANGE_BIT,    true,  "Operation mode has changed"                   },
+    { SCA3300_ERR_DIGI3_BIT,          true,  "Digital block error type 3"                   },
+    { SCA3300_ERR_MEM_BIT,            false, "Memory error"                                 },
+    { SCA3300_ERR_PWR_BIT,            false, "Voltage level failure"                        },
+    { SCA3300_ERR_TEMP_BIT,           false, "Signal saturated in temperature compensation" },
+    { SCA3300_ERR_STAT_BIT,           false, "Signal saturated in signal path"              },
+    { SCA3300_ERR_CLOCK_BIT,          true,  "ASIC clock error"                             },
+    { SCA3300_ERR_DIGI2_BIT,          true,  "Digital block error type 2"                   },
+    { SCA3300_ERR_DIGI1_BIT,          true,  "Digital block error type 1"                   },
+};
+
+/**
+ * @brief      SCA3300 Return Status Explanation, indexed by RS field
+ *
+ * @note datasheet p.18
+ */
+constexpr const char *SCA3300_RETURN_STATUS[] =
+{
+    "Startup in progress",
+    "Normal operation, no flag",
+    "Unknown error",
+    "Error",
+};
+
+/* SCA3300 register addresses */
+#define REG_ACC_X                   0x01
+#define REG_ACC_Y                   0x02
+#define REG_ACC_Z                   0x03
+#define REG_STO                     0x04
+#define REG_TEMP                    0x05
+#define REG_STATUS                  0x06
+#define REG_MODE                    0x0D
+#define REG_WHOAMI                  0x10
+#define REG_SERIAL1                 0x19
+#define REG_SERIAL2                 0x1A
+#define REG_ERR_FLAG1               0x1C
+#define REG_ERR_FLAG2               0x1D
+#define REG_SELBANK                 0x1F
+
 /* SCA3300 SPI requests */
 #define REQ_READ_ACC_X        0x040000F7
 #define REQ_READ_ACC_Y        0x080000FD
@@ -116,6 +162,52 @@ struct StatusTable{
 #define REQ_WRITE_MODE4       0xB4000338
 #define REQ_READ_WHOAMI       0x40000091
 
+/**
+ * @brief      CRC8 of the 24 MSB's of a frame, for compile time frames
+ *
+ * @note       Polynomial 0x1D, seed 0xFF, inverted (datasheet p.9).
+ *             CalculateCRC is the table driven runtime version.
+ */
+constexpr uint8_t FrameCRC( const uint32_t aFrame )
+{
+    uint8_t crc = 0xFF;
+
+    for (uint32_t mask = 0x80000000; mask != 0x80; mask >>= 1)
+    {
+        const bool bit = ( 0 != ( aFrame & mask ) ) ^ ( 0 != ( crc & 0x80 ) );
+
+        crc = (uint8_t)( crc << 1 );
+        if (bit)
+            crc ^= 0x1D;
+    }
+
+    return (uint8_t)~crc;
+}
+
+/**
+ * @brief      Build a request frame, CRC included
+ *
+ * @param[in]  aWrite  Write (true) or read (false) operation
+ * @param[in]  aAddr   Register address (5 bits)
+ * @param[in]  aData   Data written, 0 for a read
+ *
+ * @return     The 32 bit frame, RS field is 0
+ */
+constexpr uint32_t MakeRequest( const bool aWrite, const uint8_t aAddr, const uint16_t aData = 0 )
+{
+    return ( ( aWrite ? 0x80000000 : 0 ) | ( (uint32_t)( aAddr & 0x1F ) << 26 ) | ( (uint32_t)aData << 8 ) ) |
+           FrameCRC( ( aWrite ? 0x80000000 : 0 ) | ( (uint32_t)( aAddr & 0x1F ) << 26 ) | ( (uint32_t)aData << 8 ) );
+}
+
+/* SCA3300 SPI requests built at compile time */
+constexpr uint32_t REQ_READ_SERIAL1    = MakeRequest( false, REG_SERIAL1 );
+constexpr uint32_t REQ_READ_SERIAL2    = MakeRequest( false, REG_SERIAL2 );
+constexpr uint32_t REQ_READ_ERR_FLAG1  = MakeRequest( false, REG_ERR_FLAG1 );
+constexpr uint32_t REQ_READ_ERR_FLAG2  = MakeRequest( false, REG_ERR_FLAG2 );
+constexpr uint32_t REQ_READ_MODE       = MakeRequest( false, REG_MODE );
+constexpr uint32_t REQ_READ_SELBANK    = MakeRequest( false, REG_SELBANK );
+constexpr uint32_t REQ_WRITE_SELBANK_0 = MakeRequest( true, REG_SELBANK, 0 );
+
 }
 
 #endif //SCA3300DEF_API_HPP_
@@ -0,0 +1,284 @@
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <unistd.h>
+#include <sched.h>
+
+#include <catch.hpp>
+
+#include <sca3300-array.h>
+#include <sca3300-tools.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Simulated SCA3300 with a bus latency, remembers the CPU it runs on
+ */
+class SlowTransport : public sca3300SimTransport
+{
+    public:
+        explicit SlowTransport( const uint32_t aLatencyUs ) : latencyUs( aLatencyUs ), cpu( -1 ) {}
+
+        bool Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs )
+        {
+            if ( this->latencyUs > 0 )
+                usleep( this->latencyUs );
+
+            this->cpu = sched_getcpu();
+
+            return sca3300SimTransport::Transfer( aTx, aRx, aCount, aGapUs );
+        }
+
+        uint32_t latencyUs;
+        std::atomic<int> cpu;
+};
+
+static std::unique_ptr<sca3300> MakeSensor( SlowTransport *aTransport, const int16_t aAccelX )
+{
+    aTransport->SetRegister( REG_ACC_X, (uint16_t)aAccelX );
+
+    return std::unique_ptr<sca3300>( new sca3300( std::unique_ptr<sca3300Transport>( aTransport ) ) );
+}
+
+/**
+ * @brief      Time between the first and the last sensor read of every complete tick
+ */
+static vector<int64_t> TickSpans( sca3300Array &aArray )
+{
+    std::vector<sca3300ArraySample> samples( 256 );
+    std::vector<int64_t> spans;
+
+    REQUIRE( aArray.Start( 5000 ) == true );
+    usleep( 100000 );
+    aArray.Stop();
+
+    const size_t count = aArray.PopSamples( samples.data(), samples.size() );
+
+    for (size_t n = 0; n < count; ++n)
+    {
+        int64_t first = INT64_MAX, last = INT64_MIN;
+        bool complete = true;
+
+        for (uint32_t i = 0; i < samples[n].st_NbSensors; ++i)
+        {
+            const sca3300RawSample &raw = samples[n].st_Sensors[i];
+
+            complete &= raw.st_IsValid;
+            first = std::min( first, raw.st_Timestamp );
+            last  = std::max( last, raw.st_Timestamp );
+        }
+
+        if ( complete )
+            spans.push_back( last - first );
+    }
+
+    return spans;
+}
+
+/**
+ *
+ * Several sensors on several buses
+ *
+ */
+TEST_CASE( "Sensor Array" )
+{
+    SECTION( "SPI bus of a device" )
+    {
+        REQUIRE( SpiBusFromDevice( "/dev/spidev0.0" ) == 0 );
+        REQUIRE( SpiBusFromDevice( "/dev/spidev1.1" ) == 1 );
+        REQUIRE( SpiBusFromDevice( "/dev/spidev10.3" ) == 10 );
+        REQUIRE( SpiBusFromDevice( "/dev/spidev1" ) == -1 );
+        REQUIRE( SpiBusFromDevice( "/dev/spidev1.0x" ) == -1 );
+        REQUIRE( SpiBusFromDevice( "/dev/i2c-1" ) == -1 );
+    }
+
+    SECTION( "Invalid arrays" )
+    {
+        sca3300Array array;
+        sca3300ArraySample sample;
+
+        REQUIRE( array.Start( 1000 ) == false );
+        REQUIRE( array.PopSamples( &sample, 1 ) == 0 );
+        REQUIRE( array.AddSensor( nullptr, 0 ) == false );
+        REQUIRE( array.AddSensor( MakeSensor( new SlowTransport( 0 ), 0 ), -1 ) == false );
+        REQUIRE( array.SetBusCpu( -1, 0 ) == false );
+        REQUIRE( array.GetSensor( 0 ) == nullptr );
+
+        for (size_t i = 0; i < ARRAY_MAX_SENSORS; ++i)
+            REQUIRE( array.AddSensor( MakeSensor( new SlowTransport( 0 ), 0 ), i % 2 ) == true );
+
+        REQUIRE( array.AddSensor( MakeSensor( new SlowTransport( 0 ), 0 ), 0 ) == false );
+        REQUIRE( array.GetSensorCount() == ARRAY_MAX_SENSORS );
+
+        // A sensor streaming on its own
+        REQUIRE( array.GetSensor( 3 )->Start( 1000 ) == true );
+        REQUIRE( array.Start( 1000 ) == false );
+        array.GetSensor( 3 )->Stop();
+
+        REQUIRE( array.Start( 1000 ) == true );
+        REQUIRE( array.Start( 1000 ) == false );
+        REQUIRE( array.IsStreaming() == true );
+        REQUIRE( array.SetBusCpu( 0, 0 ) == false );
+        REQUIRE( array.AddSensor( MakeSensor( new SlowTransport( 0 ), 0 ), 0 ) == false );
+
+        array.Stop();
+        REQUIRE( array.IsStreaming() == false );
+    }
+
+    SECTION( "Merged ticks" )
+    {
+        sca3300Array array;
+
+        // Sensor i reads i * 100 on X, buses interleaved
+        const int buses[] = { 0, 1, 0, 2 };
+
+        for (int i = 0; i < 4; ++i)
+            REQUIRE( array.AddSensor( MakeSensor( new SlowTransport( 0 ), i * 100 ), buses[i] ) == true );
+
+        REQUIRE( array.Start( 1000 ) == true );
+        usleep( 50000 );
+        array.Stop();
+
+        std::vector<sca3300ArraySample> samples( 256 );
+        const size_t count = array.PopSamples( samples.data(), samples.size() );
+
+        REQUIRE( count > 10 );
+        REQUIRE( array.PopSamples( samples.data(), samples.size() ) == 0 );
+        REQUIRE( array.GetOverruns() == 0 );
+
+        size_t complete = 0;
+
+        for (size_t n = 0; n < count; ++n)
+        {
+            const sca3300ArraySample &sample = samples[n];
+
+            REQUIRE( sample.st_NbSensors == 4 );
+
+            // Common time base: start + sequence * period
+            REQUIRE( sample.st_Timestamp - samples[0].st_Timestamp ==
+                     (int64_t)( sample.st_Sequence - samples[0].st_Sequence ) * 1000000 );
+
+            if ( n > 0 )
+                REQUIRE( sample.st_Sequence > samples[n - 1].st_Sequence );
+
+            bool all = true;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                const sca3300RawSample &raw = sample.st_Sensors[i];
+
+                REQUIRE( raw.st_Sequence == sample.st_Sequence );
+
+                if ( !raw.st_IsValid )
+                {
+                    all = false;
+                    continue;
+                }
+
+                REQUIRE( raw.st_Accel[ACCEL_X] == i * 100 );
+                REQUIRE( raw.st_Timestamp >= sample.st_Timestamp );
+            }
+
+            complete += all ? 1 : 0;
+        }
+
+        // Only a missed deadline leaves a sensor out
+        REQUIRE( count - complete <= array.GetMissedDeadlines() );
+
+        // Restart
+        REQUIRE( array.Start( 1000 ) == true );
+        usleep( 10000 );
+        array.Stop();
+
+        REQUIRE( array.PopSamples( samples.data(), samples.size() ) > 0 );
+        REQUIRE( samples[0].st_Sequence == 0 );
+    }
+
+    SECTION( "Pinned workers" )
+    {
+        cpu_set_t allowed;
+        REQUIRE( sched_getaffinity( 0, sizeof(allowed), &allowed ) == 0 );
+
+        int target = 0;
+        while ( !CPU_ISSET( target, &allowed ) )
+            target++;
+
+        SlowTransport *pinned = new SlowTransport( 0 );
+        SlowTransport *other  = new SlowTransport( 0 );
+
+        sca3300Array array;
+        REQUIRE( array.AddSensor( MakeSensor( pinned, 1 ), 0 ) == true );
+        REQUIRE( array.AddSensor( MakeSensor( other, 2 ), 1 ) == true );
+        REQUIRE( array.SetBusCpu( 0, target ) == true );
+        REQUIRE( array.SetBusCpu( 1, ARRAY_CPU_NONE ) == true );
+
+        REQUIRE( array.Start( 500 ) == true );
+        usleep( 10000 );
+        array.Stop();
+
+        REQUIRE( pinned->cpu == target );
+    }
+
+    SECTION( "Automatic pinning" )
+    {
+        cpu_set_t allowed;
+        REQUIRE( sched_getaffinity( 0, sizeof(allowed), &allowed ) == 0 );
+
+        vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if ( CPU_ISSET( cpu, &allowed ) )
+                cpus.push_back( cpu );
+
+        // Sparse bus numbers: still one CPU each while there are enough
+        SlowTransport *first  = new SlowTransport( 0 );
+        SlowTransport *second = new SlowTransport( 0 );
+
+        sca3300Array array;
+        REQUIRE( array.AddSensor( MakeSensor( first, 1 ), 0 ) == true );
+        REQUIRE( array.AddSensor( MakeSensor( second, 2 ), 4 ) == true );
+
+        REQUIRE( array.Start( 500 ) == true );
+        usleep( 10000 );
+        array.Stop();
+
+        REQUIRE( first->cpu == cpus[0] );
+        REQUIRE( second->cpu == cpus[1 % cpus.size()] );
+    }
+
+    SECTION( "Parallel buses" )
+    {
+        // Same 4 sensors with a bus latency: one bus, then one bus each
+        sca3300Array serial, parallel;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE( serial.AddSensor( MakeSensor( new SlowTransport( 100 ), i ), 0 ) == true );
+            REQUIRE( parallel.AddSensor( MakeSensor( new SlowTransport( 100 ), i ), i ) == true );
+            REQUIRE( serial.SetBusCpu( i, ARRAY_CPU_NONE ) == true );
+            REQUIRE( parallel.SetBusCpu( i, ARRAY_CPU_NONE ) == true );
+        }
+
+        // Bus time of a tick: from the first sensor read to the last one started
+        const vector<int64_t> serialSpans   = TickSpans( serial );
+        const vector<int64_t> parallelSpans = TickSpans( parallel );
+
+        REQUIRE( serialSpans.size() > 5 );
+        REQUIRE( parallelSpans.size() > 5 );
+
+        // One bus: the 3 reads before the last one take at least their latency
+        for (const int64_t span : serialSpans)
+            REQUIRE( span >= 3 * 100000 );
+
+        // One bus each: the reads of a tick overlap (most ticks, the scheduler may delay a worker)
+        size_t overlapping = 0;
+        for (const int64_t span : parallelSpans)
+            overlapping += ( span < 100000 ) ? 1 : 0;
+
+        INFO( overlapping << " of " << parallelSpans.size() << " ticks read in parallel" );
+        REQUIRE( 2 * overlapping > parallelSpans.size() );
+    }
+}
@@ -0,0 +1,237 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+
+#include <catch.hpp>
+
+#include <sca3300-codec.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Sensor at rest: 1 g on Z in mode 3, a few LSB of noise
+ */
+static vector<sca3300RawSample> RestSamples( const size_t aCount )
+{
+    vector<sca3300RawSample> samples( aCount );
+
+    for (size_t n = 0; n < aCount; ++n)
+    {
+        samples[n].st_Timestamp = 1000000 + n * 500000;
+        samples[n].st_Sequence  = n;
+        samples[n].st_Accel[0]  = (int16_t)( 12 + rand() % 9 - 4 );
+        samples[n].st_Accel[1]  = (int16_t)( -40 + rand() % 9 - 4 );
+        samples[n].st_Accel[2]  = (int16_t)( 5400 + rand() % 9 - 4 );
+        samples[n].st_Temp      = (uint16_t)( 0x15C5 + rand() % 3 - 1 );
+        samples[n].st_Status    = 0;
+        samples[n].st_Mode      = OPMODE3;
+        samples[n].st_IsValid   = ( n % 97 != 5 );
+    }
+
+    return samples;
+}
+
+/**
+ *
+ * Delta / zig-zag / bit packing codec
+ *
+ */
+TEST_CASE( "Sample Codec" )
+{
+    srand( 23 );
+
+    SECTION( "Channel blocks, every bit width" )
+    {
+        int16_t values[CODEC_BLOCK_VALUES], decoded[CODEC_BLOCK_VALUES];
+        uint8_t encoded[CODEC_MAX_ENCODED];
+
+        for (int range = 0; range <= 16; ++range)
+            for (codecPredictor predictor : { CODEC_DELTA, CODEC_DELTA2 })
+                for (size_t count : { (size_t)1, (size_t)5, (size_t)127, CODEC_BLOCK_VALUES })
+                {
+                    for (size_t i = 0; i < count; ++i)
+                        values[i] = (int16_t)( ( range == 16 ) ? rand() : ( rand() & ( ( 1 << range ) - 1 ) ) - ( ( 1 << range ) >> 1 ) );
+
+                    const size_t size = EncodeValues( values, count, predictor, encoded );
+                    REQUIRE( size >= 8 );
+                    REQUIRE( size <= CODEC_MAX_ENCODED );
+
+                    size_t nbDecoded = 0;
+                    REQUIRE( DecodeValues( encoded, size, decoded, nbDecoded ) == size );
+                    REQUIRE( nbDecoded == count );
+
+                    for (size_t i = 0; i < count; ++i)
+                        REQUIRE( decoded[i] == values[i] );
+                }
+    }
+
+    SECTION( "Extreme steps" )
+    {
+        int16_t values[CODEC_BLOCK_VALUES], decoded[CODEC_BLOCK_VALUES];
+        uint8_t encoded[CODEC_MAX_ENCODED];
+
+        for (size_t i = 0; i < CODEC_BLOCK_VALUES; ++i)
+            values[i] = ( i & 1 ) ? INT16_MAX : INT16_MIN;
+
+        const size_t size = EncodeValues( values, CODEC_BLOCK_VALUES, CODEC_DELTA2, encoded );
+        size_t count = 0;
+        REQUIRE( DecodeValues( encoded, size, decoded, count ) == size );
+        REQUIRE( std::equal( values, values + CODEC_BLOCK_VALUES, decoded ) );
+    }
+
+    SECTION( "Bit layout" )
+    {
+        // Constant slope: every residual is the same, nothing to pack
+        int16_t values[CODEC_BLOCK_VALUES];
+        uint8_t encoded[CODEC_MAX_ENCODED];
+
+        for (size_t i = 0; i < CODEC_BLOCK_VALUES; ++i)
+            values[i] = (int16_t)( 3 * i - 100 );
+        REQUIRE( EncodeValues( values, CODEC_BLOCK_VALUES, CODEC_DELTA, encoded ) == 8 );
+
+        // Steps of +1 then -1 at values 9 and 10: zig-zag residuals 2 and 1, 2 bits.
+        // Value k * 8 + j is at bits 2k of the 16 bit word of lane j
+        std::fill( values, values + CODEC_BLOCK_VALUES, 0 );
+        values[9] = 1;
+
+        REQUIRE( EncodeValues( values, CODEC_BLOCK_VALUES, CODEC_DELTA, encoded ) == 8 + 2 * 16 );
+        REQUIRE( encoded[1] == 2 );
+        REQUIRE( encoded[8 + 2 * 1] == ( 2 << 2 ) ); // value 9: row 1, lane 1
+        REQUIRE( encoded[8 + 2 * 2] == ( 1 << 2 ) ); // value 10: row 1, lane 2
+
+        size_t nonZero = 0;
+        for (size_t i = 8; i < 8 + 2 * 16; ++i)
+            nonZero += ( 0 != encoded[i] );
+        REQUIRE( nonZero == 2 );
+    }
+
+    SECTION( "Sample stream and random access" )
+    {
+        const vector<sca3300RawSample> samples = RestSamples( 1000 );
+
+        sca3300Codec codec( CODEC_DELTA );
+        for (size_t done = 0; done < samples.size(); done += 77)
+            codec.Append( &samples[done], std::min( (size_t)77, samples.size() - done ) );
+        codec.Flush();
+
+        REQUIRE( codec.GetSampleCount() == 1000 );
+        REQUIRE( codec.GetBlockCount() == 8 );
+
+        // 10 bytes per raw sample (X, Y, Z, T, status)
+        const double ratio = 10.0 * samples.size() / codec.GetData().size();
+        REQUIRE( ratio > 3.0 );
+
+        vector<sca3300RawSample> block( CODEC_BLOCK_VALUES );
+
+        // Backwards: no block depends on another
+        for (size_t b = codec.GetBlockCount(); b-- > 0; )
+        {
+            const size_t count = codec.DecodeBlock( b, block.data() );
+            REQUIRE( count == ( b < 7 ? 128 : 1000 - 7 * 128 ) );
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const sca3300RawSample &sample = samples[b * 128 + i];
+
+                REQUIRE( block[i].st_Accel[0] == sample.st_Accel[0] );
+                REQUIRE( block[i].st_Accel[1] == sample.st_Accel[1] );
+                REQUIRE( block[i].st_Accel[2] == sample.st_Accel[2] );
+                REQUIRE( block[i].st_Temp == sample.st_Temp );
+                REQUIRE( block[i].st_Status == sample.st_Status );
+                REQUIRE( block[i].st_Sequence == sample.st_Sequence );
+                REQUIRE( block[i].st_Timestamp == sample.st_Timestamp );
+                REQUIRE( block[i].st_Mode == OPMODE3 );
+                REQUIRE( block[i].st_IsValid == sample.st_IsValid );
+            }
+        }
+
+        REQUIRE( codec.DecodeBlock( 8, block.data() ) == 0 );
+    }
+
+    SECTION( "Decode from the bytes, exact timestamps" )
+    {
+        // Timestamps with a jitter and a long pause
+        vector<sca3300RawSample> samples = RestSamples( 300 );
+        for (size_t n = 1; n < samples.size(); ++n)
+            samples[n].st_Timestamp = samples[n - 1].st_Timestamp + 500000 + rand() % 20001 - 10000;
+        for (size_t n = 200; n < samples.size(); ++n)
+            samples[n].st_Timestamp += 5000000000LL;
+
+        sca3300Codec codec( CODEC_DELTA2 );
+        codec.Append( samples.data(), samples.size() );
+        codec.Flush();
+
+        // 128, 72 then a new block after the 5 s step: 100
+        REQUIRE( codec.GetBlockCount() == 3 );
+
+        const vector<uint8_t> bytes = codec.GetData();
+
+        sca3300Codec loaded;
+        REQUIRE( loaded.Load( bytes.data(), bytes.size() ) == true );
+        REQUIRE( loaded.GetBlockCount() == 3 );
+        REQUIRE( loaded.GetSampleCount() == 300 );
+        REQUIRE( loaded.GetData() == bytes );
+
+        vector<sca3300RawSample> block( CODEC_BLOCK_VALUES );
+        size_t n = 0;
+
+        for (size_t b = 0; b < loaded.GetBlockCount(); ++b)
+        {
+            const size_t count = loaded.DecodeBlock( b, block.data() );
+            REQUIRE( count > 0 );
+
+            for (size_t i = 0; i < count; ++i, ++n)
+            {
+                REQUIRE( block[i].st_Timestamp == samples[n].st_Timestamp );
+                REQUIRE( block[i].st_Sequence == samples[n].st_Sequence );
+                REQUIRE( block[i].st_Accel[2] == samples[n].st_Accel[2] );
+                REQUIRE( block[i].st_IsValid == samples[n].st_IsValid );
+            }
+        }
+        REQUIRE( n == samples.size() );
+
+        // Straight from the bytes, block after block
+        size_t offset = 0, count = 0, total = 0;
+        while ( offset < bytes.size() )
+        {
+            const size_t used = DecodeSampleBlock( &bytes[offset], bytes.size() - offset, block.data(), count );
+            REQUIRE( used > 0 );
+            offset += used;
+            total  += count;
+        }
+        REQUIRE( total == samples.size() );
+
+        // Truncated or corrupted bytes
+        REQUIRE( loaded.Load( bytes.data(), bytes.size() - 1 ) == false );
+        REQUIRE( loaded.GetBlockCount() == 0 );
+        REQUIRE( DecodeSampleBlock( bytes.data(), 20, block.data(), count ) == 0 );
+
+        vector<uint8_t> corrupted = bytes;
+        corrupted[8] ^= 0x01; // first timestamp of the first block
+        REQUIRE( DecodeSampleBlock( corrupted.data(), corrupted.size(), block.data(), count ) == 0 );
+    }
+
+    SECTION( "Gap and mode change close the block" )
+    {
+        vector<sca3300RawSample> samples = RestSamples( 100 );
+        for (size_t n = 30; n < 100; ++n)
+            samples[n].st_Sequence += 2;
+        for (size_t n = 60; n < 100; ++n)
+            samples[n].st_Mode = OPMODE1;
+
+        sca3300Codec codec( CODEC_DELTA2 );
+        codec.Append( samples.data(), samples.size() );
+        codec.Flush();
+
+        REQUIRE( codec.GetBlockCount() == 3 );
+
+        vector<sca3300RawSample> block( CODEC_BLOCK_VALUES );
+        REQUIRE( codec.DecodeBlock( 1, block.data() ) == 30 );
+        REQUIRE( block[0].st_Sequence == 32 );
+        REQUIRE( codec.DecodeBlock( 2, block.data() ) == 40 );
+        REQUIRE( block[39].st_Mode == OPMODE1 );
+        REQUIRE( block[39].st_Accel[2] == samples[99].st_Accel[2] );
+    }
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+
+#include <catch.hpp>
+
+#include <sca3300-decimator.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * Boxcar / CIC decimation of raw samples
+ *
+ */
+TEST_CASE( "Raw Sample Decimation" )
+{
+    const size_t NB_SAMPLES = 4000;
+
+    vector<sca3300RawSample> input( NB_SAMPLES );
+    vector<sca3300RawSample> output( NB_SAMPLES );
+
+    srand( 11 );
+    for (size_t n = 0; n < NB_SAMPLES; ++n)
+    {
+        input[n].st_Timestamp = n * 500000;
+        input[n].st_Accel[0]  = (int16_t)( rand() % 20001 - 10000 );
+        input[n].st_Accel[1]  = -1000;
+        input[n].st_Accel[2]  = 5400;
+        input[n].st_Temp      = 0x15C5;
+        input[n].st_Mode      = OPMODE3;
+        input[n].st_IsValid   = true;
+    }
+
+    sca3300Decimator decimator;
+
+    SECTION( "Invalid configurations" )
+    {
+        REQUIRE( decimator.Configure( 0 ) == false );
+        REQUIRE( decimator.Configure( 10, 0 ) == false );
+        REQUIRE( decimator.Configure( 10, sca3300Decimator::MAX_STAGES + 1 ) == false );
+        REQUIRE( decimator.Configure( 100000, 5 ) == false );
+        REQUIRE( decimator.GetFactor() == 1 );
+    }
+
+    SECTION( "Boxcar" )
+    {
+        REQUIRE( decimator.Configure( 20 ) == true );
+        REQUIRE( decimator.Process( input.data(), NB_SAMPLES, output.data() ) == NB_SAMPLES / 20 );
+
+        for (size_t m = 0; m < NB_SAMPLES / 20; ++m)
+        {
+            int sum = 0;
+            for (size_t n = 0; n < 20; ++n)
+                sum += input[20 * m + n].st_Accel[0];
+
+            REQUIRE( output[m].st_Accel[0] == lround( sum / 20.0 ) );
+            REQUIRE( output[m].st_Accel[1] == -1000 );
+            REQUIRE( output[m].st_Temp == 0x15C5 );
+            REQUIRE( output[m].st_Sequence == m );
+            REQUIRE( output[m].st_Timestamp == input[20 * m + 19].st_Timestamp );
+            REQUIRE( output[m].st_Mode == OPMODE3 );
+        }
+    }
+
+    for (int stages = 2; stages <= sca3300Decimator::MAX_STAGES; ++stages)
+    {
+        SECTION( "CIC against convolution, " + std::to_string( stages ) + " stages" )
+        {
+            const size_t R = 8;
+
+            // Impulse response: N boxcars of length R convolved
+            vector<double> h( 1, 1.0 );
+            for (int s = 0; s < stages; ++s)
+            {
+                vector<double> next( h.size() + R - 1, 0.0 );
+                for (size_t i = 0; i < h.size(); ++i)
+                    for (size_t k = 0; k < R; ++k)
+                        next[i + k] += h[i] / R;
+                h = next;
+            }
+
+            REQUIRE( decimator.Configure( R, stages ) == true );
+
+            // Arbitrary block boundaries
+            size_t nbOut = 0;
+            for (size_t done = 0; done < NB_SAMPLES; )
+            {
+                const size_t block = std::min( (size_t)( 1 + rand() % 50 ), NB_SAMPLES - done );
+                nbOut += decimator.Process( &input[done], block, &output[nbOut] );
+                done += block;
+            }
+            REQUIRE( nbOut == NB_SAMPLES / R );
+
+            for (size_t m = h.size() / R + 1; m < nbOut; ++m)
+            {
+                const size_t last = R * m + R - 1;
+
+                double reference = 0.0;
+                for (size_t i = 0; i < h.size(); ++i)
+                    reference += h[i] * input[last - i].st_Accel[0];
+
+                REQUIRE( std::fabs( output[m].st_Accel[0] - reference ) <= 0.5 + 1e-9 );
+                REQUIRE( output[m].st_Accel[2] == 5400 );
+            }
+        }
+    }
+
+    SECTION( "Droop compensation keeps the DC gain" )
+    {
+        REQUIRE( decimator.Configure( 10, 3, true ) == true );
+
+        const size_t nbOut = decimator.Process( input.data(), NB_SAMPLES, output.data() );
+        REQUIRE( nbOut == NB_SAMPLES / 10 );
+
+        // Skip the CIC transient (stages outputs) and the FIR delay
+        for (size_t m = 4; m < nbOut; ++m)
+        {
+            REQUIRE( output[m].st_Accel[1] == -1000 );
+            REQUIRE( output[m].st_Accel[2] == 5400 );
+            REQUIRE( output[m].st_Temp == 0x15C5 );
+        }
+    }
+
+    SECTION( "Status and validity of a period" )
+    {
+        REQUIRE( decimator.Configure( 4 ) == true );
+
+        input[5].st_IsValid = false;
+        input[6].st_Status  = 0x0002;
+
+        REQUIRE( decimator.Process( input.data(), 12, output.data() ) == 3 );
+        REQUIRE( output[0].st_IsValid == true );
+        REQUIRE( output[1].st_IsValid == false );
+        REQUIRE( output[1].st_Status == 0x0002 );
+        REQUIRE( output[2].st_IsValid == true );
+        REQUIRE( output[2].st_Status == 0 );
+    }
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <vector>
+#include <stdlib.h>     /* srand, rand */
+
+#include <catch.hpp>
+
+#include <sca3300-tools.h>
+#include <sca3300-decode.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Decoded fields of a block, owns the arrays
+ */
+struct decodedBlock
+{
+    vector<uint8_t>  opCode, returnStatus, crcValid;
+    vector<uint16_t> data;
+
+    explicit decodedBlock( const size_t aCount )
+        : opCode( aCount ), returnStatus( aCount ), crcValid( aCount ), data( aCount ) {}
+
+    sca3300FrameBlock Block( void )
+    {
+        return sca3300FrameBlock{ opCode.data(), returnStatus.data(), data.data(), crcValid.data() };
+    }
+};
+
+/**
+ *
+ * Batch frame decoder, every path against the scalar one
+ *
+ */
+TEST_CASE( "Batch Frame Decoder" )
+{
+    // Odd count: exercises the scalar tail of every vector path
+    const size_t NB_FRAMES = 1003;
+
+    vector<uint8_t> rx( NB_FRAMES * 4 );
+
+    srand( 7 );
+    for (size_t i = 0; i < NB_FRAMES; ++i)
+    {
+        const uint32_t frame = ( (uint32_t)rand() << 8 ) & 0xFFFFFF00;
+
+        rx[4 * i + 0] = frame >> 24;
+        rx[4 * i + 1] = frame >> 16;
+        rx[4 * i + 2] = frame >> 8;
+        rx[4 * i + 3] = CalculateCRC( frame ) ^ ( ( i % 5 ) ? 0 : ( 1 << ( i % 8 ) ) ); // corrupt 1 frame out of 5
+    }
+
+    decodedBlock reference( NB_FRAMES );
+    const size_t nbValid = DecodeFrames( rx.data(), NB_FRAMES, reference.Block(), DECODE_SCALAR );
+
+    SECTION( "Scalar fields" )
+    {
+        REQUIRE( nbValid == NB_FRAMES - ( NB_FRAMES + 4 ) / 5 );
+
+        for (size_t i = 0; i < NB_FRAMES; ++i)
+        {
+            const uint32_t frame = ( (uint32_t)rx[4 * i] << 24 ) | ( rx[4 * i + 1] << 16 ) | ( rx[4 * i + 2] << 8 ) | rx[4 * i + 3];
+
+            REQUIRE( reference.opCode[i] == ( frame & OPCODE_FIELD_MASK ) >> 26 );
+            REQUIRE( reference.returnStatus[i] == ( frame & RS_FIELD_MASK ) >> 24 );
+            REQUIRE( reference.data[i] == ( frame & DATA_FIELD_MASK ) >> 8 );
+            REQUIRE( reference.crcValid[i] == ( ( i % 5 ) ? 1 : 0 ) );
+        }
+    }
+
+    const decodePath PATHS[] = { DECODE_AUTO, DECODE_SSSE3, DECODE_AVX2, DECODE_NEON };
+
+    for (const decodePath path : PATHS)
+    {
+        SECTION( "Path " + std::to_string( path ) )
+        {
+            if ( !IsDecodePathSupported( path ) )
+            {
+                WARN( "decode path " << path << " not supported on this CPU" );
+                continue;
+            }
+
+            decodedBlock block( NB_FRAMES );
+
+            REQUIRE( DecodeFrames( rx.data(), NB_FRAMES, block.Block(), path ) == nbValid );
+            REQUIRE( block.opCode == reference.opCode );
+            REQUIRE( block.returnStatus == reference.returnStatus );
+            REQUIRE( block.data == reference.data );
+            REQUIRE( block.crcValid == reference.crcValid );
+        }
+    }
+}
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+
+#include <catch.hpp>
+
+#include <sca3300-filter.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Direct form I biquad in double, reference of the filter bank
+ */
+static vector<double> ReferenceBiquad( const sca3300Biquad &aBiquad, const vector<double> &aIn )
+{
+    vector<double> out( aIn.size() );
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+    for (size_t n = 0; n < aIn.size(); ++n)
+    {
+        out[n] = aBiquad.st_B0 * aIn[n] + aBiquad.st_B1 * x1 + aBiquad.st_B2 * x2
+               - aBiquad.st_A1 * y1 - aBiquad.st_A2 * y2;
+        x2 = x1; x1 = aIn[n];
+        y2 = y1; y1 = out[n];
+    }
+
+    return out;
+}
+
+/**
+ * @brief      Amplitude of the last aLength outputs
+ */
+static float Amplitude( const vector<float> &aFrames, const int aLane, const size_t aLength )
+{
+    float amplitude = 0.0f;
+
+    for (size_t n = aFrames.size() / 4 - aLength; n < aFrames.size() / 4; ++n)
+        amplitude = std::max( amplitude, std::fabs( aFrames[4 * n + aLane] ) );
+
+    return amplitude;
+}
+
+/**
+ *
+ * Filter bank
+ *
+ */
+TEST_CASE( "Filter Bank" )
+{
+    const float RATE = 2000.0f;
+    const size_t NB_FRAMES = 4000;
+
+    sca3300FilterBank bank;
+    sca3300Biquad biquad;
+    vector<float> taps;
+
+    SECTION( "Invalid designs" )
+    {
+        REQUIRE( DesignBiquad( FILTER_LOWPASS, RATE, 0.0f, 0.707f, biquad ) == false );
+        REQUIRE( DesignBiquad( FILTER_LOWPASS, RATE, 1000.0f, 0.707f, biquad ) == false );
+        REQUIRE( DesignBiquad( FILTER_NOTCH, RATE, 50.0f, 0.0f, biquad ) == false );
+        REQUIRE( DesignFir( FILTER_LOWPASS, RATE, 50.0f, 32, taps ) == false );
+        REQUIRE( DesignFir( FILTER_NOTCH, RATE, 50.0f, 31, taps ) == false );
+        REQUIRE( taps.empty() );
+    }
+
+    SECTION( "Lanes against a scalar reference" )
+    {
+        sca3300Biquad first, second;
+        REQUIRE( DesignBiquad( FILTER_LOWPASS, RATE, 40.0f, 0.5412f, first ) == true );
+        REQUIRE( DesignBiquad( FILTER_LOWPASS, RATE, 40.0f, 1.3066f, second ) == true );
+
+        bank.AddBiquad( first );
+        bank.AddBiquad( second );
+
+        srand( 7 );
+        vector<double> lanes[4];
+        vector<float> frames( NB_FRAMES * 4 );
+
+        for (size_t n = 0; n < NB_FRAMES; ++n)
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const float value = ( rand() % 2001 - 1000 ) / 1000.0f + lane;
+                frames[4 * n + lane] = value;
+                lanes[lane].push_back( value );
+            }
+
+        // Arbitrary block boundaries, in place
+        for (size_t done = 0; done < NB_FRAMES; )
+        {
+            const size_t block = std::min( (size_t)( 1 + rand() % 100 ), NB_FRAMES - done );
+            bank.Process( &frames[4 * done], &frames[4 * done], block );
+            done += block;
+        }
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const vector<double> reference = ReferenceBiquad( second, ReferenceBiquad( first, lanes[lane] ) );
+
+            for (size_t n = 0; n < NB_FRAMES; ++n)
+                REQUIRE( frames[4 * n + lane] == Approx( reference[n] ).margin( 1e-4 ) );
+        }
+    }
+
+    SECTION( "Biquad responses" )
+    {
+        vector<float> dc( NB_FRAMES * 4, 1.0f );
+        vector<float> out( NB_FRAMES * 4 );
+
+        REQUIRE( DesignBiquad( FILTER_LOWPASS, RATE, 10.0f, 0.7071f, biquad ) == true );
+        bank.AddBiquad( biquad );
+        bank.Process( dc.data(), out.data(), NB_FRAMES );
+        REQUIRE( out[4 * NB_FRAMES - 1] == Approx( 1.0f ).margin( 1e-4 ) );
+
+        bank.Clear();
+        REQUIRE( DesignBiquad( FILTER_HIGHPASS, RATE, 10.0f, 0.7071f, biquad ) == true );
+        bank.AddBiquad( biquad );
+        bank.Process( dc.data(), out.data(), NB_FRAMES );
+        REQUIRE( Amplitude( out, 0, 100 ) < 1e-4 );
+
+        // 50 Hz notch: 50 Hz removed, 200 Hz kept
+        bank.Clear();
+        REQUIRE( DesignBiquad( FILTER_NOTCH, RATE, 50.0f, 5.0f, biquad ) == true );
+        bank.AddBiquad( biquad );
+
+        vector<float> tones( NB_FRAMES * 4 );
+        for (size_t n = 0; n < NB_FRAMES; ++n)
+        {
+            tones[4 * n + 0] = sin( 2 * M_PI * 50.0 * n / RATE );
+            tones[4 * n + 1] = sin( 2 * M_PI * 200.0 * n / RATE );
+        }
+
+        bank.Process( tones.data(), out.data(), NB_FRAMES );
+        REQUIRE( Amplitude( out, 0, 400 ) < 0.01f );
+        REQUIRE( Amplitude( out, 1, 400 ) > 0.95f );
+    }
+
+    SECTION( "FIR" )
+    {
+        vector<float> dc( NB_FRAMES * 4, -0.5f );
+        vector<float> out( NB_FRAMES * 4 );
+
+        REQUIRE( DesignFir( FILTER_LOWPASS, RATE, 100.0f, 31, taps ) == true );
+        REQUIRE( taps.size() == 31 );
+        REQUIRE( taps[0] == Approx( taps[30] ) );
+
+        bank.SetFir( taps );
+        bank.Process( dc.data(), out.data(), NB_FRAMES );
+        REQUIRE( out[4 * 30 + 2] == Approx( -0.5f ).margin( 1e-5 ) );
+        REQUIRE( out[4 * NB_FRAMES - 1] == Approx( -0.5f ).margin( 1e-5 ) );
+
+        // Impulse response is the taps
+        vector<float> impulse( 64 * 4, 0.0f );
+        impulse[0] = impulse[1] = 1.0f;
+        bank.Reset();
+        bank.Process( impulse.data(), out.data(), 64 );
+        for (size_t n = 0; n < taps.size(); ++n)
+            REQUIRE( out[4 * n + 1] == Approx( taps[n] ).margin( 1e-6 ) );
+
+        REQUIRE( DesignFir( FILTER_HIGHPASS, RATE, 100.0f, 31, taps ) == true );
+        bank.SetFir( taps );
+        bank.Process( dc.data(), out.data(), NB_FRAMES );
+        REQUIRE( Amplitude( out, 3, 100 ) < 1e-5 );
+    }
+
+    SECTION( "Samples" )
+    {
+        REQUIRE( DesignBiquad( FILTER_HIGHPASS, RATE, 1.0f, 0.7071f, biquad ) == true );
+        bank.AddBiquad( biquad );
+
+        vector<sca3300Sample> samples( 200 );
+        for (sca3300Sample &sample : samples)
+        {
+            sample.st_Accel[0] = 0.25f;
+            sample.st_Accel[2] = 1.0f;
+            sample.st_Temp = 26.0f;
+        }
+
+        bank.Process( samples.data(), samples.size() );
+
+        REQUIRE( samples[0].st_Accel[2] == Approx( biquad.st_B0 ) );
+        REQUIRE( samples[199].st_Accel[2] < samples[0].st_Accel[2] );
+        REQUIRE( samples[199].st_Accel[1] == 0.0f );
+        REQUIRE( samples[199].st_Temp == 26.0f );
+    }
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <memory>
+#include <cmath>
+#include <vector>
+
+#include <catch.hpp>
+
+#include <sca3300-fixed.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/* Constants are usable at compile time */
+static_assert( sca3300ModeTraits<OPMODE2>::WRITE_MODE == REQ_WRITE_MODE2, "Mode 2 write frame" );
+static_assert( sca3300ModeTraits<OPMODE4>::WRITE_MODE == REQ_WRITE_MODE4, "Mode 4 write frame" );
+static_assert( sca3300ModeTraits<OPMODE1>::SATURATION == 8100, "Mode 1 full scale" );
+static_assert( sca3300Fixed<OPMODE3>::ToG( SENSITIVITY_MODE_3_4 ) == 1.0f, "Mode 3 conversion" );
+
+/**
+ *
+ * Measurement mode fixed at build time
+ *
+ */
+TEST_CASE( "Fixed Mode Driver" )
+{
+    sca3300SimTransport *sim = new sca3300SimTransport();
+    sca3300Fixed<OPMODE2> chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+    SECTION( "Mode written to the device" )
+    {
+        REQUIRE( sim->GetRegister( REG_MODE ) == OPMODE2 - OPMODE1 );
+    }
+
+    SECTION( "Conversion against the runtime path" )
+    {
+        for (int raw = INT16_MIN; raw <= INT16_MAX; raw += 7)
+        {
+            const float reference = ProcessAccel( (int16_t)raw, SENSITIVITY_MODE_2 );
+            REQUIRE( std::fabs( sca3300Fixed<OPMODE2>::ToG( (int16_t)raw ) - reference ) <= std::fabs( reference ) * 1.2e-7f );
+        }
+
+        REQUIRE( sca3300Fixed<OPMODE2>::IsSaturated( 8100 ) == true );
+        REQUIRE( sca3300Fixed<OPMODE2>::IsSaturated( -8100 ) == true );
+        REQUIRE( sca3300Fixed<OPMODE2>::IsSaturated( 8099 ) == false );
+    }
+
+    SECTION( "Samples" )
+    {
+        sim->SetRegister( REG_ACC_Y, (uint16_t)-675 );
+
+        sca3300Sample sample;
+        REQUIRE( chip.ReadSample( sample ) == true );
+        REQUIRE( sample.st_Accel[ACCEL_Y] == -0.5f );
+        REQUIRE( sample.st_Accel[ACCEL_Z] == ( SENSITIVITY_MODE_3_4 * sca3300ModeTraits<OPMODE2>::G_PER_LSB ) );
+
+        REQUIRE( chip.Start( 1000 ) == true );
+        usleep( 10000 );
+        chip.Stop();
+
+        sca3300Sample samples[4];
+        REQUIRE( chip.PopSamples( samples, 4 ) == 4 );
+        REQUIRE( samples[3].st_Sequence == 3 );
+        REQUIRE( samples[3].st_Accel[ACCEL_Y] == -0.5f );
+    }
+}
+
+
+/**
+ * @brief      Simulated device logging the requests it receives
+ */
+class LoggingTransport : public sca3300SimTransport
+{
+    public:
+        bool Transfer( const uint8_t *aTx, uint8_t *aRx, const size_t aCount, const uint32_t aGapUs )
+        {
+            for (size_t i = 0; i < aCount; ++i)
+            {
+                const uint8_t *tx = aTx + i * SCA3300_FRAME_SIZE_BYTES;
+                requests.push_back( ( (uint32_t)tx[0] << 24 ) | ( tx[1] << 16 ) | ( tx[2] << 8 ) | tx[3] );
+            }
+
+            return sca3300SimTransport::Transfer( aTx, aRx, aCount, aGapUs );
+        }
+
+        std::vector<uint32_t> requests;
+};
+
+
+TEST_CASE( "Fixed Mode Power Up" )
+{
+    LoggingTransport *log = new LoggingTransport();
+    sca3300Fixed<OPMODE1> chip { std::unique_ptr<sca3300Transport>( log ) };
+
+    // Datasheet sequence: the mode once, then STATUS read to clear the flags
+    size_t writes = 0, statusAfter = 0;
+
+    for (const uint32_t request : log->requests)
+    {
+        if ( ( request & 0x80000000 ) && ( request & ADDR_FIELD_MASK ) >> 26 == REG_MODE )
+        {
+            REQUIRE( request == REQ_WRITE_MODE1 );
+            REQUIRE( request == sca3300Fixed<OPMODE1>::traits::WRITE_MODE );
+            REQUIRE( statusAfter == 0 );
+            writes++;
+        }
+        else if ( request == REQ_READ_STATUS && writes > 0 )
+        {
+            statusAfter++;
+        }
+    }
+
+    REQUIRE( writes == 1 );
+    REQUIRE( statusAfter >= 2 );
+    REQUIRE( log->GetRegister( REG_MODE ) == OPMODE1 - OPMODE1 );
+}
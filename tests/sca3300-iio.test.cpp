@@ -0,0 +1,189 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <catch.hpp>
+
+#include <sca3300-iio.h>
+#include <sca3300-tools.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Fake IIO device: sysfs tree in a temporary directory and a FIFO as character device
+ */
+struct FakeIioDevice
+{
+    std::string root;
+
+    FakeIioDevice()
+    {
+        char tmpl[] = "/tmp/sca3300-iio-XXXXXX";
+        root = mkdtemp( tmpl );
+
+        const std::string dev = root + "/sys/iio:device0";
+        mkdir( ( root + "/sys" ).c_str(), 0755 );
+        mkdir( dev.c_str(), 0755 );
+        mkdir( ( dev + "/scan_elements" ).c_str(), 0755 );
+        mkdir( ( dev + "/buffer" ).c_str(), 0755 );
+        mkdir( ( root + "/dev" ).c_str(), 0755 );
+        mkfifo( ( root + "/dev/iio:device0" ).c_str(), 0600 );
+
+        const char *NAMES[] = { "in_accel_x", "in_accel_y", "in_accel_z", "in_temp", "in_timestamp" };
+        for (int i = 0; i < 5; ++i)
+        {
+            Write( std::string( "scan_elements/" ) + NAMES[i] + "_index", std::to_string( i ) );
+            Write( std::string( "scan_elements/" ) + NAMES[i] + "_type", i < 4 ? "le:s16/16>>0" : "le:s64/64>>0" );
+        }
+    }
+
+    ~FakeIioDevice()
+    {
+        std::system( ( "rm -rf " + root ).c_str() );
+    }
+
+    void Write( const std::string &aAttr, const std::string &aValue )
+    {
+        std::ofstream( root + "/sys/iio:device0/" + aAttr ) << aValue << std::endl;
+    }
+
+    std::string Read( const std::string &aAttr )
+    {
+        std::string value;
+        std::ifstream file( root + "/sys/iio:device0/" + aAttr );
+        std::getline( file, value );
+        return value;
+    }
+};
+
+/**
+ *
+ * IIO buffered capture
+ *
+ */
+TEST_CASE( "IIO Buffered Capture" )
+{
+    FakeIioDevice fake;
+    sca3300Iio iio( 0, fake.root + "/sys", fake.root + "/dev" );
+
+    REQUIRE( iio.Configure( 64, 4 ) == true );
+    REQUIRE( fake.Read( "buffer/enable" ) == "1" );
+    REQUIRE( fake.Read( "buffer/length" ) == "64" );
+    REQUIRE( fake.Read( "buffer/watermark" ) == "4" );
+    REQUIRE( fake.Read( "current_timestamp_clock" ) == "monotonic" );
+    REQUIRE( fake.Read( "scan_elements/in_accel_x_en" ) == "1" );
+
+    int writer = open( ( fake.root + "/dev/iio:device0" ).c_str(), O_WRONLY | O_NONBLOCK );
+    REQUIRE( writer >= 0 );
+
+    /* x, y, z, temp (s16 le), padding to 8 bytes, timestamp (s64 le) */
+    const int16_t RAW[3][4] = { { 1000, -2000, 5400, 0x15C5 },
+                                {  -16,    16, 2700, 0x15A2 },
+                                {    0,     0,    0, 0x142B } };
+    uint8_t scans[3][16];
+    memset( scans, 0, sizeof(scans) );
+    for (int n = 0; n < 3; ++n)
+    {
+        const int64_t timestamp = 1000000LL * ( n + 1 );
+        memcpy( scans[n], RAW[n], sizeof(RAW[n]) );
+        memcpy( scans[n] + 8, &timestamp, sizeof(timestamp) );
+    }
+
+    sca3300Sample samples[8];
+
+    SECTION( "Whole scans" )
+    {
+        REQUIRE( write( writer, scans, sizeof(scans) ) == sizeof(scans) );
+        REQUIRE( iio.ReadSamples( samples, 8, 1000 ) == 3 );
+
+        for (int n = 0; n < 3; ++n)
+        {
+            for (int axe = ACCEL_X; axe <= ACCEL_Z; ++axe)
+                REQUIRE( samples[n].st_Accel[axe] == ProcessAccel( (int16_t)RAW[n][axe], SENSITIVITY_MODE_1 ) );
+            REQUIRE( samples[n].st_Temp == ConvertTemperature( RAW[n][3] ) );
+            REQUIRE( samples[n].st_Timestamp == 1000000LL * ( n + 1 ) );
+            REQUIRE( samples[n].st_Sequence == (uint32_t)n );
+        }
+    }
+
+    SECTION( "Partial scan" )
+    {
+        REQUIRE( write( writer, scans[0], 10 ) == 10 );
+        REQUIRE( iio.ReadSamples( samples, 8, 1000 ) == 0 );
+        REQUIRE( write( writer, scans[0] + 10, 6 ) == 6 );
+        REQUIRE( iio.ReadSamples( samples, 8, 1000 ) == 1 );
+        REQUIRE( samples[0].st_Temp == ConvertTemperature( RAW[0][3] ) );
+    }
+
+    SECTION( "Disabled channels" )
+    {
+        REQUIRE( iio.Configure( 64, 4, sca3300Iio::IIO_ACCEL_Z | sca3300Iio::IIO_TEMP ) == true );
+        REQUIRE( fake.Read( "scan_elements/in_accel_x_en" ) == "0" );
+
+        close( writer );
+        writer = open( ( fake.root + "/dev/iio:device0" ).c_str(), O_WRONLY | O_NONBLOCK );
+
+        const int16_t packed[2] = { 2700, 0x15A2 };
+        REQUIRE( write( writer, packed, sizeof(packed) ) == sizeof(packed) );
+        REQUIRE( iio.ReadSamples( samples, 8, 1000 ) == 1 );
+        REQUIRE( samples[0].st_Accel[ACCEL_X] == 0.0 );
+        REQUIRE( samples[0].st_Accel[ACCEL_Z] == ProcessAccel( 2700, SENSITIVITY_MODE_1 ) );
+    }
+
+    close( writer );
+
+    REQUIRE( iio.Disable() == true );
+    REQUIRE( fake.Read( "buffer/enable" ) == "0" );
+}
+
+
+TEST_CASE( "IIO Buffer Recovery" )
+{
+    FakeIioDevice fake;
+    sca3300Iio iio( 0, fake.root + "/sys", fake.root + "/dev" );
+
+    SECTION( "Buffer left enabled by another process" )
+    {
+        fake.Write( "buffer/enable", "1" );
+
+        REQUIRE( iio.Disable() == true );
+        REQUIRE( fake.Read( "buffer/enable" ) == "0" );
+    }
+
+    SECTION( "Character device missing" )
+    {
+        unlink( ( fake.root + "/dev/iio:device0" ).c_str() );
+
+        REQUIRE( iio.Configure( 64, 4 ) == false );
+        REQUIRE( fake.Read( "buffer/enable" ) == "0" );
+    }
+
+    SECTION( "Timestamp clock not settable" )
+    {
+        // A directory instead of the attribute: the write fails
+        mkdir( ( fake.root + "/sys/iio:device0/current_timestamp_clock" ).c_str(), 0755 );
+
+        REQUIRE( iio.Configure( 64, 4 ) == false );
+        REQUIRE( fake.Read( "buffer/enable" ) == "0" );
+    }
+
+    SECTION( "Malformed scan element index" )
+    {
+        fake.Write( "scan_elements/in_accel_y_index", "garbage" );
+
+        REQUIRE( iio.Configure( 64, 4 ) == false );
+    }
+
+    SECTION( "Zero bits scan element" )
+    {
+        fake.Write( "scan_elements/in_accel_z_type", "le:s0/16>>0" );
+
+        REQUIRE( iio.Configure( 64, 4 ) == false );
+    }
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+
+#include <catch.hpp>
+
+#include <sca3300-inclination.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * Inclination
+ *
+ */
+TEST_CASE( "Inclination" )
+{
+    SECTION( "Fast atan2 maximum error" )
+    {
+        double maxError = 0.0;
+
+        for (int i = 0; i <= 1000000; ++i)
+        {
+            const double angle = -M_PI + 2 * M_PI * i / 1000000.0;
+            const float radius = ( i % 7 + 1 ) * 0.37f;
+            const float y = radius * sin( angle );
+            const float x = radius * cos( angle );
+
+            maxError = std::max( maxError, std::fabs( FastAtan2( y, x ) - atan2( (double)y, (double)x ) ) );
+        }
+
+        REQUIRE( maxError <= FAST_ATAN2_MAX_ERROR );
+
+        REQUIRE( FastAtan2( 0.0f, 0.0f ) == 0.0f );
+        REQUIRE( FastAtan2( 1.0f, 0.0f ) == Approx( M_PI / 2 ) );
+        REQUIRE( FastAtan2( -1.0f, 0.0f ) == Approx( -M_PI / 2 ) );
+        REQUIRE( FastAtan2( 0.0f, -1.0f ) == Approx( M_PI ) );
+    }
+
+    SECTION( "Known positions" )
+    {
+        const float flat[3]   = { 0.0f, 0.0f, 1.0f };
+        const float xUp[3]    = { 1.0f, 0.0f, 0.0f };
+        const float rolled[3] = { 0.0f, 0.5f, 0.8660254f };
+
+        for (inclinationMethod method : { INCLINATION_LIBM, INCLINATION_FAST })
+        {
+            sca3300Inclination inclination = ComputeInclination( flat, method );
+            REQUIRE( inclination.st_Pitch == Approx( 0.0f ).margin( 1e-3 ) );
+            REQUIRE( inclination.st_Roll == Approx( 0.0f ).margin( 1e-3 ) );
+            REQUIRE( inclination.st_Tilt == Approx( 0.0f ).margin( 1e-3 ) );
+
+            inclination = ComputeInclination( xUp, method );
+            REQUIRE( inclination.st_Pitch == Approx( 90.0f ).margin( 1e-3 ) );
+            REQUIRE( inclination.st_Tilt == Approx( 90.0f ).margin( 1e-3 ) );
+
+            inclination = ComputeInclination( rolled, method );
+            REQUIRE( inclination.st_Roll == Approx( 30.0f ).margin( 1e-3 ) );
+            REQUIRE( inclination.st_Tilt == Approx( 30.0f ).margin( 1e-3 ) );
+        }
+    }
+
+    SECTION( "Blocks" )
+    {
+        const size_t NB_SAMPLES = 1003;
+        const float MAX_ERROR_DEG = FAST_ATAN2_MAX_ERROR * 180 / M_PI + 1e-4;
+
+        srand( 19 );
+        vector<float> frames( NB_SAMPLES * 4 );
+        vector<sca3300Sample> samples( NB_SAMPLES );
+
+        for (size_t n = 0; n < NB_SAMPLES; ++n)
+            for (int axe = 0; axe < 3; ++axe)
+            {
+                frames[4 * n + axe] = ( rand() % 6001 - 3000 ) / 1000.0f;
+                samples[n].st_Accel[axe] = frames[4 * n + axe];
+            }
+
+        vector<sca3300Inclination> fast( NB_SAMPLES ), libm( NB_SAMPLES ), fromSamples( NB_SAMPLES );
+
+        ComputeInclinationBlock( frames.data(), 4, fast.data(), NB_SAMPLES, INCLINATION_FAST );
+        ComputeInclinationBlock( frames.data(), 4, libm.data(), NB_SAMPLES, INCLINATION_LIBM );
+        ComputeInclinationBlock( samples.data(), fromSamples.data(), NB_SAMPLES );
+
+        for (size_t n = 0; n < NB_SAMPLES; ++n)
+        {
+            REQUIRE( std::fabs( fast[n].st_Pitch - libm[n].st_Pitch ) <= MAX_ERROR_DEG );
+            REQUIRE( std::fabs( fast[n].st_Roll - libm[n].st_Roll ) <= MAX_ERROR_DEG );
+            REQUIRE( std::fabs( fast[n].st_Tilt - libm[n].st_Tilt ) <= MAX_ERROR_DEG );
+            REQUIRE( fromSamples[n].st_Tilt == fast[n].st_Tilt );
+        }
+    }
+}
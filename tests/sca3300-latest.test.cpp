@@ -0,0 +1,107 @@
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <catch.hpp>
+
+#include <sca3300-latest.h>
+#include <sca3300-stream.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * Latest sample publication (seqlock)
+ *
+ */
+TEST_CASE( "Latest Sample Publication" )
+{
+    sca3300Latest<sca3300Sample> latest;
+    sca3300Sample sample;
+
+    SECTION( "Nothing published" )
+    {
+        REQUIRE( latest.Read( sample ) == false );
+    }
+
+    SECTION( "Writer interrupted while publishing" )
+    {
+        REQUIRE( latest.TryRead( sample, 10 ) == false );
+        REQUIRE( latest.IsPublished() == false );
+
+        sample.st_Sequence = 7;
+        latest.Publish( sample );
+        REQUIRE( latest.IsPublished() == true );
+
+        sca3300Sample read;
+        REQUIRE( latest.TryRead( read, 1 ) == true );
+        REQUIRE( read.st_Sequence == 7 );
+
+        // Odd sequence left by a writer that died in Publish() (sequence is the first member)
+        std::atomic<uint32_t> *sequence = reinterpret_cast<std::atomic<uint32_t> *>( &latest );
+        sequence->fetch_add( 1 );
+
+        REQUIRE( latest.TryRead( read, 1000 ) == false );
+        REQUIRE( latest.IsPublished() == true );
+
+        sequence->fetch_add( 1 );
+        REQUIRE( latest.TryRead( read, 1 ) == true );
+    }
+
+    SECTION( "Single thread" )
+    {
+        sample.st_Sequence = 42;
+        sample.st_Status   = 0x0102;
+        latest.Publish( sample );
+
+        sca3300Sample read;
+        REQUIRE( latest.Read( read ) == true );
+        REQUIRE( read.st_Sequence == 42 );
+        REQUIRE( read.st_Status == 0x0102 );
+    }
+
+    SECTION( "Consistent snapshots with concurrent readers" )
+    {
+        const uint32_t COUNT = 200000;
+        std::atomic<bool> done( false );
+        std::atomic<uint32_t> torn( 0 );
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r)
+            readers.emplace_back( [&]() {
+                sca3300Sample snapshot;
+                while ( !done )
+                {
+                    if ( !latest.Read( snapshot ) )
+                        continue;
+
+                    const float n = (float)snapshot.st_Sequence;
+                    if ( snapshot.st_Accel[0] != n || snapshot.st_Accel[1] != 2 * n ||
+                         snapshot.st_Accel[2] != 3 * n || snapshot.st_Temp != 4 * n ||
+                         snapshot.st_Timestamp != (int64_t)snapshot.st_Sequence * 1000 )
+                        ++torn;
+                }
+            });
+
+        for (uint32_t i = 1; i <= COUNT; ++i)
+        {
+            sample.st_Sequence  = i;
+            sample.st_Timestamp = (int64_t)i * 1000;
+            sample.st_Accel[0]  = (float)i;
+            sample.st_Accel[1]  = 2 * (float)i;
+            sample.st_Accel[2]  = 3 * (float)i;
+            sample.st_Temp      = 4 * (float)i;
+            latest.Publish( sample );
+        }
+
+        done = true;
+        for (auto &reader : readers)
+            reader.join();
+
+        REQUIRE( torn == 0 );
+        REQUIRE( latest.Read( sample ) == true );
+        REQUIRE( sample.st_Sequence == COUNT );
+    }
+}
@@ -0,0 +1,226 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <catch.hpp>
+
+#include <sca3300-record.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Temporary recording file, removed at the end of the test
+ */
+struct TempRecording
+{
+    std::string path;
+
+    TempRecording()
+    {
+        char tmpl[] = "/tmp/sca3300-record-XXXXXX";
+        const int fd = mkstemp( tmpl );
+        close( fd );
+        path = tmpl;
+    }
+
+    ~TempRecording()
+    {
+        unlink( path.c_str() );
+    }
+
+    off_t Size( void ) const
+    {
+        struct stat st;
+        stat( path.c_str(), &st );
+        return st.st_size;
+    }
+};
+
+/**
+ * @brief      Raw samples at 2 kHz, sequence from 0
+ */
+static vector<sca3300RawSample> MakeSamples( const size_t aCount )
+{
+    vector<sca3300RawSample> samples( aCount );
+
+    for (size_t n = 0; n < aCount; ++n)
+    {
+        samples[n].st_Timestamp = 1000000000LL + n * 500000;
+        samples[n].st_Sequence  = n;
+        samples[n].st_Accel[0]  = (int16_t)( n * 7 );
+        samples[n].st_Accel[1]  = -(int16_t)n;
+        samples[n].st_Accel[2]  = 5400;
+        samples[n].st_Temp      = 0x15C5;
+        samples[n].st_Status    = ( n % 100 == 0 ) ? 0x0002 : 0;
+        samples[n].st_Mode      = OPMODE3;
+        samples[n].st_IsValid   = ( n % 50 != 3 );
+    }
+
+    return samples;
+}
+
+/**
+ *
+ * Binary recording
+ *
+ */
+TEST_CASE( "Binary Recording" )
+{
+    TempRecording file;
+
+    sca3300RecordInfo info;
+    info.st_DeviceId    = 0xABCD1234;
+    info.st_Mode        = OPMODE3;
+    info.st_Sensitivity = 5400;
+    info.st_Odr         = 2000.0f;
+    info.st_StartTime   = 1571300000000000000LL;
+
+    sca3300RecordWriter writer;
+    sca3300RecordReader reader;
+
+    SECTION( "CRC-32" )
+    {
+        const char *check = "123456789";
+        REQUIRE( RecordCRC( (const uint8_t *)check, 9 ) == 0xCBF43926 );
+        REQUIRE( RecordCRC( (const uint8_t *)check + 4, 5, RecordCRC( (const uint8_t *)check, 4 ) ) == 0xCBF43926 );
+    }
+
+    SECTION( "Invalid" )
+    {
+        REQUIRE( writer.Open( file.path, info, 0 ) == false );
+        REQUIRE( writer.Append( nullptr, 0 ) == false );
+        REQUIRE( writer.Close() == false );
+        REQUIRE( reader.Open( file.path ) == false );
+        REQUIRE( reader.Open( "/nonexistent/record" ) == false );
+    }
+
+    SECTION( "Round trip" )
+    {
+        const vector<sca3300RawSample> samples = MakeSamples( 1000 );
+
+        // 100 samples per chunk, 2 chunks ahead: the file grows 4 times
+        REQUIRE( writer.Open( file.path, info, 100, 2 ) == true );
+        for (size_t done = 0; done < samples.size(); done += 37)
+            REQUIRE( writer.Append( &samples[done], std::min( (size_t)37, samples.size() - done ) ) == true );
+        REQUIRE( writer.GetSampleCount() == 1000 );
+        REQUIRE( writer.Close() == true );
+
+        REQUIRE( file.Size() == (off_t)( 64 + 10 * ( 32 + 100 * 16 + 16 ) ) );
+
+        REQUIRE( reader.Open( file.path ) == true );
+        REQUIRE( reader.GetInfo().st_DeviceId == 0xABCD1234 );
+        REQUIRE( reader.GetInfo().st_Mode == OPMODE3 );
+        REQUIRE( reader.GetInfo().st_Sensitivity == 5400 );
+        REQUIRE( reader.GetInfo().st_Odr == 2000.0f );
+        REQUIRE( reader.GetInfo().st_StartTime == info.st_StartTime );
+        REQUIRE( reader.GetChunkCount() == 10 );
+
+        vector<sca3300RawSample> chunk( reader.GetChunkSamples() );
+        size_t n = 0;
+
+        for (uint32_t c = 0; c < reader.GetChunkCount(); ++c)
+        {
+            const size_t count = reader.ReadChunk( c, chunk.data() );
+            REQUIRE( count == 100 );
+
+            for (size_t i = 0; i < count; ++i, ++n)
+            {
+                REQUIRE( chunk[i].st_Timestamp == samples[n].st_Timestamp );
+                REQUIRE( chunk[i].st_Sequence == samples[n].st_Sequence );
+                REQUIRE( chunk[i].st_Accel[0] == samples[n].st_Accel[0] );
+                REQUIRE( chunk[i].st_Accel[1] == samples[n].st_Accel[1] );
+                REQUIRE( chunk[i].st_Accel[2] == samples[n].st_Accel[2] );
+                REQUIRE( chunk[i].st_Temp == samples[n].st_Temp );
+                REQUIRE( chunk[i].st_Status == samples[n].st_Status );
+                REQUIRE( chunk[i].st_Mode == samples[n].st_Mode );
+                REQUIRE( chunk[i].st_IsValid == samples[n].st_IsValid );
+            }
+        }
+
+        REQUIRE( n == samples.size() );
+        REQUIRE( reader.ReadChunk( 10, chunk.data() ) == 0 );
+    }
+
+    SECTION( "Sliding map" )
+    {
+        // One chunk mapped at a time, chunks not page aligned
+        const vector<sca3300RawSample> samples = MakeSamples( 2550 );
+
+        REQUIRE( writer.Open( file.path, info, 100, 1 ) == true );
+        REQUIRE( writer.Append( samples.data(), samples.size() ) == true );
+        REQUIRE( writer.Flush() == true );
+
+        // The chunks unmapped by the writer are in the file
+        REQUIRE( reader.Open( file.path ) == true );
+        REQUIRE( reader.GetInfo().st_DeviceId == 0xABCD1234 );
+        REQUIRE( reader.GetChunkCount() == 25 );
+
+        vector<sca3300RawSample> chunk( 100 );
+        for (uint32_t c = 0; c < 25; ++c)
+        {
+            REQUIRE( reader.ReadChunk( c, chunk.data() ) == 100 );
+            REQUIRE( chunk[0].st_Sequence == c * 100 );
+            REQUIRE( chunk[99].st_Accel[0] == samples[c * 100 + 99].st_Accel[0] );
+        }
+        reader.Close();
+
+        REQUIRE( writer.Close() == true );
+        REQUIRE( file.Size() == (off_t)( 64 + 26 * ( 32 + 100 * 16 + 16 ) ) );
+
+        REQUIRE( reader.Open( file.path ) == true );
+        REQUIRE( reader.GetChunkCount() == 26 );
+        REQUIRE( reader.ReadChunk( 25, chunk.data() ) == 50 );
+        REQUIRE( chunk[49].st_Timestamp == samples[2549].st_Timestamp );
+    }
+
+    SECTION( "Sequence gap and partial chunk" )
+    {
+        vector<sca3300RawSample> samples = MakeSamples( 130 );
+        for (size_t n = 60; n < samples.size(); ++n)
+            samples[n].st_Sequence += 5; // 5 samples dropped
+
+        REQUIRE( writer.Open( file.path, info, 100 ) == true );
+        REQUIRE( writer.Append( samples.data(), samples.size() ) == true );
+        REQUIRE( writer.Close() == true );
+
+        REQUIRE( reader.Open( file.path ) == true );
+        REQUIRE( reader.GetChunkCount() == 2 );
+
+        vector<sca3300RawSample> chunk( 100 );
+        REQUIRE( reader.ReadChunk( 0, chunk.data() ) == 60 );
+        REQUIRE( reader.ReadChunk( 1, chunk.data() ) == 70 );
+        REQUIRE( chunk[0].st_Sequence == 65 );
+        REQUIRE( chunk[69].st_Sequence == 134 );
+        REQUIRE( chunk[69].st_Timestamp == samples[129].st_Timestamp );
+    }
+
+    SECTION( "Interrupted recording" )
+    {
+        const vector<sca3300RawSample> samples = MakeSamples( 250 );
+
+        REQUIRE( writer.Open( file.path, info, 100 ) == true );
+        REQUIRE( writer.Append( samples.data(), samples.size() ) == true );
+        REQUIRE( writer.Flush() == true );
+
+        // Third chunk not sealed yet: two complete chunks
+        REQUIRE( reader.Open( file.path ) == true );
+        REQUIRE( reader.GetChunkCount() == 2 );
+        reader.Close();
+
+        REQUIRE( writer.Close() == true );
+
+        // Corrupted sample in the second chunk: the recording ends after the first
+        const int fd = open( file.path.c_str(), O_WRONLY );
+        const uint8_t garbage = 0x5A;
+        REQUIRE( pwrite( fd, &garbage, 1, 64 + ( 32 + 100 * 16 + 16 ) + 32 + 5 * 16 + 4 ) == 1 );
+        close( fd );
+
+        REQUIRE( reader.Open( file.path ) == true );
+        REQUIRE( reader.GetChunkCount() == 1 );
+    }
+}
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <unistd.h>
+
+#include <catch.hpp>
+
+#include <sca3300.h>
+#include <sca3300-replay.h>
+#include <sca3300-tools.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * Replay of a recording through the stream interface
+ *
+ */
+TEST_CASE( "Recording Replay" )
+{
+    char tmpl[] = "/tmp/sca3300-replay-XXXXXX";
+    close( mkstemp( tmpl ) );
+    const std::string path = tmpl;
+
+    // 400 samples at 2 kHz: 200 ms of recording
+    const size_t NB_SAMPLES = 400;
+    vector<sca3300RawSample> samples( NB_SAMPLES );
+
+    for (size_t n = 0; n < NB_SAMPLES; ++n)
+    {
+        samples[n].st_Timestamp = 5000000000LL + n * 500000;
+        samples[n].st_Sequence  = n;
+        samples[n].st_Accel[0]  = (int16_t)n;
+        samples[n].st_Accel[2]  = SENSITIVITY_MODE_1;
+        samples[n].st_Temp      = 0x15C5;
+        samples[n].st_Mode      = OPMODE1;
+        samples[n].st_IsValid   = true;
+    }
+
+    sca3300RecordInfo info;
+    info.st_Mode = OPMODE1;
+    info.st_Sensitivity = SENSITIVITY_MODE_1;
+    info.st_Odr = 2000.0f;
+
+    sca3300RecordWriter writer;
+    REQUIRE( writer.Open( path, info, 64 ) == true );
+    REQUIRE( writer.Append( samples.data(), NB_SAMPLES ) == true );
+    REQUIRE( writer.Close() == true );
+
+    sca3300Replay replay;
+
+    SECTION( "Nothing open" )
+    {
+        REQUIRE( replay.Play() == false );
+        REQUIRE( replay.SetSpeed( -1.0 ) == false );
+    }
+
+    SECTION( "As fast as possible" )
+    {
+        REQUIRE( replay.Open( path ) == true );
+        REQUIRE( replay.GetInfo().st_Odr == 2000.0f );
+        REQUIRE( replay.SetSpeed( 0.0 ) == true );
+
+        std::mutex lock;
+        vector<sca3300Sample> played;
+
+        const int64_t start = GetMonotonicNs();
+        REQUIRE( replay.Play( [&]( const sca3300Sample &aSample ) {
+            std::lock_guard<std::mutex> guard( lock );
+            played.push_back( aSample );
+        }) == true );
+
+        while ( replay.IsStreaming() )
+            usleep( 1000 );
+
+        // Far faster than the 200 ms recorded
+        REQUIRE( GetMonotonicNs() - start < 100000000LL );
+        REQUIRE( replay.GetReplayedCount() == NB_SAMPLES );
+
+        std::lock_guard<std::mutex> guard( lock );
+        REQUIRE( played.size() == NB_SAMPLES );
+
+        for (size_t n = 0; n < NB_SAMPLES; ++n)
+        {
+            REQUIRE( played[n].st_Sequence == n );
+            REQUIRE( played[n].st_Timestamp == samples[n].st_Timestamp );
+            REQUIRE( played[n].st_Accel[ACCEL_X] == ProcessAccel( n, SENSITIVITY_MODE_1 ) );
+            REQUIRE( played[n].st_Accel[ACCEL_Z] == 1.0f );
+        }
+
+        // Same samples in the ring
+        vector<sca3300RawSample> raw( NB_SAMPLES + 1 );
+        REQUIRE( replay.PopRawSamples( raw.data(), raw.size() ) == NB_SAMPLES );
+        REQUIRE( raw[NB_SAMPLES - 1].st_Accel[0] == (int16_t)( NB_SAMPLES - 1 ) );
+    }
+
+    SECTION( "Small ring" )
+    {
+        REQUIRE( replay.Open( path ) == true );
+        REQUIRE( replay.SetSpeed( 0.0 ) == true );
+        REQUIRE( replay.SetRingCapacity( 16 ) == true );
+        REQUIRE( replay.Play() == true );
+
+        // A slow consumer loses nothing
+        vector<sca3300RawSample> raw( 8 );
+        size_t received = 0;
+        bool ordered = true;
+
+        while ( received < NB_SAMPLES )
+        {
+            const size_t count = replay.PopRawSamples( raw.data(), raw.size() );
+
+            for (size_t i = 0; i < count; ++i)
+                ordered &= ( raw[i].st_Accel[0] == (int16_t)( received + i ) );
+
+            received += count;
+            usleep( 200 );
+        }
+
+        while ( replay.IsStreaming() )
+            usleep( 1000 );
+
+        REQUIRE( ordered );
+        REQUIRE( replay.GetOverruns() == 0 );
+        REQUIRE( replay.GetReplayedCount() == NB_SAMPLES );
+        REQUIRE( replay.PopRawSamples( raw.data(), raw.size() ) == 0 );
+
+        // Stop() while waiting for the ring
+        REQUIRE( replay.Open( path ) == true );
+        REQUIRE( replay.Play() == true );
+        usleep( 10000 );
+        replay.Stop();
+        REQUIRE( replay.GetReplayedCount() == 16 );
+    }
+
+    SECTION( "Time scaling" )
+    {
+        REQUIRE( replay.Open( path ) == true );
+        REQUIRE( replay.SetSpeed( 4.0 ) == true );
+
+        const int64_t start = GetMonotonicNs();
+        REQUIRE( replay.Play() == true );
+        REQUIRE( replay.SetSpeed( 1.0 ) == false );
+
+        while ( replay.IsStreaming() )
+            usleep( 1000 );
+
+        // 199.5 ms recorded at 4x
+        REQUIRE( GetMonotonicNs() - start >= 49875000LL );
+        REQUIRE( replay.GetReplayedCount() == NB_SAMPLES );
+    }
+
+    SECTION( "Stop during a gap" )
+    {
+        // 10 samples, then the recording resumes an hour later
+        vector<sca3300RawSample> gap( samples.begin(), samples.begin() + 20 );
+        for (size_t n = 10; n < gap.size(); ++n)
+            gap[n].st_Timestamp += 3600000000000LL;
+
+        REQUIRE( writer.Open( path, info, 64 ) == true );
+        REQUIRE( writer.Append( gap.data(), gap.size() ) == true );
+        REQUIRE( writer.Close() == true );
+
+        REQUIRE( replay.Open( path ) == true );
+        REQUIRE( replay.Play() == true );
+        usleep( 50000 );
+
+        const int64_t start = GetMonotonicNs();
+        replay.Stop();
+
+        REQUIRE( GetMonotonicNs() - start < 100000000LL );
+        REQUIRE( replay.IsStreaming() == false );
+        REQUIRE( replay.GetReplayedCount() == 10 );
+
+        vector<sca3300RawSample> raw( 32 );
+        REQUIRE( replay.PopRawSamples( raw.data(), raw.size() ) == 10 );
+        REQUIRE( raw[9].st_Timestamp == gap[9].st_Timestamp );
+    }
+
+    SECTION( "Loop" )
+    {
+        REQUIRE( replay.Open( path ) == true );
+        REQUIRE( replay.SetSpeed( 0.0 ) == true );
+        REQUIRE( replay.SetLoop( true ) == true );
+        REQUIRE( replay.Play() == true );
+
+        // Not paced: the replay waits for the ring to be emptied
+        vector<sca3300RawSample> raw( 256 );
+        while ( replay.GetReplayedCount() < 3 * NB_SAMPLES )
+        {
+            replay.PopRawSamples( raw.data(), raw.size() );
+            usleep( 1000 );
+        }
+
+        REQUIRE( replay.IsStreaming() == true );
+        replay.Stop();
+
+        sca3300RawSample latest;
+        REQUIRE( replay.GetLatestRaw( latest ) == true );
+        REQUIRE( latest.st_Sequence >= 3 * NB_SAMPLES - 1 );
+
+        // Can be played again after Stop()
+        REQUIRE( replay.SetLoop( false ) == true );
+        REQUIRE( replay.Play() == true );
+        replay.Stop();
+    }
+
+    unlink( path.c_str() );
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <catch.hpp>
+
+#include <sca3300-ring.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * SPSC ring buffer
+ *
+ */
+TEST_CASE( "SPSC Ring Buffer" )
+{
+    SECTION( "Power of two capacity" )
+    {
+        REQUIRE( sca3300Ring<int>( 1 ).Capacity() == 1 );
+        REQUIRE( sca3300Ring<int>( 100 ).Capacity() == 128 );
+        REQUIRE( sca3300Ring<int>( 4096 ).Capacity() == 4096 );
+    }
+
+    SECTION( "Wrap around and overrun" )
+    {
+        sca3300Ring<int> ring( 8 );
+        int out[16];
+
+        for (int loop = 0; loop < 5; ++loop)
+        {
+            for (int i = 0; i < 10; ++i)
+                ring.Push( loop * 100 + i );
+
+            REQUIRE( ring.Size() == 8 );
+            REQUIRE( ring.GetOverruns() == (uint64_t)( loop + 1 ) * 2 );
+
+            // Bulk pop in two steps, oldest first
+            REQUIRE( ring.Pop( out, 3 ) == 3 );
+            REQUIRE( ring.Pop( out + 3, 16 ) == 5 );
+            REQUIRE( ring.Pop( out, 16 ) == 0 );
+
+            for (int i = 0; i < 8; ++i)
+                REQUIRE( out[i] == loop * 100 + i );
+        }
+    }
+
+    SECTION( "Producer and consumer threads" )
+    {
+        const uint32_t COUNT = 1000000;
+
+        sca3300Ring<uint32_t> ring( 1024 );
+        std::vector<uint32_t> received;
+        received.reserve( COUNT );
+
+        std::thread producer( [&]() {
+            for (uint32_t i = 0; i < COUNT; )
+                if ( ring.Push( i ) )
+                    ++i;
+        });
+
+        uint32_t block[64];
+        while ( received.size() < COUNT )
+        {
+            const size_t n = ring.Pop( block, 64 );
+            received.insert( received.end(), block, block + n );
+        }
+
+        producer.join();
+
+        bool ordered = true;
+        for (uint32_t i = 0; i < COUNT; ++i)
+            ordered &= ( received[i] == i );
+
+        REQUIRE( ordered == true );
+        REQUIRE( ring.Size() == 0 );
+    }
+}
@@ -0,0 +1,379 @@
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <catch.hpp>
+
+#include <sca3300.h>
+#include <sca3300-shm.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Bus name unique to the test process
+ */
+static std::string BusName( const char *aSuffix )
+{
+    return "/sca3300-test-" + std::to_string( getpid() ) + "-" + aSuffix;
+}
+
+/**
+ * @brief      Sample whose every field derives from its sequence
+ */
+static sca3300RawSample MakeSample( const uint32_t aSequence )
+{
+    sca3300RawSample sample;
+
+    sample.st_Timestamp = 1000000 * (int64_t)aSequence;
+    sample.st_Sequence  = aSequence;
+    sample.st_Accel[0]  = (int16_t)aSequence;
+    sample.st_Accel[1]  = (int16_t)~aSequence;
+    sample.st_Accel[2]  = (int16_t)( aSequence * 3 );
+    sample.st_Temp      = (uint16_t)( aSequence >> 16 );
+    sample.st_Status    = 0x5A5A;
+    sample.st_Mode      = OPMODE3;
+    sample.st_IsValid   = true;
+
+    return sample;
+}
+
+static bool IsSample( const sca3300RawSample &aSample, const uint32_t aSequence )
+{
+    const sca3300RawSample expected = MakeSample( aSequence );
+
+    return aSample.st_Timestamp == expected.st_Timestamp && aSample.st_Sequence == expected.st_Sequence &&
+           aSample.st_Accel[0] == expected.st_Accel[0] && aSample.st_Accel[1] == expected.st_Accel[1] &&
+           aSample.st_Accel[2] == expected.st_Accel[2] && aSample.st_Temp == expected.st_Temp &&
+           aSample.st_Status == expected.st_Status && aSample.st_Mode == expected.st_Mode && aSample.st_IsValid;
+}
+
+/**
+ *
+ * Shared memory sample bus
+ *
+ */
+TEST_CASE( "Shared Memory Bus" )
+{
+    const std::string name = BusName( "bus" );
+
+    sca3300RecordInfo info;
+    info.st_DeviceId    = 0x12345678;
+    info.st_Mode        = OPMODE3;
+    info.st_Sensitivity = 12000;
+    info.st_Odr         = 2000.0f;
+
+    SECTION( "Invalid buses" )
+    {
+        sca3300ShmPublisher publisher;
+        sca3300ShmReader reader;
+
+        REQUIRE( publisher.Open( "", info ) == false );
+        REQUIRE( publisher.Open( "no-slash", info ) == false );
+        REQUIRE( publisher.Open( "/two/parts", info ) == false );
+        REQUIRE( publisher.Open( name, info, 0 ) == false );
+        REQUIRE( publisher.Publish( MakeSample( 0 ) ) == false );
+        REQUIRE( publisher.Close() == false );
+
+        REQUIRE( reader.Open( name ) == false );
+        REQUIRE( reader.IsOpen() == false );
+        REQUIRE( reader.IsPublisherAlive() == false );
+
+        sca3300RawSample raw;
+        REQUIRE( reader.ReadRawSamples( &raw, 1 ) == 0 );
+        REQUIRE( reader.GetLatestRaw( raw ) == false );
+    }
+
+    SECTION( "Publish and read" )
+    {
+        sca3300ShmPublisher publisher;
+        REQUIRE( publisher.Open( name, info, 100 ) == true );
+
+        // Samples published before a reader opens are not for it
+        REQUIRE( publisher.Publish( MakeSample( 0 ) ) == true );
+
+        sca3300ShmReader reader, other;
+        REQUIRE( reader.Open( name ) == true );
+        REQUIRE( other.Open( name ) == true );
+
+        REQUIRE( reader.IsPublisherAlive() == true );
+        REQUIRE( reader.GetCapacity() == 128 );
+        REQUIRE( reader.GetInfo().st_DeviceId == 0x12345678 );
+        REQUIRE( reader.GetInfo().st_Mode == OPMODE3 );
+        REQUIRE( reader.GetInfo().st_Sensitivity == 12000 );
+        REQUIRE( reader.GetInfo().st_Odr == 2000.0f );
+        REQUIRE( reader.Available() == 0 );
+
+        for (uint32_t i = 1; i <= 50; ++i)
+            REQUIRE( publisher.Publish( MakeSample( i ) ) == true );
+
+        REQUIRE( publisher.GetPublishedCount() == 51 );
+        REQUIRE( reader.Available() == 50 );
+
+        sca3300RawSample raw[64];
+        REQUIRE( reader.ReadRawSamples( raw, 20 ) == 20 );
+        REQUIRE( reader.ReadRawSamples( raw + 20, 64 ) == 30 );
+        REQUIRE( reader.ReadRawSamples( raw, 64 ) == 0 );
+        REQUIRE( reader.GetLost() == 0 );
+
+        for (uint32_t i = 0; i < 50; ++i)
+            REQUIRE( IsSample( raw[i], i + 1 ) );
+
+        // Every reader has its own cursor
+        sca3300Sample samples[64];
+        REQUIRE( other.ReadSamples( samples, 64 ) == 50 );
+
+        for (uint32_t i = 0; i < 50; ++i)
+        {
+            sca3300Sample converted;
+            ConvertSample( MakeSample( i + 1 ), converted );
+
+            REQUIRE( samples[i].st_Sequence == i + 1 );
+            REQUIRE( samples[i].st_Accel[ACCEL_X] == converted.st_Accel[ACCEL_X] );
+            REQUIRE( samples[i].st_Temp == converted.st_Temp );
+        }
+
+        sca3300RawSample latest;
+        REQUIRE( reader.GetLatestRaw( latest ) == true );
+        REQUIRE( IsSample( latest, 50 ) );
+
+        // Segment name removed, mappings still valid
+        REQUIRE( publisher.Close() == true );
+        REQUIRE( reader.IsPublisherAlive() == false );
+        REQUIRE( reader.GetLatestRaw( latest ) == true );
+
+        sca3300ShmReader late;
+        REQUIRE( late.Open( name ) == false );
+    }
+
+    SECTION( "Late reader" )
+    {
+        sca3300ShmPublisher publisher;
+        REQUIRE( publisher.Open( name, info, 8 ) == true );
+
+        sca3300ShmReader reader;
+        REQUIRE( reader.Open( name ) == true );
+        REQUIRE( reader.GetCapacity() == 8 );
+
+        for (uint32_t i = 0; i < 20; ++i)
+            publisher.Publish( MakeSample( i ) );
+
+        REQUIRE( reader.Available() == 7 );
+
+        // The slot the publisher rewrites next is skipped as well
+        sca3300RawSample raw[16];
+        REQUIRE( reader.ReadRawSamples( raw, 16 ) == 7 );
+        REQUIRE( reader.GetLost() == 13 );
+
+        for (uint32_t i = 0; i < 7; ++i)
+            REQUIRE( IsSample( raw[i], 13 + i ) );
+
+        publisher.Publish( MakeSample( 20 ) );
+
+        REQUIRE( reader.ReadRawSamples( raw, 16 ) == 1 );
+        REQUIRE( IsSample( raw[0], 20 ) );
+        REQUIRE( reader.GetLost() == 13 );
+    }
+
+    SECTION( "Publisher restart" )
+    {
+        sca3300ShmPublisher first, second;
+        REQUIRE( first.Open( name, info, 16 ) == true );
+
+        // The bus of a running publisher is not taken over
+        REQUIRE( second.Open( name, info, 16 ) == false );
+
+        sca3300ShmReader reader;
+        REQUIRE( reader.Open( name ) == true );
+        REQUIRE( first.Publish( MakeSample( 1 ) ) == true );
+
+        sca3300RawSample raw;
+        REQUIRE( reader.ReadRawSamples( &raw, 1 ) == 1 );
+        REQUIRE( first.Close() == true );
+
+        // A publisher killed without Close() leaves a live segment behind
+        const pid_t child = fork();
+
+        if ( 0 == child )
+        {
+            sca3300ShmPublisher crashed;
+            _exit( crashed.Open( name, info, 16 ) ? 0 : 1 );
+        }
+
+        int status = 0;
+        REQUIRE( child > 0 );
+        REQUIRE( waitpid( child, &status, 0 ) == child );
+        REQUIRE( WIFEXITED( status ) );
+        REQUIRE( WEXITSTATUS( status ) == 0 );
+
+        REQUIRE( reader.Open( name ) == true );
+        REQUIRE( reader.IsPublisherAlive() == false );
+        REQUIRE( reader.GetLatestRaw( raw ) == false );
+
+        // It is replaced, the old readers must reopen
+        REQUIRE( second.Open( name, info, 16 ) == true );
+        second.Publish( MakeSample( 2 ) );
+
+        REQUIRE( reader.ReadRawSamples( &raw, 1 ) == 0 );
+
+        REQUIRE( reader.Open( name ) == true );
+        REQUIRE( reader.IsPublisherAlive() == true );
+        second.Publish( MakeSample( 3 ) );
+        REQUIRE( reader.ReadRawSamples( &raw, 1 ) == 1 );
+        REQUIRE( IsSample( raw, 3 ) );
+
+        sca3300ShmReader another;
+        REQUIRE( another.Open( name ) == true );
+    }
+
+    SECTION( "Concurrent reader" )
+    {
+        // Small ring: the reader is lapped and must never see a torn sample
+        sca3300ShmPublisher publisher;
+        REQUIRE( publisher.Open( name, info, 16 ) == true );
+
+        sca3300ShmReader reader;
+        REQUIRE( reader.Open( name ) == true );
+
+        const uint32_t total = 200000;
+        std::atomic<bool> done( false );
+
+        std::thread writer( [&]()
+        {
+            for (uint32_t i = 0; i < total; ++i)
+                publisher.Publish( MakeSample( i ) );
+
+            done = true;
+        } );
+
+        sca3300RawSample raw[8];
+        uint64_t received = 0;
+        int64_t previous  = -1;
+        bool consistent   = true;
+
+        for (;;)
+        {
+            const bool last = done;
+            const size_t count = reader.ReadRawSamples( raw, 8 );
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                consistent &= IsSample( raw[i], raw[i].st_Sequence ) && (int64_t)raw[i].st_Sequence > previous;
+                previous = raw[i].st_Sequence;
+            }
+
+            received += count;
+
+            if ( last && 0 == count )
+                break;
+        }
+
+        writer.join();
+
+        REQUIRE( consistent );
+        REQUIRE( previous == total - 1 );
+        REQUIRE( received + reader.GetLost() == total );
+    }
+
+    SECTION( "Reader process" )
+    {
+        sca3300ShmPublisher publisher;
+        REQUIRE( publisher.Open( name, info, 4096 ) == true );
+
+        const uint32_t total = 2000;
+        const pid_t child = fork();
+
+        if ( 0 == child )
+        {
+            // Reader process: every sample in order, nothing lost
+            sca3300ShmReader reader;
+
+            while ( !reader.Open( name ) )
+                usleep( 1000 );
+
+            if ( reader.GetInfo().st_DeviceId != 0x12345678 )
+                _exit( 2 );
+
+            uint32_t expected = 0;
+            sca3300RawSample raw[64];
+
+            while ( expected < total )
+            {
+                const size_t count = reader.ReadRawSamples( raw, 64 );
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if ( !IsSample( raw[i], expected++ ) )
+                        _exit( 3 );
+                }
+
+                if ( 0 == count )
+                    usleep( 100 );
+            }
+
+            _exit( 0 == reader.GetLost() ? 0 : 4 );
+        }
+
+        REQUIRE( child > 0 );
+
+        // Let the reader map the segment before the first sample
+        usleep( 100000 );
+
+        for (uint32_t i = 0; i < total; ++i)
+        {
+            publisher.Publish( MakeSample( i ) );
+            if ( 0 == ( i % 100 ) )
+                usleep( 1000 );
+        }
+
+        int status = 0;
+        REQUIRE( waitpid( child, &status, 0 ) == child );
+        REQUIRE( WIFEXITED( status ) );
+        REQUIRE( WEXITSTATUS( status ) == 0 );
+    }
+}
+
+
+TEST_CASE( "Shared Memory Acquisition" )
+{
+    const std::string name = BusName( "acquisition" );
+
+    sca3300SimTransport *sim = new sca3300SimTransport();
+    sca3300 chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+    sim->SetRegister( REG_ACC_X, (uint16_t)-1000 );
+
+    sca3300ShmPublisher publisher;
+    REQUIRE( publisher.Open( name, sca3300RecordInfo() ) == true );
+
+    sca3300ShmReader reader;
+    REQUIRE( reader.Open( name ) == true );
+
+    REQUIRE( chip.SetRawCallback( [&publisher]( const sca3300RawSample &aSample ){ publisher.Publish( aSample ); } ) == true );
+    REQUIRE( chip.Start( 1000 ) == true );
+    REQUIRE( chip.SetRawCallback( nullptr ) == false );
+
+    usleep( 20000 );
+    chip.Stop();
+
+    std::vector<sca3300RawSample> raw( reader.GetCapacity() );
+    const size_t count = reader.ReadRawSamples( raw.data(), raw.size() );
+
+    REQUIRE( count > 0 );
+    REQUIRE( count == publisher.GetPublishedCount() );
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        REQUIRE( raw[i].st_Sequence == (uint32_t)i );
+        REQUIRE( raw[i].st_Accel[ACCEL_X] == -1000 );
+    }
+
+    sca3300RawSample latest;
+    REQUIRE( chip.GetLatestRaw( latest ) == true );
+    REQUIRE( latest.st_Sequence == raw[count - 1].st_Sequence );
+}
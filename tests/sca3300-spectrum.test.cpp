@@ -0,0 +1,159 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>     /* srand, rand */
+
+#include <catch.hpp>
+
+#include <sca3300-spectrum.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * Real FFT
+ *
+ */
+TEST_CASE( "Real FFT" )
+{
+    sca3300Fft fft;
+
+    SECTION( "Invalid sizes" )
+    {
+        REQUIRE( fft.Init( 4 ) == false );
+        REQUIRE( fft.Init( 100 ) == false );
+        REQUIRE( fft.Init( 64 ) == true );
+        REQUIRE( fft.GetSize() == 64 );
+    }
+
+    for (size_t size : { 8, 64, 512 })
+    {
+        SECTION( "Against a direct DFT, " + std::to_string( size ) + " points" )
+        {
+            REQUIRE( fft.Init( size ) == true );
+
+            srand( size );
+            vector<float> frames( size * 4 );
+            for (float &value : frames)
+                value = ( rand() % 2001 - 1000 ) / 1000.0f;
+
+            vector<float> re( ( size / 2 + 1 ) * 4 ), im( ( size / 2 + 1 ) * 4 );
+            fft.Forward( frames.data(), re.data(), im.data() );
+
+            for (int lane = 0; lane < 4; ++lane)
+                for (size_t k = 0; k <= size / 2; ++k)
+                {
+                    double dftRe = 0.0, dftIm = 0.0;
+                    for (size_t n = 0; n < size; ++n)
+                    {
+                        dftRe += frames[n * 4 + lane] * cos( 2 * M_PI * k * n / size );
+                        dftIm -= frames[n * 4 + lane] * sin( 2 * M_PI * k * n / size );
+                    }
+
+                    REQUIRE( re[k * 4 + lane] == Approx( dftRe ).margin( 1e-3 ) );
+                    REQUIRE( im[k * 4 + lane] == Approx( dftIm ).margin( 1e-3 ) );
+                }
+        }
+    }
+}
+
+/**
+ *
+ * Welch power spectral density
+ *
+ */
+TEST_CASE( "Welch Spectrum" )
+{
+    const float RATE = 2000.0f;
+    const size_t SEGMENT = 256;
+
+    sca3300Spectrum spectrum;
+    sca3300Psd psd;
+    bool ready = false;
+
+    SECTION( "Invalid settings" )
+    {
+        REQUIRE( spectrum.Configure( RATE, 100, 50, 4 ) == false );
+        REQUIRE( spectrum.Configure( RATE, SEGMENT, SEGMENT, 4 ) == false );
+        REQUIRE( spectrum.Configure( RATE, SEGMENT, 128, 0 ) == false );
+        REQUIRE( spectrum.Configure( 0.0f, SEGMENT, 128, 4 ) == false );
+
+        vector<float> frames( 16 );
+        REQUIRE( spectrum.Add( frames.data(), 4, ready ) == 0 );
+        REQUIRE( ready == false );
+        REQUIRE( spectrum.GetPsd( psd ) == false );
+    }
+
+    SECTION( "Tone and noise" )
+    {
+        // 4 segments with 50 % overlap: 256 + 3 * 128 samples per PSD
+        REQUIRE( spectrum.Configure( RATE, SEGMENT, SEGMENT / 2, 4 ) == true );
+
+        const size_t PERIOD = SEGMENT + 3 * SEGMENT / 2;
+        const double TONE = 250.0; // bin 32
+        const double AMPLITUDE = 0.1;
+
+        srand( 20 );
+        vector<sca3300Sample> samples( 3 * PERIOD );
+        double noisePower = 0.0;
+
+        for (size_t n = 0; n < samples.size(); ++n)
+        {
+            const float noise = ( rand() % 2001 - 1000 ) / 100000.0f;
+
+            samples[n].st_Accel[0] = AMPLITUDE * sin( 2 * M_PI * TONE * n / RATE );
+            samples[n].st_Accel[1] = noise;
+            samples[n].st_Accel[2] = 1.0f; // gravity, removed by the detrend
+            noisePower += noise * noise;
+        }
+        noisePower /= samples.size();
+
+        // Arbitrary block boundaries, stop at every PSD
+        size_t done = 0, nbPsd = 0;
+        while ( done < samples.size() )
+        {
+            const size_t block = std::min( (size_t)( 1 + rand() % 300 ), samples.size() - done );
+            done += spectrum.Add( &samples[done], block, ready );
+
+            if ( ready )
+            {
+                nbPsd++;
+                REQUIRE( spectrum.GetPsd( psd ) == true );
+                REQUIRE( psd.st_LastSample == PERIOD );
+                break;
+            }
+        }
+
+        REQUIRE( nbPsd == 1 );
+        REQUIRE( psd.st_Segments == 4 );
+        REQUIRE( psd.st_Resolution == Approx( RATE / SEGMENT ) );
+        REQUIRE( psd.st_Accel[0].size() == SEGMENT / 2 + 1 );
+
+        // Tone: peak at its bin, integrated power A² / 2
+        const size_t peak = std::max_element( psd.st_Accel[0].begin(), psd.st_Accel[0].end() ) - psd.st_Accel[0].begin();
+        REQUIRE( peak == 32 );
+
+        double tonePower = 0.0, whitePower = 0.0, dcPower = 0.0;
+        for (size_t k = 0; k <= SEGMENT / 2; ++k)
+        {
+            tonePower  += psd.st_Accel[0][k] * psd.st_Resolution;
+            whitePower += psd.st_Accel[1][k] * psd.st_Resolution;
+            dcPower    += psd.st_Accel[2][k] * psd.st_Resolution;
+        }
+
+        REQUIRE( tonePower == Approx( AMPLITUDE * AMPLITUDE / 2 ).epsilon( 0.02 ) );
+        REQUIRE( whitePower == Approx( noisePower ).epsilon( 0.15 ) );
+        REQUIRE( dcPower < 1e-9 );
+
+        // Next periods are complete every 4 hops (512 samples)
+        size_t next = 0;
+        while ( done < samples.size() )
+        {
+            done += spectrum.Add( &samples[done], samples.size() - done, ready );
+            if ( ready )
+                next++;
+        }
+        REQUIRE( next == 2 );
+    }
+}
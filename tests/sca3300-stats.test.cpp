@@ -0,0 +1,168 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <cmath>
+
+#include <catch.hpp>
+
+#include <sca3300.h>
+#include <sca3300-stats.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Sample with every channel set to aValue
+ */
+static sca3300Sample MakeSample( const float aValue, const int64_t aTimestamp, const bool aIsValid = true )
+{
+    sca3300Sample sample;
+
+    sample.st_Timestamp = aTimestamp;
+    sample.st_Accel[ACCEL_X] = aValue;
+    sample.st_Accel[ACCEL_Y] = -aValue;
+    sample.st_Accel[ACCEL_Z] = 1.0f;
+    sample.st_Temp = aValue + 20.0f;
+    sample.st_IsValid = aIsValid;
+
+    return sample;
+}
+
+/**
+ *
+ * Streaming statistics
+ *
+ */
+TEST_CASE( "Streaming Statistics" )
+{
+    SECTION( "Cumulative" )
+    {
+        sca3300Stats stats;
+
+        for (int i = 1; i <= 4; ++i)
+            REQUIRE( stats.Add( MakeSample( (float)i, i ) ) == false );
+        stats.Add( MakeSample( 100.0f, 5, false ) );
+
+        const sca3300SampleStats total = stats.GetTotal();
+        const sca3300ChannelStats &x = total.st_Accel[ACCEL_X];
+
+        REQUIRE( x.st_Count == 4 );
+        REQUIRE( x.st_Mean == Approx( 2.5 ) );
+        REQUIRE( x.st_Variance == Approx( 1.25 ) );
+        REQUIRE( x.st_Min == 1.0 );
+        REQUIRE( x.st_Max == 4.0 );
+        REQUIRE( x.st_Rms == Approx( sqrt( 30.0 / 4 ) ) );
+
+        REQUIRE( total.st_Accel[ACCEL_Y].st_Mean == Approx( -2.5 ) );
+        REQUIRE( total.st_Accel[ACCEL_Z].st_Variance == 0.0 );
+        REQUIRE( total.st_Temp.st_Mean == Approx( 22.5 ) );
+        REQUIRE( total.st_Invalid == 1 );
+        REQUIRE( total.st_FirstTimestamp == 1 );
+        REQUIRE( total.st_LastTimestamp == 4 );
+
+        sca3300SampleStats window;
+        REQUIRE( stats.GetWindow( window ) == false );
+
+        stats.Reset();
+        REQUIRE( stats.GetTotal().st_Accel[ACCEL_X].st_Count == 0 );
+    }
+
+    SECTION( "Tumbling windows" )
+    {
+        sca3300Stats stats( 3 );
+        sca3300SampleStats window;
+
+        int nbWindows = 0;
+        for (int i = 0; i < 9; ++i)
+            if ( stats.Add( MakeSample( (float)i, i ) ) )
+            {
+                REQUIRE( stats.GetWindow( window ) == true );
+                REQUIRE( window.st_Accel[ACCEL_X].st_Count == 3 );
+                REQUIRE( window.st_Accel[ACCEL_X].st_Mean == Approx( i - 1 ) );
+                REQUIRE( window.st_FirstTimestamp == i - 2 );
+                ++nbWindows;
+            }
+
+        REQUIRE( nbWindows == 3 );
+    }
+
+    SECTION( "Sliding window against a direct computation" )
+    {
+        const size_t WINDOW = 400, PANES = 8;
+
+        sca3300Stats stats( WINDOW, PANES );
+        vector<double> values;
+
+        srand( 3 );
+        for (int i = 0; i < 2000; ++i)
+        {
+            const float value = 1.0f + (float)rand() / RAND_MAX;
+            values.push_back( value );
+
+            if ( !stats.Add( MakeSample( value, i ) ) )
+                continue;
+
+            // Window ends on a pane boundary and covers WINDOW samples
+            REQUIRE( values.size() >= WINDOW );
+            REQUIRE( values.size() % ( WINDOW / PANES ) == 0 );
+
+            double sum = 0.0, sumSq = 0.0, min = 10.0, max = 0.0;
+            for (size_t n = values.size() - WINDOW; n < values.size(); ++n)
+            {
+                sum += values[n];
+                min = std::min( min, values[n] );
+                max = std::max( max, values[n] );
+            }
+            const double mean = sum / WINDOW;
+            for (size_t n = values.size() - WINDOW; n < values.size(); ++n)
+                sumSq += ( values[n] - mean ) * ( values[n] - mean );
+
+            sca3300SampleStats window;
+            REQUIRE( stats.GetWindow( window ) == true );
+            REQUIRE( window.st_Accel[ACCEL_X].st_Count == WINDOW );
+            REQUIRE( window.st_Accel[ACCEL_X].st_Mean == Approx( mean ).epsilon( 1e-12 ) );
+            REQUIRE( window.st_Accel[ACCEL_X].st_Variance == Approx( sumSq / WINDOW ).epsilon( 1e-9 ) );
+            REQUIRE( window.st_Accel[ACCEL_X].st_Min == min );
+            REQUIRE( window.st_Accel[ACCEL_X].st_Max == max );
+        }
+    }
+
+    SECTION( "Window not divisible by the panes" )
+    {
+        REQUIRE( sca3300Stats( 2000, 4 ).IsValid() == true );
+        REQUIRE( sca3300Stats( 2000, 3 ).IsValid() == false );
+        REQUIRE( sca3300Stats( 2, 3 ).IsValid() == false );
+        REQUIRE( sca3300Stats().IsValid() == true );
+
+        REQUIRE( sca3300Stats( 2000, 4 ).GetWindowLength() == 2000 );
+        REQUIRE( sca3300Stats( 2000, 3 ).GetWindowLength() == 0 );
+        REQUIRE( sca3300Stats( 2, 3 ).GetWindowLength() == 0 );
+        REQUIRE( sca3300Stats().GetWindowLength() == 0 );
+
+        sca3300Stats stats( 2000, 3 );
+        sca3300Sample sample;
+        sample.st_IsValid = true;
+
+        for (int i = 0; i < 3000; ++i)
+            REQUIRE( stats.Add( sample ) == false );
+
+        sca3300SampleStats window;
+        REQUIRE( stats.GetWindow( window ) == false );
+        REQUIRE( stats.GetTotal().st_Accel[ACCEL_X].st_Count == 3000 );
+    }
+
+    SECTION( "Driver" )
+    {
+        sca3300SimTransport *sim = new sca3300SimTransport();
+        sca3300 chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+        sim->SetRegister( REG_ACC_X, 2700 );
+
+        sca3300SampleStats stats;
+        REQUIRE( chip.ReadAndProcessData( 10, stats ) == true );
+        REQUIRE( stats.st_Accel[ACCEL_X].st_Count == 10 );
+        REQUIRE( stats.st_Accel[ACCEL_X].st_Mean == Approx( 0.5 ) );
+        REQUIRE( stats.st_Accel[ACCEL_Z].st_Mean == Approx( 1.0 ) );
+        REQUIRE( stats.st_Temp.st_Mean == Approx( ConvertTemperature( 0x15C5 ) ) );
+    }
+}
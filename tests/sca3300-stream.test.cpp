@@ -0,0 +1,186 @@
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+#include <catch.hpp>
+
+#include <sca3300.h>
+#include <sca3300-tools.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ * @brief      Stream whose acquisitions take 2 ms, counts them
+ */
+class SlowStream : public sca3300Stream
+{
+    public:
+        SlowStream() : acquired( 0 ) {}
+        ~SlowStream() { this->Stop(); }
+
+        std::atomic<uint32_t> acquired;
+
+    protected:
+        bool AcquireSample( sca3300RawSample &aSample )
+        {
+            usleep( 2000 );
+            aSample.st_IsValid = true;
+            this->acquired++;
+            return true;
+        }
+};
+
+/**
+ *
+ * Continuous acquisition thread
+ *
+ */
+TEST_CASE( "Continuous Acquisition" )
+{
+    sca3300SimTransport *sim = new sca3300SimTransport();
+    sca3300 chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+    sim->SetRegister( REG_ACC_X, 1000 );
+
+    std::mutex lock;
+    std::vector<sca3300Sample> samples;
+
+    const uint32_t PERIOD_US = 1000;
+
+    REQUIRE( chip.Start( PERIOD_US, [&]( const sca3300Sample &aSample ) {
+        std::lock_guard<std::mutex> guard( lock );
+        samples.push_back( aSample );
+    }) == true );
+
+    REQUIRE( chip.IsStreaming() == true );
+    REQUIRE( chip.Start( PERIOD_US, nullptr ) == false );
+
+    usleep( 100000 );
+    chip.Stop();
+
+    REQUIRE( chip.IsStreaming() == false );
+
+    std::lock_guard<std::mutex> guard( lock );
+
+    // Absolute deadlines: no drift over the run
+    REQUIRE( samples.size() > 10 );
+    const int64_t span = samples.back().st_Timestamp - samples.front().st_Timestamp;
+    const uint64_t periods = samples.size() - 1 + chip.GetMissedDeadlines();
+    REQUIRE( span >= (int64_t)( periods - 1 ) * PERIOD_US * 1000 );
+
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        REQUIRE( samples[i].st_Sequence == i );
+        REQUIRE( samples[i].st_IsValid == true );
+        REQUIRE( samples[i].st_Accel[ACCEL_X] == ProcessAccel( 1000, SENSITIVITY_MODE_3_4 ) );
+    }
+}
+
+/**
+ *
+ * Samples handed over through the ring
+ *
+ */
+TEST_CASE( "Acquisition Ring" )
+{
+    sca3300SimTransport *sim = new sca3300SimTransport();
+    sca3300 chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+    REQUIRE( chip.SetRingCapacity( 16 ) == true );
+    REQUIRE( chip.Start( 1000 ) == true );
+    REQUIRE( chip.SetRingCapacity( 32 ) == false );
+
+    usleep( 50000 );
+
+    sca3300Sample latest;
+    REQUIRE( chip.GetLatest( latest ) == true );
+    REQUIRE( latest.st_Sequence >= 16 );
+
+    chip.Stop();
+
+    // Nobody consumed: ring is full, the remaining samples were dropped
+    sca3300Sample samples[32];
+    const size_t count = chip.PopSamples( samples, 32 );
+
+    REQUIRE( count == 16 );
+    REQUIRE( chip.GetOverruns() > 0 );
+
+    for (size_t i = 0; i < count; ++i)
+        REQUIRE( samples[i].st_Sequence == i );
+}
+
+/**
+ *
+ * Raw samples: conversion only on the consumer side
+ *
+ */
+TEST_CASE( "Raw Acquisition" )
+{
+    sca3300SimTransport *sim = new sca3300SimTransport();
+    sca3300 chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+    sim->SetRegister( REG_ACC_X, (uint16_t)-1000 );
+
+    REQUIRE( sizeof(sca3300RawSample) < sizeof(sca3300Sample) );
+    REQUIRE( chip.Start( 1000 ) == true );
+
+    usleep( 20000 );
+    chip.Stop();
+
+    sca3300RawSample latest;
+    REQUIRE( chip.GetLatestRaw( latest ) == true );
+
+    sca3300RawSample raw[4];
+    sca3300Sample samples[4];
+
+    REQUIRE( chip.PopRawSamples( raw, 2 ) == 2 );
+    REQUIRE( chip.PopSamples( samples, 2 ) == 2 );
+
+    const sca3300Scale scale = GetModeScale( (operationMode)raw[0].st_Mode );
+
+    for (int i = 0; i < 2; ++i)
+    {
+        REQUIRE( raw[i].st_Sequence == (uint32_t)i );
+        REQUIRE( raw[i].st_Accel[ACCEL_X] == -1000 );
+        REQUIRE( raw[i].st_Temp == 0x15C5 );
+        REQUIRE( AccelToMilliG( raw[i].st_Accel[ACCEL_X], scale ) == -185 );
+
+        REQUIRE( samples[i].st_Sequence == (uint32_t)i + 2 );
+        REQUIRE( samples[i].st_Accel[ACCEL_X] == ProcessAccel( -1000, scale.st_Sensitivity ) );
+        REQUIRE( samples[i].st_Temp == ConvertTemperature( 0x15C5 ) );
+    }
+}
+
+
+/**
+ *
+ * Stop() while a sample is being acquired
+ *
+ */
+TEST_CASE( "Last Sample On Stop" )
+{
+    SlowStream stream;
+    sca3300RawSample raw[256];
+
+    for (int run = 0; run < 5; ++run)
+    {
+        stream.acquired = 0;
+
+        REQUIRE( stream.Start( 0 ) == true );
+        usleep( 5000 + run * 700 );
+        stream.Stop();
+
+        // Every sample read is delivered, the one in progress included
+        const size_t count = stream.PopRawSamples( raw, 256 );
+        REQUIRE( count == stream.acquired );
+        REQUIRE( count > 0 );
+
+        sca3300RawSample latest;
+        REQUIRE( stream.GetLatestRaw( latest ) == true );
+        REQUIRE( latest.st_Sequence == count - 1 );
+    }
+}
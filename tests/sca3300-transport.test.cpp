@@ -0,0 +1,187 @@
+#include <iostream>
+#include <memory>
+#include <cstring>
+#include <unistd.h>
+
+#include <catch.hpp>
+
+#include <sca3300.h>
+#include <sca3300-tools.h>
+#include <sca3300-transport.h>
+
+using namespace std;
+using namespace sca3300d01;
+
+/**
+ *
+ * Frame CRC calculation
+ *
+ */
+TEST_CASE( "Frame CRC Calculation" )
+{
+    const uint32_t REQUESTS[] = { REQ_READ_ACC_X, REQ_READ_ACC_Y, REQ_READ_ACC_Z, REQ_READ_STO,
+                                  REQ_READ_TEMP, REQ_READ_STATUS, REQ_WRITE_SW_RESET, REQ_WRITE_MODE1,
+                                  REQ_WRITE_MODE2, REQ_WRITE_MODE3, REQ_WRITE_MODE4, REQ_READ_WHOAMI };
+
+    for (auto const req : REQUESTS)
+        REQUIRE( CalculateCRC( req ) == ( req & CRC_FIELD_MASK ) );
+
+    SECTION( "Compile time builder" )
+    {
+        const uint32_t BUILT[] = { REQ_READ_SERIAL1, REQ_READ_SERIAL2, REQ_READ_ERR_FLAG1, REQ_READ_ERR_FLAG2,
+                                   REQ_READ_MODE, REQ_READ_SELBANK, REQ_WRITE_SELBANK_0 };
+
+        for (auto const req : BUILT)
+        {
+            REQUIRE( CalculateCRC( req ) == ( req & CRC_FIELD_MASK ) );
+            REQUIRE( ( req & RS_FIELD_MASK ) == 0 );
+        }
+
+        for (uint32_t data = 0; data <= 0xFFFF; data += 0x0101)
+            REQUIRE( MakeRequest( true, REG_SELBANK, data ) == ( 0xFC000000 | ( data << 8 ) | CalculateCRC( data << 8 | 0xFC000000 ) ) );
+
+        REQUIRE( ( REQ_READ_SERIAL1 & ADDR_FIELD_MASK ) >> 26 == REG_SERIAL1 );
+    }
+}
+
+/**
+ *
+ * Driver against the simulated device
+ *
+ */
+TEST_CASE( "Simulated Device" )
+{
+    sca3300SimTransport *sim = new sca3300SimTransport();
+    sca3300 chip { std::unique_ptr<sca3300Transport>( sim ) };
+
+    sim->SetRegister( REG_ACC_X, 1000 );
+    sim->SetRegister( REG_ACC_Y, 2000 );
+    sim->SetRegister( REG_ACC_Z, 5400 );
+    sim->SetRegister( REG_STATUS, 0x0002 );
+
+    SECTION( "Chip Id" )
+    {
+        REQUIRE( chip.CheckChipId() == true );
+    }
+
+    SECTION( "Serial number" )
+    {
+        uint32_t serial = 0;
+
+        sim->SetRegister( REG_SERIAL1, 0x1234 );
+        sim->SetRegister( REG_SERIAL2, 0xABCD );
+
+        REQUIRE( chip.GetSerial( serial ) == true );
+        REQUIRE( serial == 0xABCD1234 );
+    }
+
+    SECTION( "Axis attribution" )
+    {
+        float accel = 0.0;
+
+        REQUIRE( chip.GetAccel( ACCEL_Y, accel ) == true );
+        REQUIRE( accel == ProcessAccel( 2000, SENSITIVITY_MODE_3_4 ) );
+        REQUIRE( chip.GetAccel( ACCEL_X, accel ) == true );
+        REQUIRE( accel == ProcessAccel( 1000, SENSITIVITY_MODE_3_4 ) );
+    }
+
+    SECTION( "Five frames per measurement cycle" )
+    {
+        sca3300Sample sample;
+
+        REQUIRE( chip.ReadSample( sample ) == true );
+
+        const uint64_t frames = sim->GetFrameCount();
+
+        REQUIRE( chip.ReadSample( sample ) == true );
+        REQUIRE( sim->GetFrameCount() - frames == 5 );
+
+        REQUIRE( sample.st_Accel[ACCEL_X] == ProcessAccel( 1000, SENSITIVITY_MODE_3_4 ) );
+        REQUIRE( sample.st_Accel[ACCEL_Y] == ProcessAccel( 2000, SENSITIVITY_MODE_3_4 ) );
+        REQUIRE( sample.st_Accel[ACCEL_Z] == ProcessAccel( 5400, SENSITIVITY_MODE_3_4 ) );
+        REQUIRE( sample.st_Temp == ConvertTemperature( 0x15C5 ) );
+        REQUIRE( sample.st_Status == 0x0002 );
+    }
+
+    SECTION( "Fresh answers after a pause" )
+    {
+        float accel = 0.0;
+        sca3300Sample sample;
+
+        REQUIRE( chip.GetAccel( ACCEL_X, accel ) == true );
+
+        // The X request left in flight latched 1000: too old to be reused
+        sim->SetRegister( REG_ACC_X, 3000 );
+        usleep( 2000 );
+
+        const uint64_t frames = sim->GetFrameCount();
+
+        REQUIRE( chip.GetAccel( ACCEL_X, accel ) == true );
+        REQUIRE( accel == ProcessAccel( 3000, SENSITIVITY_MODE_3_4 ) );
+        REQUIRE( sim->GetFrameCount() - frames == 2 );
+
+        // Same for the trailing X frame of a measurement cycle
+        REQUIRE( chip.ReadSample( sample ) == true );
+        sim->SetRegister( REG_ACC_X, -500 );
+        usleep( 2000 );
+
+        REQUIRE( chip.ReadSample( sample ) == true );
+        REQUIRE( sample.st_Accel[ACCEL_X] == ProcessAccel( -500, SENSITIVITY_MODE_3_4 ) );
+        REQUIRE( sample.st_Accel[ACCEL_Y] == ProcessAccel( 2000, SENSITIVITY_MODE_3_4 ) );
+
+        // And for STATUS, read and cleared on the previous call
+        sca3300Status status;
+        chip.GetStatus( status );
+        sim->SetRegister( REG_STATUS, 0x0000 );
+        usleep( 2000 );
+
+        REQUIRE( chip.GetStatus( status ) == true );
+        REQUIRE( status.st_Flags == 0 );
+    }
+
+    SECTION( "Status register" )
+    {
+        sca3300Status status;
+
+        REQUIRE( chip.GetStatus( status ) == false );
+        REQUIRE( status.st_Flags == 0x0002 );
+        REQUIRE( status.st_ResetRequired == 0x0002 );
+
+        // Off-frame: the answer in flight was computed before the change
+        sim->SetRegister( REG_STATUS, 0x0000 );
+        chip.GetStatus( status );
+        REQUIRE( chip.GetStatus( status ) == true );
+        REQUIRE( status.st_Flags == 0 );
+    }
+
+    SECTION( "Invalid return status" )
+    {
+        sca3300Sample sample;
+
+        sim->SetReturnStatus( ST_ERROR );
+        chip.ReadSample( sample );
+        REQUIRE( chip.ReadSample( sample ) == false );
+    }
+}
+
+/**
+ *
+ * Replay of recorded frames
+ *
+ */
+TEST_CASE( "Replay Transport" )
+{
+    const uint8_t RECORDED[] = { 0x05, 0x00, 0xDC, 0x1C,
+                                 0x15, 0x15, 0xFD, 0x4B };
+    const uint8_t TX[8] = { 0 };
+
+    sca3300ReplayTransport replay( RECORDED, 2 );
+    uint8_t rx[12];
+
+    REQUIRE( replay.GetFrameCount() == 2 );
+    REQUIRE( replay.Transfer( TX, rx, 3, 0 ) == true );
+
+    // Recording is looped
+    REQUIRE( memcmp( rx, RECORDED, sizeof(RECORDED) ) == 0 );
+    REQUIRE( memcmp( rx + 8, RECORDED, 4 ) == 0 );
+}
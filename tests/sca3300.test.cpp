@@ -1,6 +1,10 @@
 #include <iostream>
 #include <stdlib.h>     /* srand, rand */
 #include <map>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <cmath>
 
 // Let Catch provide main():
 #define CATCH_CONFIG_MAIN
@@ -87,6 +91,64 @@ TEST_CASE( "Cyclic Redundancy Check" )
     }
 }
 
+/**
+ *
+ * Table driven and batch CRC against a bit by bit reference
+ *
+ */
+TEST_CASE( "Batch Cyclic Redundancy Check" )
+{
+    auto bitwiseCRC = []( const uint32_t aFrame )
+    {
+        uint8_t crc = 0xFF;
+
+        for (uint32_t mask = 0x80000000; mask != 0x80; mask >>= 1)
+        {
+            const bool bit = ( 0 != ( aFrame & mask ) ) ^ ( 0 != ( crc & 0x80 ) );
+
+            crc <<= 1;
+            if (bit)
+                crc ^= 0x1D;
+        }
+
+        return (uint8_t)~crc;
+    };
+
+    SECTION( "Table matches bitwise CRC" )
+    {
+        for (uint32_t msb = 0; msb < 0x1000000; msb += 0x101)
+            REQUIRE( CalculateCRC( msb << 8 ) == bitwiseCRC( msb << 8 ) );
+    }
+
+    SECTION( "Validity bitmap" )
+    {
+        const size_t NB_FRAMES = 150;
+
+        uint8_t  frames[NB_FRAMES][4];
+        uint64_t valid[3] = { 0 };
+
+        srand( 42 );
+        for (size_t i = 0; i < NB_FRAMES; ++i)
+        {
+            const uint32_t frame = ( (uint32_t)rand() << 8 ) & 0xFFFFFF00;
+            const uint8_t  crc   = bitwiseCRC( frame );
+
+            frames[i][0] = frame >> 24;
+            frames[i][1] = frame >> 16;
+            frames[i][2] = frame >> 8;
+            frames[i][3] = ( i % 3 ) ? crc : (uint8_t)( crc ^ 0x01 ); // corrupt one frame out of three
+        }
+
+        REQUIRE( CheckCRCFrames( frames[0], NB_FRAMES, valid ) == NB_FRAMES - 50 );
+
+        for (size_t i = 0; i < NB_FRAMES; ++i)
+        {
+            REQUIRE( ( ( valid[i / 64] >> ( i % 64 ) ) & 1 ) == ( ( i % 3 ) ? 1u : 0u ) );
+            REQUIRE( CheckCRCTrame( frames[i], 4 ) == ( 0 != ( i % 3 ) ) );
+        }
+    }
+}
+
 /**
  *
  * Test Acceleration Data Conversion
@@ -96,18 +158,18 @@ TEST_CASE( "Test Acceleration Data Conversion" )
 {
     const std::map<uint16_t, float> ACCEL_MAP
     { /* Acceleration tested in lab. */
-        { 0xfb00, 11.8992 },
+        { 0xfb00, -0.2370 },
         { 0x1594, 1.0229  },
         { 0x0469, 0.2090  },
         { 0x0852, 0.3944  },
-        { 0xff26, 12.0959 },
+        { 0xff26, -0.0404 },
         { 0x0941, 0.4387  },
-        { 0xfdc7, 12.0309 },
+        { 0xfdc7, -0.1054 },
         { 0x0ab7, 0.5079  },
-        { 0xfdc7, 12.0309 },
+        { 0xfdc7, -0.1054 },
         { 0x0ab7, 0.5079  },
         { 0x1595, 1.0231  },
-        { 0xfdd6, 12.0337 },
+        { 0xfdd6, -0.1026 },
         { 0x0a84, 0.4985  },
     };
 
@@ -118,8 +180,160 @@ TEST_CASE( "Test Acceleration Data Conversion" )
     {
         SECTION( std::string( "Acceleration Tested: " + std::to_string( accel.second )))
         {
-            REQUIRE( fabs(ProcessAccel( accel.first, 5400 ) - accel.second) < epsilon );
+            REQUIRE( fabs(ProcessAccel( (int16_t)accel.first, 5400 ) - accel.second) < epsilon );
             SUCCEED( "Aceleration: " + std::to_string( accel.second ) + " OK" );
         }
     }
 }
+
+/**
+ *
+ * Block conversion kernels, every raw value against the scalar reference
+ *
+ */
+TEST_CASE( "Block Data Conversion" )
+{
+    // Odd count: exercises the scalar tail
+    const size_t NB_VALUES = 65536 + 3;
+
+    std::vector<int16_t>  accelRaw( NB_VALUES );
+    std::vector<uint16_t> tempRaw( NB_VALUES );
+    std::vector<float>    converted( NB_VALUES );
+
+    for (size_t i = 0; i < NB_VALUES; ++i)
+    {
+        accelRaw[i] = (int16_t)( i & 0xFFFF );
+        tempRaw[i]  = (uint16_t)( i & 0xFFFF );
+    }
+
+    /* Distance in ULP between two floats of the same sign */
+    auto ulps = []( const float a, const float b )
+    {
+        int32_t ia, ib;
+        memcpy( &ia, &a, sizeof(ia) );
+        memcpy( &ib, &b, sizeof(ib) );
+
+        return std::abs( (int64_t)ia - ib );
+    };
+
+    for (const int sensivity : { SENSITIVITY_MODE_1, SENSITIVITY_MODE_2, SENSITIVITY_MODE_3_4 })
+    {
+        SECTION( "Acceleration, sensitivity " + std::to_string( sensivity ) )
+        {
+            ConvertAccelBlock( accelRaw.data(), converted.data(), NB_VALUES, sensivity );
+
+            int64_t worst = 0;
+            for (size_t i = 0; i < NB_VALUES; ++i)
+                worst = std::max( worst, ulps( converted[i], ProcessAccel( accelRaw[i], sensivity ) ) );
+
+            REQUIRE( worst <= 1 );
+            REQUIRE( converted[0xfb00] == Approx( -1280.0 / sensivity ) );
+        }
+    }
+
+    SECTION( "Temperature" )
+    {
+        ConvertTempBlock( tempRaw.data(), converted.data(), NB_VALUES );
+
+        for (size_t i = 0; i < NB_VALUES; ++i)
+        {
+            const float reference = (float)( TEMP_ABSOLUTE_ZERO + tempRaw[i] / TEMP_SIGNAL_SENSITIVITY );
+
+            REQUIRE( std::fabs( converted[i] - reference ) < 0.001f );
+            REQUIRE( ( roundf( converted[i] * 100 ) / 100 ) == ConvertTemperature( tempRaw[i] ) );
+        }
+    }
+}
+
+/**
+ *
+ * Fixed-point conversions, every raw value against the exact rounded value
+ *
+ */
+TEST_CASE( "Fixed-point Data Conversion" )
+{
+    for (const operationMode mode : { OPMODE1, OPMODE2, OPMODE3, OPMODE4 })
+    {
+        SECTION( "Milli-g, mode " + std::to_string( mode ) )
+        {
+            const sca3300Scale scale = GetModeScale( mode );
+
+            REQUIRE( scale.st_Sensitivity == sca3300::GetModeSensitivity( mode ) );
+            REQUIRE( scale.st_GPerLsb == 1.0f / scale.st_Sensitivity );
+
+            for (int raw = INT16_MIN; raw <= INT16_MAX; ++raw)
+                REQUIRE( AccelToMilliG( (int16_t)raw, scale ) == lround( raw * 1000.0 / scale.st_Sensitivity ) );
+        }
+    }
+
+    SECTION( "Centi-degrees" )
+    {
+        for (int raw = 0; raw <= UINT16_MAX; ++raw)
+            REQUIRE( TempToCentiDeg( (uint16_t)raw ) == lround( ( TEMP_ABSOLUTE_ZERO + raw / TEMP_SIGNAL_SENSITIVITY ) * 100 ) );
+    }
+}
+
+/**
+ *
+ * Inter-frame gap scheduler
+ *
+ */
+TEST_CASE( "Inter-frame Gap Scheduler" )
+{
+    const int64_t GAPS_NS[] = { 0, 10000, 50000, 200000, 1000000 };
+
+    for (auto const gap : GAPS_NS)
+    {
+        SECTION( std::string( "Gap Tested: " + std::to_string( gap ) + " ns" ))
+        {
+            const int64_t deadline = GetMonotonicNs() + gap;
+            WaitUntilNs( deadline );
+            REQUIRE( GetMonotonicNs() >= deadline );
+        }
+    }
+}
+
+/**
+ *
+ * Status register decoding
+ *
+ */
+TEST_CASE( "Status Decoding" )
+{
+    static_assert( DecodeStatus( 0x0000 ).st_Flags == 0, "no flag" );
+    static_assert( DecodeStatus( 0x0002 ).st_ResetRequired == 0x0002, "mode change needs a reset" );
+
+    for (int bit = 0; bit < 16; ++bit)
+    {
+        SECTION( std::string( "Status bit: " + std::to_string( bit ) ))
+        {
+            const sca3300Status status = DecodeStatus( 1 << bit );
+
+            if ( bit <= SCA3300_ERR_DIGI1_BIT )
+            {
+                REQUIRE( status.st_Flags == ( 1 << bit ) );
+                REQUIRE( GetStatusFlagDescription( bit ) != NULL );
+                REQUIRE( ( status.st_ResetRequired != 0 ) == SCA3300_ERRORS[bit].resetRequired );
+            }
+            else
+            {
+                REQUIRE( status.st_Flags == 0 );
+                REQUIRE( GetStatusFlagDescription( bit ) == NULL );
+            }
+        }
+    }
+
+    SECTION( "Several flags" )
+    {
+        const sca3300Status status = DecodeStatus( 0x0041 | 0x0080 );
+
+        REQUIRE( status.st_Flags == 0x00C1 );
+        REQUIRE( status.st_ResetRequired == 0x0080 );
+    }
+
+    SECTION( "Return status" )
+    {
+        REQUIRE( std::string( GetReturnStatusDescription( ST_NORMAL_OP ) ) == "Normal operation, no flag" );
+        REQUIRE( std::string( GetReturnStatusDescription( ST_ERROR ) ) == "Error" );
+    }
+}